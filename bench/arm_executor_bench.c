@@ -0,0 +1,148 @@
+// Drives the arm executor the way the console does, on the simulated arm: the built-in search
+// plays White, and every new principal variation pre-positions the arm over the likely piece
+// (arm_executor_prepare) before the move is played (arm_executor_move); Black answers with random
+// legal moves. Every Nth search is abandoned as if the engine had timed out, which must park the
+// arm. Reports prepares, replacements, camera-view transitions and time spent in view.
+//
+// Usage: arm_executor_bench [arm.cfg] [games] [movetime ms] [time scale] [abandon every N searches]
+#include "arm/arm_executor.h"
+#include "engine/search.h"
+#include "game/game_logic.h"
+#include <time.h>
+
+#define BENCH_MAX_PLIES 120
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Written by the executor thread through on_view; read once arm_executor_wait has returned
+typedef struct {
+    bool in_view;
+    double entered_s;
+    double in_view_s;
+    long transitions;
+} view_stats_t;
+
+static void count_view(void *context, bool in_view) {
+    view_stats_t *view = context;
+    double now = now_seconds();
+    if (in_view) view->entered_s = now;
+    else view->in_view_s += now - view->entered_s;
+    view->in_view = in_view;
+    view->transitions++;
+}
+
+typedef struct {
+    arm_executor_t *arm;
+    const game_t *game;
+    char last_pv_move[8];
+    long prepares_requested;
+} search_follow_t;
+
+// The console follows the UCI "info ... pv" lines; the built-in search reports each iteration
+static void follow_search(const search_result_t *result, void *context) {
+    search_follow_t *follow = context;
+    if (strcmp(result->best_move, follow->last_pv_move) == 0) return;
+    snprintf(follow->last_pv_move, sizeof(follow->last_pv_move), "%s", result->best_move);
+    const move_t *likely = find_game_move(follow->game, result->best_move);
+    if (likely && arm_executor_prepare(follow->arm, likely)) follow->prepares_requested++;
+}
+
+int main(int argc, char **argv) {
+    const char *config_path = argc > 1 ? argv[1] : "../config/arm.cfg";
+    int games = argc > 2 ? atoi(argv[2]) : 4;
+    int movetime_ms = argc > 3 ? atoi(argv[3]) : 100;
+    double time_scale = argc > 4 ? atof(argv[4]) : 0.05;
+    int abandon_every = argc > 5 ? atoi(argv[5]) : 15;
+    if (games <= 0 || movetime_ms <= 0 || time_scale < 0 || abandon_every < 0) {
+        fprintf(stderr, "Usage: %s [arm.cfg] [games] [movetime ms] [time scale] [abandon every N searches, 0: never]\n", argv[0]);
+        return 2;
+    }
+
+    view_stats_t view;
+    memset(&view, 0, sizeof(view));
+    arm_sim_rig_t *rig = malloc(sizeof(arm_sim_rig_t));
+    search_engine_t *engine = malloc(sizeof(search_engine_t));
+    game_t *game = malloc(sizeof(game_t));
+    if (!rig || !engine || !game || !init_search_engine(engine, SEARCH_DEFAULT_HASH_MB)) return 1;
+    if (!start_sim_arm(rig, config_path, time_scale, count_view, &view)) return 2;
+
+    search_limits_t limits;
+    memset(&limits, 0, sizeof(limits));
+    limits.movetime_ms = movetime_ms;
+    search_follow_t follow;
+    memset(&follow, 0, sizeof(follow));
+    follow.arm = &rig->executor;
+    follow.game = game;
+    uint64_t seed = 1;
+    long searches = 0, abandoned = 0, left_in_view = 0, engine_moves = 0, rejected = 0;
+    double t0 = now_seconds();
+
+    for (int g = 0; g < games; g++) {
+        init_game(game, NULL, 0);
+        clear_search_engine(engine);
+        for (int ply = 0; ply < BENCH_MAX_PLIES && game->result == RESULT_ONGOING; ply++) {
+            if (game->chess.turn == BLACK) {
+                const move_t *move = &game->legal_moves[next_random(&seed) % (uint64_t)game->n_legal_moves];
+                char notation[8];
+                snprintf(notation, sizeof(notation), "%s", move->notation);
+                play_game_move(game, notation, 0);
+                continue;
+            }
+            follow.last_pv_move[0] = '\0';
+            search_set_position(engine, &game->chess);
+            search_result_t result;
+            search_best_move(engine, &limits, follow_search, NULL, &follow, &result);
+            searches++;
+            if (abandon_every > 0 && searches % abandon_every == 0) {
+                // The console's timeout path: the game is resigned and the arm must leave the view
+                abandoned++;
+                arm_executor_park(&rig->executor);
+                arm_executor_wait(&rig->executor);
+                if (view.in_view) left_in_view++;
+                resign_game(game, WHITE);
+                break;
+            }
+            if (play_game_move(game, result.best_move, 0) != MOVE_SUCCESS) {
+                fprintf(stderr, "Error: Search move %s is illegal\n", result.best_move);
+                return 1;
+            }
+            engine_moves++;
+            // The opponent answers once the arm has played the move and parked out of view
+            if (!arm_executor_move(&rig->executor, &game->chess.move_history[game->chess.move_count - 1])) rejected++;
+            arm_executor_wait(&rig->executor);
+            if (view.in_view) left_in_view++;
+        }
+    }
+    double elapsed = now_seconds() - t0;
+    const arm_executor_t *arm = &rig->executor;
+
+    printf("games:              %d, %ld engine moves, %.1f s\n", games, engine_moves, elapsed);
+    printf("searches:           %ld, %ld abandoned\n", searches, abandoned);
+    printf("prepares:           %ld requested, %ld executed, %ld replaced before the arm got to them\n",
+           follow.prepares_requested, arm->prepares, arm->prepares_replaced);
+    printf("arm moves:          %ld, %ld rejected, %ld parks after abandoned searches, %ld failures\n", arm->moves,
+           rejected, arm->parks, arm->failures);
+    printf("view transitions:   %ld (%ld seen by on_view)\n", arm->view_changes, view.transitions);
+    printf("in view:            %.2f s wall, %.1f s simulated motion at time scale %.2f\n", view.in_view_s,
+           rig->sim.busy_s, time_scale);
+    printf("left in view:       %ld\n", left_in_view);
+
+    bool ok = left_in_view == 0 && rejected == 0 && arm->failures == 0;
+    stop_sim_arm(rig);
+    free_search_engine(engine);
+    free(game);
+    free(engine);
+    free(rig);
+    return ok ? 0 : 1;
+}
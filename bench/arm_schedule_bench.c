@@ -0,0 +1,112 @@
+// Replays games through the move converter and the motion scheduler, and reports the estimated
+// arm time per move before and after scheduling against the simulated execution time.
+//
+// Usage: arm_schedule_bench <arm.cfg> <moves.txt>...
+//
+// A moves file holds the UCI moves of one game from the initial position, whitespace separated.
+#include "arm/arm_kinematics.h"
+#include "arm/motion_scheduler.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+#include <math.h>
+#include <time.h>
+
+typedef struct {
+    long moves;
+    long multi_transfer;        // captures, castling and promotions
+    long improved;              // moves the scheduler made faster than the converter's plan
+    double baseline_s;
+    double estimated_s;
+    double simulated_s;
+    double estimate_error;      // sum of |estimated - simulated| / simulated
+    double schedule_s;          // wall time spent scheduling and simulating
+} schedule_stats_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool replay_game(const char *path, const arm_scheduler_t *scheduler, chess_state_t *chess, schedule_stats_t *stats) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open %s\n", path);
+        return false;
+    }
+    init_chess_board(chess);
+    move_converter_t converter;
+    init_move_converter(&converter);
+    int at = -1;
+    char uci[16];
+    bool ok = true;
+    while (ok && fscanf(file, "%15s", uci) == 1) {
+        if (make_move(chess, uci) != MOVE_SUCCESS) {
+            fprintf(stderr, "Error: Illegal move %s in %s\n", uci, path);
+            ok = false;
+            break;
+        }
+        const move_t *move = &chess->move_history[chess->move_count - 1];
+        arm_schedule_t schedule;
+        double start = now_seconds();
+        if (!schedule_arm_move(scheduler, &converter, move, at, &schedule)) {
+            fprintf(stderr, "Error: Could not schedule %s in %s\n", uci, path);
+            ok = false;
+            break;
+        }
+        stats->schedule_s += now_seconds() - start;
+        stats->moves++;
+        if (schedule.plan.n_actions > 2) stats->multi_transfer++;
+        if (schedule.estimated_s < schedule.baseline_s - 1e-6) stats->improved++;
+        stats->baseline_s += schedule.baseline_s;
+        stats->estimated_s += schedule.estimated_s;
+        stats->simulated_s += schedule.simulated_s;
+        if (schedule.simulated_s > 0)
+            stats->estimate_error += fabs(schedule.estimated_s - schedule.simulated_s) / schedule.simulated_s;
+        at = schedule.end_location;
+    }
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <arm.cfg> <moves.txt>...\n", argv[0]);
+        return 2;
+    }
+    arm_config_t config;
+    if (!load_arm_config(argv[1], &config)) return 2;
+    arm_kinematics_t *kinematics = malloc(sizeof(arm_kinematics_t));
+    trajectory_cache_t *cache = malloc(sizeof(trajectory_cache_t));
+    arm_scheduler_t *scheduler = malloc(sizeof(arm_scheduler_t));
+    chess_state_t *chess = malloc(sizeof(chess_state_t));
+    if (!kinematics || !cache || !scheduler || !chess) return 2;
+    init_trajectory_cache(cache);
+    if (!init_arm_kinematics(kinematics, &config) ||
+        !build_trajectory_cache(cache, config.n_joints, arm_table_pose_solver, kinematics)) return 1;
+    double start = now_seconds();
+    if (!init_arm_scheduler(scheduler, &config, cache)) return 1;
+    double matrix_ms = (now_seconds() - start) * 1000.0;
+
+    schedule_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 2; i < argc; i++)
+        if (!replay_game(argv[i], scheduler, chess, &stats)) return 2;
+
+    long moves = stats.moves > 0 ? stats.moves : 1;
+    printf("games:                    %d\n", argc - 2);
+    printf("moves:                    %ld (%ld with several transfers, %ld improved)\n",
+           stats.moves, stats.multi_transfer, stats.improved);
+    printf("cost matrix (ms):         %.2f\n", matrix_ms);
+    printf("converter order (s/move): %.3f estimated\n", stats.baseline_s / moves);
+    printf("scheduled (s/move):       %.3f estimated, %.3f simulated\n", stats.estimated_s / moves, stats.simulated_s / moves);
+    printf("estimate error:           %.1f%%\n", 100.0 * stats.estimate_error / moves);
+    printf("schedule + simulate (ms): %.3f per move\n", stats.schedule_s * 1000.0 / moves);
+
+    free_trajectory_cache(cache);
+    free(chess);
+    free(scheduler);
+    free(cache);
+    free(kinematics);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Steady-state detector benchmark and heap-allocation check.
+// Usage: detector_bench [prev_image] [curr_image] [frames]
+// Exits non-zero if the per-frame detector path allocates after warm-up.
+#include "vision/move_detector.h"
+#include "game/chess_state.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+// Count every heap allocation, including OpenCV's aligned buffers, by interposing glibc's allocator
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+
+static atomic<long> allocation_count(0);
+
+extern "C" void* malloc(size_t size){
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size){
+    allocation_count++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size){
+    allocation_count++;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size){
+    allocation_count++;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size){
+    allocation_count++;
+    return __libc_memalign(alignment, size);
+}
+
+int main(int argc, char** argv){
+    string prev_path = argc > 1 ? argv[1] : "../reference_image/previous_w.png";
+    string curr_path = argc > 2 ? argv[2] : "../reference_image/current_w.png";
+    int frames = argc > 3 ? atoi(argv[3]) : 1000;
+    const int WARMUP = 10;
+
+    Mat prev_image = imread(prev_path);
+    Mat curr_image = imread(curr_path);
+    if (prev_image.empty() || curr_image.empty()){
+        cerr << "Error: Could not open or find the images!" << endl;
+        return 2;
+    }
+    Mat prev_board, curr_board;
+    resize(prev_image, prev_board, Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+    resize(curr_image, curr_board, Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+
+    chess_state_t* chess = (chess_state_t*)malloc(sizeof(chess_state_t));
+    init_chess_board(chess);
+    move_detector_context ctx;
+    init_move_detector(ctx);
+    set_move_detector_reference(ctx, prev_board);
+
+    square_info from_square, to_square;
+    legal_move_match match;
+    for (int i = 0; i < WARMUP; i++){
+        detect_move_squares(ctx, curr_board, from_square, to_square);
+        detect_legal_move(ctx, chess, curr_board, match);
+    }
+
+    detector_timings total = {0, 0, 0};
+    long allocations_before = allocation_count.load();
+    int64_t start = getTickCount();
+    for (int i = 0; i < frames; i++){
+        detect_move_squares(ctx, curr_board, from_square, to_square);
+        total.preprocess_ms += ctx.timings.preprocess_ms;
+        total.diff_ms += ctx.timings.diff_ms;
+        total.decide_ms += ctx.timings.decide_ms;
+        detect_legal_move(ctx, chess, curr_board, match);
+    }
+    double elapsed_s = (getTickCount() - start) / getTickFrequency();
+    // A static board: every square's signature matches the reference, so nothing is re-analysed
+    int64_t idle_start = getTickCount();
+    for (int i = 0; i < frames; i++) detect_legal_move(ctx, chess, prev_board, match);
+    double idle_s = (getTickCount() - idle_start) / getTickFrequency();
+    long allocations = allocation_count.load() - allocations_before;
+
+    cout << "frames:            " << frames << endl;
+    cout << "preprocess (ms):   " << total.preprocess_ms / frames << endl;
+    cout << "diff (ms):         " << total.diff_ms / frames << endl;
+    cout << "decide top-2 (ms): " << total.decide_ms / frames << endl;
+    cout << "frames/second:     " << frames / elapsed_s << " (top-2 + legal decode per frame)" << endl;
+    cout << "idle frame (ms):   " << idle_s * 1000.0 / frames << " (static board, signature only)" << endl;
+    cout << "heap allocations:  " << allocations << " after " << WARMUP << " warm-up frames" << endl;
+    free(chess);
+    return allocations == 0 ? 0 : 1;
+}
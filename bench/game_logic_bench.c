@@ -0,0 +1,133 @@
+// Hosts many concurrent games in one process through the game-logic module and reports games and
+// moves per second. Each thread interleaves a table of games one move at a time, the way a server
+// would; moves are random legal moves and think times are random, on a simulated clock, so
+// flag falls are adjudicated as well as the over-the-board endings.
+//
+// Usage: game_logic_bench [games] [threads] [tables per thread] [initial seconds] [increment seconds]
+#include "game/game_logic.h"
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_BENCH_THREADS 64
+
+typedef struct {
+    int games;                  // to play on this thread
+    int tables;                 // games hosted at once
+    time_control_t time_control;
+    uint64_t seed;
+    long moves;
+    long terminations[TERMINATION_MOVE_LIMIT + 1];
+    long results[RESULT_DRAW + 1];
+} bench_thread_t;
+
+typedef struct {
+    game_t game;
+    int64_t now_ms;             // simulated time of this game
+} bench_table_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void *run_thread(void *arg) {
+    bench_thread_t *thread = (bench_thread_t *)arg;
+    bench_table_t *tables = malloc(sizeof(bench_table_t) * thread->tables);
+    if (!tables) return NULL;
+    uint64_t rng = thread->seed;
+    int started = 0;
+    int active = 0;
+    for (int t = 0; t < thread->tables && started < thread->games; t++, started++, active++) {
+        tables[t].now_ms = 0;
+        init_game(&tables[t].game, &thread->time_control, 0);
+    }
+    while (active > 0) {
+        for (int t = 0; t < active; t++) {
+            bench_table_t *table = &tables[t];
+            game_t *game = &table->game;
+            if (game->result == RESULT_ONGOING) {
+                // Think time averages a little more than the increment, so long games run out of time
+                int64_t spread = 2 * game->time_control.increment_ms + game->time_control.initial_ms / 100 + 1;
+                table->now_ms += (int64_t)(next_random(&rng) % (uint64_t)spread);
+                const move_t *move = &game->legal_moves[next_random(&rng) % (uint64_t)game->n_legal_moves];
+                if (play_game_move(game, move->notation, table->now_ms) == MOVE_SUCCESS) thread->moves++;
+                continue;
+            }
+            thread->terminations[game->termination]++;
+            thread->results[game->result]++;
+            if (started < thread->games) {
+                table->now_ms = 0;
+                init_game(game, &thread->time_control, 0);
+                started++;
+            } else {
+                // Retire the table; the last active one takes its place
+                tables[t--] = tables[--active];
+            }
+        }
+    }
+    free(tables);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int games = argc > 1 ? atoi(argv[1]) : 10000;
+    int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int tables = argc > 3 ? atoi(argv[3]) : 64;
+    double initial_s = argc > 4 ? atof(argv[4]) : 180.0;
+    double increment_s = argc > 5 ? atof(argv[5]) : 2.0;
+    if (games <= 0 || tables <= 0) {
+        fprintf(stderr, "Usage: %s [games] [threads] [tables per thread] [initial seconds] [increment seconds]\n", argv[0]);
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_BENCH_THREADS) threads = MAX_BENCH_THREADS;
+
+    bench_thread_t workers[MAX_BENCH_THREADS];
+    pthread_t ids[MAX_BENCH_THREADS];
+    memset(workers, 0, sizeof(workers));
+    double start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        workers[i].games = games / threads + (i < games % threads ? 1 : 0);
+        workers[i].tables = tables;
+        workers[i].time_control.initial_ms = (int64_t)(initial_s * 1000.0);
+        workers[i].time_control.increment_ms = (int64_t)(increment_s * 1000.0);
+        workers[i].seed = 0x5eed + (uint64_t)i;
+        if (pthread_create(&ids[i], NULL, run_thread, &workers[i]) != 0) {
+            fprintf(stderr, "Error: Could not start bench thread %d\n", i);
+            return 1;
+        }
+    }
+    long moves = 0;
+    long terminations[TERMINATION_MOVE_LIMIT + 1] = {0};
+    long results[RESULT_DRAW + 1] = {0};
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+        moves += workers[i].moves;
+        for (int k = 0; k <= TERMINATION_MOVE_LIMIT; k++) terminations[k] += workers[i].terminations[k];
+        for (int k = 0; k <= RESULT_DRAW; k++) results[k] += workers[i].results[k];
+    }
+    double elapsed = now_seconds() - start;
+    long finished = results[RESULT_WHITE_WINS] + results[RESULT_BLACK_WINS] + results[RESULT_DRAW];
+
+    printf("threads:            %d (%d games hosted at once per thread, %zu bytes each)\n", threads, tables, sizeof(game_t));
+    printf("games:              %ld in %.2f s\n", finished, elapsed);
+    printf("games/second:       %.0f\n", elapsed > 0 ? finished / elapsed : 0.0);
+    printf("moves/second:       %.0f (%.1f moves/game)\n", elapsed > 0 ? moves / elapsed : 0.0,
+           finished > 0 ? (double)moves / finished : 0.0);
+    printf("results:            %ld %s, %ld %s, %ld %s\n",
+           results[RESULT_WHITE_WINS], game_result_string(RESULT_WHITE_WINS),
+           results[RESULT_BLACK_WINS], game_result_string(RESULT_BLACK_WINS),
+           results[RESULT_DRAW], game_result_string(RESULT_DRAW));
+    for (int k = TERMINATION_CHECKMATE; k <= TERMINATION_MOVE_LIMIT; k++) {
+        if (terminations[k] > 0) printf("  %-22s %ld\n", game_termination_string((game_termination_t)k), terminations[k]);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Measures inverse-kinematics throughput and convergence, cold-started from the home pose and
+// warm-started from the precomputed pose table.
+//
+// Usage: ik_bench <arm.cfg> [solves]
+//
+// Targets are drawn uniformly over the board at heights between grasp and travel.
+#include "arm/arm_kinematics.h"
+#include "arm/trajectory_cache.h"
+#include <math.h>
+#include <time.h>
+
+typedef struct {
+    long solves;
+    long converged;
+    long iterations;
+    double max_position_error;
+    double seconds;
+} ik_stats_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void random_target(const arm_config_t *config, double target[3]) {
+    double u = rand() / (double)RAND_MAX;
+    double v = rand() / (double)RAND_MAX;
+    double w = rand() / (double)RAND_MAX;
+    // Anywhere on the board, edge squares included, up to travel height
+    u = u * 8.0 / 7.0 - 0.5 / 7.0;
+    v = v * 8.0 / 7.0 - 0.5 / 7.0;
+    for (int k = 0; k < 3; k++)
+        target[k] = config->board[0][k] + u * (config->board[1][k] - config->board[0][k]) +
+                    v * (config->board[2][k] - config->board[0][k]);
+    target[2] += config->heights[ARM_HEIGHT_GRASP] +
+                 w * (config->heights[ARM_HEIGHT_TRAVEL] - config->heights[ARM_HEIGHT_GRASP]);
+}
+
+static void run_solves(const arm_kinematics_t *kinematics, const double *targets, long n, bool warm, ik_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    double q[ARM_MAX_JOINTS];
+    double start = now_seconds();
+    for (long i = 0; i < n; i++) {
+        ik_result_t result;
+        if (warm) arm_solve_ik_warm(kinematics, &targets[3 * i], q, &result);
+        else arm_solve_ik(&kinematics->config, &targets[3 * i], kinematics->config.home, q, &result);
+        stats->solves++;
+        stats->iterations += result.iterations;
+        if (result.converged) stats->converged++;
+        if (result.position_error > stats->max_position_error) stats->max_position_error = result.position_error;
+    }
+    stats->seconds = now_seconds() - start;
+}
+
+static void print_stats(const char *name, const ik_stats_t *stats) {
+    long solves = stats->solves > 0 ? stats->solves : 1;
+    printf("%-6s solves/second: %10.0f   converged: %5.1f%%   iterations/solve: %5.1f   max error: %.3f mm\n",
+           name, stats->seconds > 0 ? stats->solves / stats->seconds : 0.0,
+           100.0 * stats->converged / solves, (double)stats->iterations / solves,
+           stats->max_position_error * 1000.0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <arm.cfg> [solves]\n", argv[0]);
+        return 2;
+    }
+    long n = argc > 2 ? atol(argv[2]) : 100000;
+    if (n < 1) n = 1;
+
+    arm_config_t config;
+    if (!load_arm_config(argv[1], &config)) return 2;
+    arm_kinematics_t *kinematics = malloc(sizeof(arm_kinematics_t));
+    double *targets = malloc(sizeof(double) * 3 * n);
+    if (!kinematics || !targets) return 2;
+    if (!init_arm_kinematics(kinematics, &config)) return 1;
+
+    trajectory_cache_t *cache = malloc(sizeof(trajectory_cache_t));
+    if (!cache) return 2;
+    init_trajectory_cache(cache);
+    double start = now_seconds();
+    bool cached = build_trajectory_cache(cache, config.n_joints, arm_table_pose_solver, kinematics);
+    double cache_ms = (now_seconds() - start) * 1000.0;
+
+    srand(1);
+    for (long i = 0; i < n; i++) random_target(&config, &targets[3 * i]);
+    ik_stats_t cold, warm;
+    run_solves(kinematics, targets, n, false, &cold);
+    run_solves(kinematics, targets, n, true, &warm);
+
+    printf("joints:                 %d\n", config.n_joints);
+    printf("pose table:             %d entries, %zu bytes\n", ARM_LOCATIONS * (ARM_HEIGHT_TRAVEL + 1),
+           sizeof(kinematics->poses));
+    printf("table build (ms):       %.2f (%.1f iterations/entry)\n", kinematics->build_ms,
+           (double)kinematics->build_iterations / (ARM_LOCATIONS * (ARM_HEIGHT_TRAVEL + 1)));
+    printf("trajectory cache (ms):  %.2f%s\n", cache_ms, cached ? "" : " (failed)");
+    printf("random targets:         %ld\n", n);
+    print_stats("cold", &cold);
+    print_stats("warm", &warm);
+
+    free_trajectory_cache(cache);
+    free(cache);
+    free(targets);
+    free(kinematics);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Journals many concurrent games and resumes them. Each round hosts a table of random games, stops
+// some of them mid-game as a crash would, flushes the journal, then resumes every game from its
+// file and checks it against the game in memory. Reports what journaling adds to each move, the
+// writer's records and syncs per second, and resume time per game.
+//
+// Usage: journal_bench [journal dir] [rounds] [games per round] [sync interval ms]
+#include "game/game_journal.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include <time.h>
+
+#define MAX_LATENCIES 1000000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static bool same_game(const game_t *a, const game_t *b) {
+    char fen_a[128], fen_b[128];
+    chess_state_to_fen(&a->chess, fen_a, sizeof(fen_a));
+    chess_state_to_fen(&b->chess, fen_b, sizeof(fen_b));
+    if (strcmp(fen_a, fen_b) != 0 || a->chess.move_count != b->chess.move_count) return false;
+    if (a->result != b->result || a->termination != b->termination || a->n_legal_moves != b->n_legal_moves) return false;
+    if (a->remaining_ms[0] != b->remaining_ms[0] || a->remaining_ms[1] != b->remaining_ms[1]) return false;
+    for (int i = 0; i < a->chess.move_count; i++) {
+        if (strcmp(a->chess.move_history[i].notation, b->chess.move_history[i].notation) != 0) return false;
+    }
+    for (int i = 0; i <= a->chess.move_count; i++) {
+        if (a->position_keys[i] != b->position_keys[i]) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp/journal_bench";
+    int rounds = argc > 2 ? atoi(argv[2]) : 10;
+    int tables = argc > 3 ? atoi(argv[3]) : 64;
+    int sync_interval_ms = argc > 4 ? atoi(argv[4]) : 10;
+    if (rounds <= 0 || tables <= 0 || tables > JOURNAL_MAX_GAMES) {
+        fprintf(stderr, "Usage: %s [journal dir] [rounds] [games per round, at most %d] [sync interval ms]\n",
+                argv[0], JOURNAL_MAX_GAMES);
+        return 2;
+    }
+
+    game_journal_t *journal = malloc(sizeof(game_journal_t));
+    game_t *games = malloc(sizeof(game_t) * (size_t)tables);
+    int *crash_plies = malloc(sizeof(int) * (size_t)tables);
+    int64_t *clocks = malloc(sizeof(int64_t) * (size_t)tables);
+    game_t *resumed = malloc(sizeof(game_t));
+    double *latencies = malloc(sizeof(double) * MAX_LATENCIES);
+    if (!journal || !games || !crash_plies || !clocks || !resumed || !latencies) return 1;
+    if (!open_game_journal(journal, dir, sync_interval_ms)) return 1;
+
+    time_control_t time_control = {180000, 2000};
+    uint64_t rng = 0x5eed;
+    long moves = 0;
+    long samples = 0;
+    long resumed_games = 0;
+    long mismatches = 0;
+    double move_s = 0.0;
+    double journal_s = 0.0;
+    double resume_s = 0.0;
+    double resume_max_s = 0.0;
+    double start = now_seconds();
+    for (int round = 0; round < rounds; round++) {
+        for (int t = 0; t < tables; t++) {
+            clocks[t] = 0;
+            init_game(&games[t], &time_control, 0);
+            // Half of the games are cut off at a random ply, the rest play to the end
+            crash_plies[t] = (t % 2) ? 1 + (int)(next_random(&rng) % 300) : MAX_MOVES;
+            journal_start_game(journal, t, &games[t]);
+        }
+        int active = tables;
+        while (active > 0) {
+            active = 0;
+            for (int t = 0; t < tables; t++) {
+                game_t *game = &games[t];
+                if (game->result != RESULT_ONGOING || game->chess.move_count >= crash_plies[t]) continue;
+                active++;
+                // Simulated think time, a little more than the increment on average
+                clocks[t] += (int64_t)(next_random(&rng) % 5800);
+                const move_t *move = &game->legal_moves[next_random(&rng) % (uint64_t)game->n_legal_moves];
+                double t0 = now_seconds();
+                play_game_move(game, move->notation, clocks[t]);
+                double t1 = now_seconds();
+                journal_update_game(journal, t, game);
+                double t2 = now_seconds();
+                move_s += t1 - t0;
+                journal_s += t2 - t1;
+                if (samples < MAX_LATENCIES) latencies[samples++] = (t2 - t1) * 1e6;
+                moves++;
+            }
+        }
+        // Games left behind by a full queue catch up, as the server does between requests
+        do {
+            flush_game_journal(journal);
+            for (int t = 0; t < tables; t++)
+                if (journal->games[t].behind) journal_update_game(journal, t, &games[t]);
+        } while (journal->games_behind > 0);
+        flush_game_journal(journal);
+        for (int t = 0; t < tables; t++) {
+            double t0 = now_seconds();
+            bool ok = journal_resume_game(journal, t, resumed, 0);
+            double elapsed = now_seconds() - t0;
+            resume_s += elapsed;
+            if (elapsed > resume_max_s) resume_max_s = elapsed;
+            resumed_games++;
+            // The resumed clock restarts at now_ms, so compare against the game's stored clocks
+            if (!ok || !same_game(&games[t], resumed)) mismatches++;
+            journal_close_game(journal, t, true);
+        }
+    }
+    double elapsed = now_seconds() - start;
+    close_game_journal(journal);
+    qsort(latencies, (size_t)samples, sizeof(double), compare_doubles);
+
+    printf("games:              %ld (%d at once, half stopped mid-game)\n", resumed_games, tables);
+    printf("moves:              %ld in %.2f s\n", moves, elapsed);
+    printf("move path:          %.2f us/move game logic, %.2f us/move journal\n",
+           moves > 0 ? move_s * 1e6 / moves : 0.0, moves > 0 ? journal_s * 1e6 / moves : 0.0);
+    if (samples > 0) {
+        printf("journal us/move:    p50 %.2f, p99 %.2f, max %.1f\n", latencies[samples / 2],
+               latencies[(long)(samples * 0.99)], latencies[samples - 1]);
+    }
+    printf("writer:             %ld records, %ld syncs (%.0f records/s)\n",
+           journal->records, journal->syncs, elapsed > 0 ? journal->records / elapsed : 0.0);
+    printf("full queue:         %ld records left for a catch-up, %ld closes waited\n", journal->overflows,
+           journal->stalls);
+    printf("resume:             %.3f ms/game average, %.3f ms max, %ld mismatches\n",
+           resumed_games > 0 ? resume_s * 1000.0 / resumed_games : 0.0, resume_max_s * 1000.0, mismatches);
+    free(latencies);
+    free(resumed);
+    free(clocks);
+    free(crash_plies);
+    free(games);
+    free(journal);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Several boards in one camera view, with no camera: every board plays its own random game,
+// rendered top-down by the synthetic board renderer and projected into a shared frame through
+// the inverse of its calibrated pose. A hand passes over each board while its move is made, then
+// the view is held still. Reports per-board move accuracy and the time to process a frame.
+//
+// Usage: multi_board_bench [calibration.yml] [plies per board] [seed]
+#include "vision/board_detector.h"
+#include "vision/board_renderer.h"
+#include "vision/multi_board_vision.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+#define FRAME_WIDTH 1280
+#define FRAME_HEIGHT 720
+#define HAND_FRAMES 2       // frames with a hand over the board while a piece is moved
+#define HOLD_FRAMES 12      // still frames after a move: enough for the gate to settle and 3 of 5 votes
+
+// One board's ground truth and what the vision reported for it
+struct bench_board {
+    Mat to_frame;               // rectified board pixel -> camera pixel
+    Point2f centre;             // in the frame, where the hand goes
+    chess_state_t chess;
+    bool over;
+    long played;
+    long correct;
+    long committed;
+    string last_committed;      // written by the worker processing this board only
+};
+
+// Inverse of the calibrated pose, scaled from normalised board coordinates to board pixels
+static Mat board_to_frame(const board_calibration& calib){
+    Mat scale = Mat::eye(3, 3, CV_64F);
+    scale.at<double>(0, 0) = 1.0 / VISION_BOARD_PIXELS;
+    scale.at<double>(1, 1) = 1.0 / VISION_BOARD_PIXELS;
+    return calib.homography.inv() * scale;
+}
+
+static void compose_frame(board_renderer& renderer, vector<bench_board>& boards, Mat& board, Mat& frame){
+    frame.create(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3);
+    frame.setTo(Scalar(70, 80, 90));
+    for (bench_board& b : boards){
+        render_board(renderer, &b.chess, board);
+        warpPerspective(board, frame, b.to_frame, frame.size(), INTER_LINEAR, BORDER_TRANSPARENT);
+    }
+}
+
+int main(int argc, char** argv){
+    string calib_path = argc > 1 ? argv[1] : "../config/two_boards.yml";
+    int plies = argc > 2 ? atoi(argv[2]) : 60;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    if (plies <= 0){
+        cerr << "Usage: " << argv[0] << " [calibration.yml] [plies per board] [seed]" << endl;
+        return 2;
+    }
+    vector<board_calibration> calibs;
+    if (!load_multi_board_calibration(calib_path, calibs)) return 2;
+
+    // Start from the renderer defaults with the given seed
+    board_renderer renderer;
+    init_board_renderer(renderer, NULL);
+    board_renderer_config config = renderer.config;
+    config.seed = seed;
+    if (!init_board_renderer(renderer, &config)) return 2;
+    RNG rng(seed);
+
+    vector<bench_board> boards(calibs.size());
+    for (size_t i = 0; i < calibs.size(); i++){
+        bench_board& b = boards[i];
+        b.to_frame = board_to_frame(calibs[i]);
+        vector<Point2f> centre = {Point2f(VISION_BOARD_PIXELS / 2.0f, VISION_BOARD_PIXELS / 2.0f)};
+        perspectiveTransform(centre, centre, b.to_frame);
+        b.centre = centre[0];
+        init_chess_board(&b.chess);
+        b.over = false;
+        b.played = b.correct = b.committed = 0;
+    }
+
+    multi_board_vision vision;
+    auto on_move = [&boards](int board, const move_vote_result& result, int64_t){
+        boards[board].committed++;
+        boards[board].last_committed = result.match.move.notation;
+    };
+    if (!init_multi_board_vision(vision, calibs, Size(FRAME_WIDTH, FRAME_HEIGHT), &boards[0].chess, NULL, NULL, on_move)) return 2;
+
+    Mat board, frame, hand_frame;
+    long frames = 0;
+    double frame_ms = 0, worst_ms = 0;
+    // Only process_multi_board_frame is timed; rendering stands in for the camera
+    auto process = [&](const Mat& image){
+        int64_t start = getTickCount();
+        process_multi_board_frame(vision, image);
+        double ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+        frame_ms += ms;
+        worst_ms = max(worst_ms, ms);
+        frames++;
+    };
+
+    compose_frame(renderer, boards, board, frame);
+    for (int i = 0; i < HOLD_FRAMES; i++) process(frame);
+    move_t legal[MAX_LEGAL_MOVES];
+    vector<string> expected(boards.size());
+    for (int ply = 0; ply < plies; ply++){
+        bool any = false;
+        for (size_t i = 0; i < boards.size(); i++){
+            bench_board& b = boards[i];
+            expected[i].clear();
+            if (b.over) continue;
+            int n_legal = generate_legal_moves(&b.chess, legal, MAX_LEGAL_MOVES);
+            if (n_legal == 0 || b.chess.move_count >= MAX_MOVES - 1){
+                b.over = true;
+                continue;
+            }
+            expected[i] = legal[rng.uniform(0, n_legal)].notation;
+            b.last_committed.clear();
+            any = true;
+        }
+        if (!any) break;
+        // Hands over every moving board, then the new position held still
+        frame.copyTo(hand_frame);
+        for (size_t i = 0; i < boards.size(); i++)
+            if (!expected[i].empty()) circle(hand_frame, boards[i].centre, 140, Scalar(120, 150, 210), FILLED);
+        for (int i = 0; i < HAND_FRAMES; i++) process(hand_frame);
+        for (size_t i = 0; i < boards.size(); i++)
+            if (!expected[i].empty()) make_move(&boards[i].chess, expected[i].c_str());
+        compose_frame(renderer, boards, board, frame);
+        for (int i = 0; i < HOLD_FRAMES; i++) process(frame);
+
+        for (size_t i = 0; i < boards.size(); i++){
+            bench_board& b = boards[i];
+            if (expected[i].empty()) continue;
+            b.played++;
+            if (b.last_committed == expected[i]){
+                b.correct++;
+                continue;
+            }
+            // Follow the game actually played so one miss does not derail the rest; the next
+            // settled view becomes the board's reference
+            set_multi_board_position(vision, (int)i, &b.chess);
+            process(frame);
+        }
+    }
+
+    long played = 0, correct = 0;
+    cout << "boards:                 " << boards.size() << " in a " << FRAME_WIDTH << "x" << FRAME_HEIGHT << " frame" << endl;
+    for (size_t i = 0; i < boards.size(); i++){
+        const bench_board& b = boards[i];
+        played += b.played;
+        correct += b.correct;
+        cout << "board " << i + 1 << ":                " << b.correct << "/" << b.played << " moves";
+        if (b.played > 0) cout << " (" << 100.0 * b.correct / b.played << "%)";
+        cout << ", " << b.committed << " committed" << endl;
+    }
+    cout << "frames:                 " << frames << endl;
+    cout << "frame time (ms):        " << (frames > 0 ? frame_ms / frames : 0) << " mean, " << worst_ms << " worst" << endl;
+    cout << "frames/second:          " << (frame_ms > 0 ? frames * 1000.0 / frame_ms : 0) << endl;
+    cout << "move accuracy:          " << correct << "/" << played;
+    if (played > 0) cout << " (" << 100.0 * correct / played << "%)";
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,110 @@
+// PGN throughput. With a game count, plays that many random games through the game-logic module,
+// exports them with SAN to a PGN file, then streams the file back, replaying every move through the
+// move generator, and checks each game ends in the position it was exported from. With 0 games,
+// only streams an existing PGN database. Reports moves/second and MB/second for both directions.
+//
+// Usage: pgn_bench [games] [pgn file]
+#include "game/pgn.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include <time.h>
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// 64-bit FNV-1a of a game's final FEN, to check the replay without keeping the games
+static uint64_t fen_hash(const chess_state_t *chess) {
+    char fen[128];
+    chess_state_to_fen(chess, fen, sizeof(fen));
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = fen; *p; p++) hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    return hash;
+}
+
+int main(int argc, char **argv) {
+    int games = argc > 1 ? atoi(argv[1]) : 2000;
+    const char *path = argc > 2 ? argv[2] : "/tmp/pgn_bench.pgn";
+    if (games < 0) {
+        fprintf(stderr, "Usage: %s [games, 0: only read] [pgn file]\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t *hashes = games > 0 ? malloc(sizeof(uint64_t) * (size_t)games) : NULL;
+    int *plies = games > 0 ? malloc(sizeof(int) * (size_t)games) : NULL;
+    if (games > 0) {
+        if (!hashes || !plies) return 1;
+        FILE *file = fopen(path, "w");
+        game_t *game = malloc(sizeof(game_t));
+        if (!file || !game) {
+            fprintf(stderr, "Error: Could not write %s\n", path);
+            return 1;
+        }
+        uint64_t rng = 0x5eed;
+        double play_s = 0.0;
+        double write_s = 0.0;
+        long moves = 0;
+        pgn_tag_t tags[PGN_MAX_TAGS];
+        for (int g = 0; g < games; g++) {
+            double t0 = now_seconds();
+            init_game(game, NULL, 0);
+            while (game->result == RESULT_ONGOING) {
+                const move_t *move = &game->legal_moves[next_random(&rng) % (uint64_t)game->n_legal_moves];
+                play_game_move(game, move->notation, 0);
+            }
+            double t1 = now_seconds();
+            int n_tags = game_pgn_tags(game, "Random", "Random", tags, PGN_MAX_TAGS);
+            write_pgn(file, &game->chess, tags, n_tags, game_result_string(game->result));
+            write_s += now_seconds() - t1;
+            play_s += t1 - t0;
+            hashes[g] = fen_hash(&game->chess);
+            plies[g] = game->chess.move_count;
+            moves += game->chess.move_count;
+        }
+        long bytes = ftell(file);
+        fclose(file);
+        free(game);
+        printf("export:             %d games, %ld moves, %.1f MB\n", games, moves, bytes / 1e6);
+        printf("  play:             %.0f moves/s (game logic, for reference)\n", play_s > 0 ? moves / play_s : 0.0);
+        printf("  SAN + write:      %.0f moves/s, %.1f MB/s\n", write_s > 0 ? moves / write_s : 0.0,
+               write_s > 0 ? bytes / write_s / 1e6 : 0.0);
+    }
+
+    pgn_reader_t *reader = malloc(sizeof(pgn_reader_t));
+    pgn_game_t *game = malloc(sizeof(pgn_game_t));
+    if (!reader || !game || !open_pgn_reader(reader, path)) return 1;
+    long mismatches = 0;
+    double start = now_seconds();
+    while (read_pgn_game(reader, game)) {
+        if (game->error && reader->errors <= 5) fprintf(stderr, "Game %ld: %s\n", reader->games, game->error_message);
+        long g = reader->games - 1;
+        if (games > 0 && (g >= games || game->plies != plies[g] || fen_hash(&game->chess) != hashes[g])) mismatches++;
+    }
+    double elapsed = now_seconds() - start;
+    close_pgn_reader(reader);
+
+    printf("import:             %ld games, %ld moves, %.1f MB in %.2f s\n", reader->games, reader->moves,
+           reader->bytes / 1e6, elapsed);
+    printf("  parse + replay:   %.0f moves/s, %.0f games/s, %.1f MB/s\n", elapsed > 0 ? reader->moves / elapsed : 0.0,
+           elapsed > 0 ? reader->games / elapsed : 0.0, elapsed > 0 ? reader->bytes / elapsed / 1e6 : 0.0);
+    printf("  memory:           %zu bytes reader + %zu bytes game, whatever the file size\n",
+           sizeof(pgn_reader_t), sizeof(pgn_game_t));
+    printf("  errors:           %ld games with unplayable moves", reader->errors);
+    if (games > 0) printf(", %ld mismatches against the export", mismatches);
+    printf("\n");
+    bool ok = reader->errors == 0 && mismatches == 0;
+    free(game);
+    free(reader);
+    free(plies);
+    free(hashes);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Internal search speed and soundness. Searches a fixed set of positions to a fixed depth
+// (nodes/second), solves mate puzzles, times a forced move, then starts an engine through the
+// UCI client ("internal" by default, or a binary that may be missing to show the fallback) and
+// times a shallow search over the pipes.
+//
+// Usage: search_bench [depth] [engine path]
+#include "engine/search.h"
+#include "engine/uci_engine.h"
+#include "game/chess_state.h"
+#include <time.h>
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *bench_positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/2pp4/2PP4/2NBPN2/PP3PPP/R1BQK2R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+// Positions with a single mating line and its first move
+static const struct {
+    const char *fen;
+    const char *move;
+} mates[] = {
+    {"6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1", "a1a8"},
+    {"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", "h5f7"},
+    {"r1b2k1r/ppp1bppp/8/1B1Q4/5q2/2P5/PPP2PPP/R3R1K1 w - - 1 1", "d5d8"},
+    {"6k1/pp4p1/2p5/2bp4/8/P5Pb/1P3rrP/2BRRN1K b - - 0 1", "g2g1"},
+    {"r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", "d5f6"},
+    {"2r3k1/p4p2/3Rp2p/1p2P1pK/8/1P4P1/P3Q2P/1q6 b - - 0 1", "b1g6"},
+};
+
+static bool set_fen(search_engine_t *engine, chess_state_t *chess, const char *fen) {
+    init_chess_board(chess);
+    if (!chess_state_from_fen(chess, fen)) {
+        fprintf(stderr, "Error: Bad FEN %s\n", fen);
+        return false;
+    }
+    search_set_position(engine, chess);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int depth = argc > 1 ? atoi(argv[1]) : 6;
+    const char *engine_path = argc > 2 ? argv[2] : UCI_INTERNAL_ENGINE;
+    if (depth <= 0 || depth >= SEARCH_MAX_PLY) {
+        fprintf(stderr, "Usage: %s [depth, 1-%d] [engine path]\n", argv[0], SEARCH_MAX_PLY - 1);
+        return 2;
+    }
+
+    search_engine_t *engine = malloc(sizeof(search_engine_t));
+    chess_state_t *chess = malloc(sizeof(chess_state_t));
+    if (!engine || !chess || !init_search_engine(engine, SEARCH_DEFAULT_HASH_MB)) return 1;
+
+    // Fixed depth from a fresh table, so runs compare
+    search_limits_t limits;
+    memset(&limits, 0, sizeof(limits));
+    limits.depth = depth;
+    search_result_t result;
+    long total_nodes = 0;
+    double total_s = 0.0;
+    int n_positions = (int)(sizeof(bench_positions) / sizeof(bench_positions[0]));
+    for (int i = 0; i < n_positions; i++) {
+        if (!set_fen(engine, chess, bench_positions[i])) return 1;
+        clear_search_engine(engine);
+        double t0 = now_seconds();
+        search_best_move(engine, &limits, NULL, NULL, NULL, &result);
+        double elapsed = now_seconds() - t0;
+        total_nodes += result.nodes;
+        total_s += elapsed;
+        printf("position %d:         depth %d, %ld nodes in %.3f s, score %d, best %s\n", i + 1, result.depth,
+               result.nodes, elapsed, result.score, result.best_move);
+    }
+    printf("search:             %ld nodes in %.2f s, %.0f nodes/s\n", total_nodes, total_s,
+           total_s > 0 ? total_nodes / total_s : 0.0);
+
+    int n_mates = (int)(sizeof(mates) / sizeof(mates[0]));
+    int solved = 0;
+    double mate_s = 0.0;
+    limits.depth = 0;
+    limits.movetime_ms = 5000;
+    for (int i = 0; i < n_mates; i++) {
+        if (!set_fen(engine, chess, mates[i].fen)) return 1;
+        double t0 = now_seconds();
+        search_best_move(engine, &limits, NULL, NULL, NULL, &result);
+        mate_s += now_seconds() - t0;
+        if (strcmp(result.best_move, mates[i].move) == 0 && result.score > SEARCH_MATE - SEARCH_MAX_PLY) {
+            solved++;
+        } else {
+            printf("  missed:           %s played %s, expected %s\n", mates[i].fen, result.best_move, mates[i].move);
+        }
+    }
+    printf("mates:              %d/%d solved, %.1f ms average\n", solved, n_mates, mate_s * 1000.0 / n_mates);
+
+    // A single legal move (the king must leave check) is answered without searching
+    if (!set_fen(engine, chess, "7k/8/8/8/8/8/6q1/7K w - - 0 1")) return 1;
+    double t0 = now_seconds();
+    search_best_move(engine, NULL, NULL, NULL, NULL, &result);
+    printf("forced move:        %s in %.1f us\n", result.best_move, (now_seconds() - t0) * 1e6);
+
+    // Through the UCI client, as the console and the server use it
+    uci_engine_t uci;
+    memset(&uci, 0, sizeof(uci));
+    t0 = now_seconds();
+    bool started = uci_start_engine(&uci, engine_path);
+    double start_s = now_seconds() - t0;
+    bool answered = false;
+    double answer_s = 0.0;
+    if (started) {
+        init_chess_board(chess);
+        t0 = now_seconds();
+        uci_set_position(&uci, chess);
+        uci_send_command(&uci, "go depth 4");
+        uci_search_t search;
+        uci_begin_search(&search);
+        while (!search.done && now_seconds() - t0 < 10.0) uci_poll_search(&uci, &search, 100);
+        answer_s = now_seconds() - t0;
+        answered = search.done && search.best_move[0] != '\0';
+        uci_stop_engine(&uci);
+    }
+    printf("uci engine:         %s started in %.1f ms, depth 4 %s in %.1f ms\n", engine_path,
+           start_s * 1000.0, answered ? "answered" : "NOT answered", answer_s * 1000.0);
+
+    free_search_engine(engine);
+    free(chess);
+    free(engine);
+    return (solved == n_mates && answered) ? 0 : 1;
+}
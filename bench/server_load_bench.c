@@ -0,0 +1,211 @@
+// Load test for the game server: each thread holds one connection and plays random games through
+// it, one request at a time ("legal", then a random "move", with a "state" every few plies), and
+// the round-trip latency of every request is recorded. Start chess_server first.
+//
+// Usage: server_load_bench [socket path | port] [threads] [games per thread]
+#include "common/chess_types.h"
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_BENCH_THREADS 256
+#define MAX_SAMPLES 2000000
+#define REPLY_MAX 4096
+
+typedef struct {
+    const char *target;
+    int games;
+    uint64_t seed;
+    int fd;
+    char buffer[REPLY_MAX * 2];
+    size_t buffered;
+    long requests;
+    long moves;
+    long finished;
+    long errors;
+    double *latencies;          // milliseconds
+    long samples;
+} bench_thread_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// A target of only digits is a localhost port, anything else a Unix socket path
+static int connect_server(const char *target) {
+    char *end;
+    long port = strtol(target, &end, 10);
+    if (*end == '\0') {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        if (fd >= 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", target);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+// Send one request and wait for its reply line; the latency is recorded
+static bool request(bench_thread_t *thread, const char *line, char *reply) {
+    char message[64];
+    int length = snprintf(message, sizeof(message), "%s\n", line);
+    double start = now_seconds();
+    if (send(thread->fd, message, (size_t)length, MSG_NOSIGNAL) != length) return false;
+    while (true) {
+        char *newline = memchr(thread->buffer, '\n', thread->buffered);
+        if (newline) {
+            size_t n = (size_t)(newline - thread->buffer);
+            if (n >= REPLY_MAX) n = REPLY_MAX - 1;
+            memcpy(reply, thread->buffer, n);
+            reply[n] = '\0';
+            size_t used = (size_t)(newline - thread->buffer) + 1;
+            memmove(thread->buffer, thread->buffer + used, thread->buffered - used);
+            thread->buffered -= used;
+            break;
+        }
+        ssize_t n = recv(thread->fd, thread->buffer + thread->buffered, sizeof(thread->buffer) - thread->buffered, 0);
+        if (n <= 0) return false;
+        thread->buffered += (size_t)n;
+    }
+    if (thread->samples < MAX_SAMPLES / MAX_BENCH_THREADS)
+        thread->latencies[thread->samples++] = (now_seconds() - start) * 1000.0;
+    thread->requests++;
+    if (strncmp(reply, "err", 3) == 0) thread->errors++;
+    return true;
+}
+
+static bool play_game(bench_thread_t *thread, uint64_t *rng) {
+    char reply[REPLY_MAX];
+    char line[64];
+    int id;
+    if (!request(thread, "new", reply) || sscanf(reply, "ok new %d", &id) != 1) return false;
+    for (int ply = 0; ; ply++) {
+        snprintf(line, sizeof(line), "legal %d", id);
+        if (!request(thread, line, reply)) return false;
+        int count = 0;
+        int offset = 0;
+        if (sscanf(reply, "legal %*d %d%n", &count, &offset) != 1 || count == 0) break;
+        // Pick the k-th move of the list
+        const char *moves = reply + offset;
+        int k = (int)(next_random(rng) % (uint64_t)count);
+        for (int i = 0; i < k && moves; i++) moves = strchr(moves + 1, ' ');
+        if (!moves) break;
+        char move[8];
+        if (sscanf(moves, " %7s", move) != 1) break;
+        snprintf(line, sizeof(line), "move %d %s", id, move);
+        if (!request(thread, line, reply)) return false;
+        thread->moves++;
+        char result[16];
+        if (sscanf(reply, "ok move %*d %*s %15s", result) == 1 && strcmp(result, "*") != 0) break;
+        if (ply % 8 == 0) {
+            snprintf(line, sizeof(line), "state %d", id);
+            if (!request(thread, line, reply)) return false;
+        }
+    }
+    snprintf(line, sizeof(line), "close %d", id);
+    if (!request(thread, line, reply)) return false;
+    thread->finished++;
+    return true;
+}
+
+static void *run_thread(void *arg) {
+    bench_thread_t *thread = (bench_thread_t *)arg;
+    thread->fd = connect_server(thread->target);
+    if (thread->fd < 0) {
+        fprintf(stderr, "Error: Could not connect to %s\n", thread->target);
+        return NULL;
+    }
+    uint64_t rng = thread->seed;
+    for (int g = 0; g < thread->games; g++) {
+        if (!play_game(thread, &rng)) {
+            fprintf(stderr, "Error: Connection lost\n");
+            break;
+        }
+    }
+    close(thread->fd);
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    const char *target = argc > 1 ? argv[1] : "/tmp/chess_server.sock";
+    int threads = argc > 2 ? atoi(argv[2]) : 8;
+    int games = argc > 3 ? atoi(argv[3]) : 50;
+    if (games <= 0) {
+        fprintf(stderr, "Usage: %s [socket path | port] [threads] [games per thread]\n", argv[0]);
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_BENCH_THREADS) threads = MAX_BENCH_THREADS;
+
+    static bench_thread_t workers[MAX_BENCH_THREADS];
+    pthread_t ids[MAX_BENCH_THREADS];
+    double *latencies = malloc(sizeof(double) * MAX_SAMPLES);
+    if (!latencies) return 1;
+    double start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        workers[i].target = target;
+        workers[i].games = games;
+        workers[i].seed = 0x5eed + (uint64_t)i;
+        workers[i].latencies = latencies + (size_t)i * (MAX_SAMPLES / MAX_BENCH_THREADS);
+        if (pthread_create(&ids[i], NULL, run_thread, &workers[i]) != 0) {
+            fprintf(stderr, "Error: Could not start bench thread %d\n", i);
+            return 1;
+        }
+    }
+    long requests = 0, moves = 0, finished = 0, errors = 0, samples = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+        requests += workers[i].requests;
+        moves += workers[i].moves;
+        finished += workers[i].finished;
+        errors += workers[i].errors;
+        // Compact the samples to the front for sorting
+        memmove(latencies + samples, workers[i].latencies, sizeof(double) * (size_t)workers[i].samples);
+        samples += workers[i].samples;
+    }
+    double elapsed = now_seconds() - start;
+    qsort(latencies, (size_t)samples, sizeof(double), compare_doubles);
+
+    printf("connections:        %d\n", threads);
+    printf("games:              %ld in %.2f s (%.0f games/s)\n", finished, elapsed, elapsed > 0 ? finished / elapsed : 0.0);
+    printf("moves/second:       %.0f\n", elapsed > 0 ? moves / elapsed : 0.0);
+    printf("requests/second:    %.0f (%ld requests, %ld errors)\n", elapsed > 0 ? requests / elapsed : 0.0, requests, errors);
+    if (samples > 0) {
+        printf("latency ms:         p50 %.3f, p99 %.3f, max %.3f\n", latencies[samples / 2],
+               latencies[(long)(samples * 0.99)], latencies[samples - 1]);
+    }
+    free(latencies);
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Plays whole games on a simulated board and arm, with no hardware: every ply is chosen by the
+// engine (or at random), scheduled for the arm and timed by the arm simulator, rendered as a
+// synthetic top-down board image, detected by the move detector and validated against the
+// rules. Reports moves/second of the full loop, latency per stage and detection accuracy.
+//
+// Usage: sim_game_bench [--games N] [--plies N] [--seed N] [--noise sigma] [--sprites dir]
+//                       [--engine path [--movetime ms]] [--arm arm.cfg]
+#include "arm/arm_kinematics.h"
+#include "arm/motion_scheduler.h"
+#include "engine/uci_engine.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+#include "vision/board_renderer.h"
+#include "vision/move_detector.h"
+#include "vision/occupancy_classifier.h"
+#include "vision/piece_recognizer.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+enum sim_stage {
+    STAGE_ENGINE = 0,
+    STAGE_ARM,
+    STAGE_RENDER,
+    STAGE_DETECT,
+    STAGE_VALIDATE,
+    STAGE_COUNT
+};
+
+static const char* stage_names[STAGE_COUNT] = {"engine", "arm plan", "render", "detect", "validate"};
+
+struct sim_stats {
+    long games;
+    long moves;
+    long correct_moves;
+    long arm_moves;
+    double stage_ms[STAGE_COUNT];
+    double worst_ms[STAGE_COUNT];
+    double arm_s;               // simulated arm execution time
+    double total_s;
+};
+
+// Everything one game needs, set up once
+struct sim_setup {
+    board_renderer renderer;
+    move_detector_context detector;
+    piece_recognizer pieces;
+    occupancy_classifier occupancy;
+    uci_engine_t engine;
+    bool has_engine;
+    int movetime_ms;
+    const arm_scheduler_t* scheduler;   // NULL: no arm
+    int max_plies;
+    RNG rng;
+};
+
+static double elapsed_ms(int64_t start){
+    return (getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+static void charge(sim_stats& stats, sim_stage stage, int64_t start){
+    double ms = elapsed_ms(start);
+    stats.stage_ms[stage] += ms;
+    if (ms > stats.worst_ms[stage]) stats.worst_ms[stage] = ms;
+}
+
+static bool choose_move(sim_setup& setup, const chess_state_t* chess, move_t* legal, int n_legal, char* uci){
+    if (!setup.has_engine){
+        strcpy(uci, legal[setup.rng.uniform(0, n_legal)].notation);
+        return true;
+    }
+    char command[32];
+    snprintf(command, sizeof(command), "go movetime %d", setup.movetime_ms);
+    return uci_set_position(&setup.engine, chess) && uci_send_command(&setup.engine, command) &&
+           uci_get_best_move(&setup.engine, uci, 16);
+}
+
+static bool play_game(sim_setup& setup, chess_state_t* chess, chess_state_t* next, sim_stats& stats){
+    init_chess_board(chess);
+    move_converter_t converter;
+    init_move_converter(&converter);
+    int arm_at = -1;
+    Mat board;
+    render_board(setup.renderer, chess, board);
+    set_move_detector_reference(setup.detector, board);
+    move_t legal[MAX_LEGAL_MOVES];
+    int64_t game_start = getTickCount();
+
+    for (int ply = 0; ply < setup.max_plies; ply++){
+        int n_legal = generate_legal_moves(chess, legal, MAX_LEGAL_MOVES);
+        if (n_legal == 0 || chess->move_count >= MAX_MOVES - 1) break;
+
+        int64_t start = getTickCount();
+        char uci[16];
+        if (!choose_move(setup, chess, legal, n_legal, uci)){
+            cerr << "Error: No move from the engine" << endl;
+            return false;
+        }
+        charge(stats, STAGE_ENGINE, start);
+        *next = *chess;
+        if (make_move(next, uci) != MOVE_SUCCESS){
+            cerr << "Error: Engine move " << uci << " is illegal" << endl;
+            return false;
+        }
+        const move_t* played = &next->move_history[next->move_count - 1];
+
+        if (setup.scheduler){
+            start = getTickCount();
+            arm_schedule_t schedule;
+            if (!schedule_arm_move(setup.scheduler, &converter, played, arm_at, &schedule)){
+                cerr << "Error: Could not schedule " << uci << " for the arm" << endl;
+                return false;
+            }
+            arm_at = schedule.end_location;
+            charge(stats, STAGE_ARM, start);
+            stats.arm_s += schedule.simulated_s;
+            stats.arm_moves++;
+        }
+
+        start = getTickCount();
+        render_board(setup.renderer, next, board);
+        charge(stats, STAGE_RENDER, start);
+
+        start = getTickCount();
+        legal_move_match match;
+        bool found = detect_legal_move(setup.detector, chess, board, match);
+        charge(stats, STAGE_DETECT, start);
+
+        // The detected move goes through the rules like a human move would; a miss is counted and
+        // the game follows the move actually played so one error does not derail the rest
+        start = getTickCount();
+        bool correct = found && make_move(chess, match.move.notation) == MOVE_SUCCESS && strcmp(match.move.notation, uci) == 0;
+        if (!correct){
+            *chess = *next;
+        }
+        set_move_detector_reference(setup.detector, board);
+        charge(stats, STAGE_VALIDATE, start);
+        stats.moves++;
+        if (correct) stats.correct_moves++;
+    }
+    stats.total_s += (getTickCount() - game_start) / getTickFrequency();
+    stats.games++;
+    return true;
+}
+
+int main(int argc, char** argv){
+    int games = 10;
+    int plies = 200;
+    uint64_t seed = 1;
+    double noise = -1;
+    string sprites, engine_path, arm_path;
+    int movetime_ms = 10;
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--games" && has_value) games = atoi(argv[++i]);
+        else if (arg == "--plies" && has_value) plies = atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) seed = strtoull(argv[++i], NULL, 10);
+        else if (arg == "--noise" && has_value) noise = atof(argv[++i]);
+        else if (arg == "--sprites" && has_value) sprites = argv[++i];
+        else if (arg == "--engine" && has_value) engine_path = argv[++i];
+        else if (arg == "--movetime" && has_value) movetime_ms = atoi(argv[++i]);
+        else if (arg == "--arm" && has_value) arm_path = argv[++i];
+        else {
+            cerr << "Usage: " << argv[0] << " [--games N] [--plies N] [--seed N] [--noise sigma] [--sprites dir]"
+                 << " [--engine path [--movetime ms]] [--arm arm.cfg]" << endl;
+            return 2;
+        }
+    }
+
+    sim_setup* setup = new sim_setup;
+    // Start from the renderer defaults and override what was given on the command line
+    init_board_renderer(setup->renderer, NULL);
+    board_renderer_config config = setup->renderer.config;
+    config.seed = seed;
+    config.sprite_dir = sprites;
+    if (noise >= 0) config.noise_sigma = noise;
+    if (!init_board_renderer(setup->renderer, &config)) return 2;
+    setup->rng = RNG(seed);
+    setup->max_plies = plies;
+    setup->movetime_ms = movetime_ms;
+
+    // Piece templates come from a render of the starting position, as they would from the camera
+    chess_state_t* chess = new chess_state_t;
+    chess_state_t* next = new chess_state_t;
+    init_chess_board(chess);
+    Mat start_board;
+    render_board(setup->renderer, chess, start_board);
+    init_move_detector(setup->detector);
+    setup->detector.pieces = calibrate_piece_recognizer(setup->pieces, start_board) ? &setup->pieces : NULL;
+    setup->detector.occupancy = calibrate_occupancy_classifier(setup->occupancy, start_board) ? &setup->occupancy : NULL;
+
+    setup->has_engine = !engine_path.empty();
+    if (setup->has_engine && !uci_start_engine(&setup->engine, engine_path.c_str())) return 2;
+
+    arm_config_t arm;
+    arm_kinematics_t* kinematics = NULL;
+    trajectory_cache_t* cache = NULL;
+    arm_scheduler_t* scheduler = NULL;
+    setup->scheduler = NULL;
+    if (!arm_path.empty()){
+        if (!load_arm_config(arm_path.c_str(), &arm)) return 2;
+        kinematics = new arm_kinematics_t;
+        cache = new trajectory_cache_t;
+        scheduler = new arm_scheduler_t;
+        init_trajectory_cache(cache);
+        if (!init_arm_kinematics(kinematics, &arm) ||
+            !build_trajectory_cache(cache, arm.n_joints, arm_table_pose_solver, kinematics) ||
+            !init_arm_scheduler(scheduler, &arm, cache)) return 1;
+        setup->scheduler = scheduler;
+    }
+
+    sim_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int g = 0; g < games; g++)
+        if (!play_game(*setup, chess, next, stats)) return 1;
+
+    long moves = stats.moves > 0 ? stats.moves : 1;
+    cout << "games:                  " << stats.games << endl;
+    cout << "moves:                  " << stats.moves << endl;
+    cout << "moves/second:           " << (stats.total_s > 0 ? stats.moves / stats.total_s : 0) << " (full loop, arm not waited for)" << endl;
+    for (int s = 0; s < STAGE_COUNT; s++){
+        if (s == STAGE_ARM && !setup->scheduler) continue;
+        string label = string(stage_names[s]) + " (ms/move):";
+        label.resize(24, ' ');
+        cout << label << stats.stage_ms[s] / moves << " mean, " << stats.worst_ms[s] << " worst" << endl;
+    }
+    if (stats.arm_moves > 0){
+        cout << "simulated arm (s/move): " << stats.arm_s / stats.arm_moves << endl;
+        cout << "with arm (moves/hour):  " << 3600.0 * stats.moves / (stats.total_s + stats.arm_s) << endl;
+    }
+    cout << "detection accuracy:     " << stats.correct_moves << "/" << stats.moves
+         << " (" << 100.0 * stats.correct_moves / moves << "%)" << endl;
+
+    if (setup->has_engine) uci_stop_engine(&setup->engine);
+    if (cache) free_trajectory_cache(cache);
+    delete scheduler;
+    delete cache;
+    delete kinematics;
+    delete next;
+    delete chess;
+    delete setup;
+    return 0;
+}
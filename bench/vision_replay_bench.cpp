@@ -0,0 +1,364 @@
+// Replays recorded games through the move detector and reports latency, throughput and accuracy.
+//
+// Usage: vision_replay_bench [--calib calibration.yml] [--video] [--pipeline [--arm arm.cfg]] <sequence>...
+//
+// A sequence is a directory holding moves.txt (the ground-truth UCI moves, whitespace separated)
+// and either one still image per position in name order (image 0 is the starting position,
+// image i is the board after move i), or, with --video, a recording named game.* that is gated
+// for settled frames before detection.
+//
+// --pipeline runs each sequence through the threaded vision pipeline instead, as fast as the
+// source decodes, and reports drops per ring and the detect stage latency. The pipeline gates
+// and votes on a frame stream, so the source is the game.* recording with --video, or else the
+// directory's images read as consecutive camera frames; one still per position never settles.
+// With --arm, a simulated arm (config/arm.cfg) replays every committed move and tells the
+// pipeline when it enters and leaves the camera view; frames seen meanwhile are ignored.
+#include "arm/arm_executor.h"
+#include "vision/board_detector.h"
+#include "vision/camera_interface.h"
+#include "vision/frame_gate.h"
+#include "vision/move_detector.h"
+#include "vision/vision_pipeline.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// The replay runs as fast as the source decodes, so the simulated arm is sped up to match
+#define REPLAY_ARM_TIME_SCALE 0.05
+
+struct replay_stats {
+    long frames;
+    long detections;        // detector invocations
+    long expected_moves;
+    long correct_moves;
+    double decode_ms;
+    double preprocess_ms;
+    double diff_ms;
+    double decide_ms;
+    double total_s;
+};
+
+// Totals of vision_pipeline_stats over the sequences, plus the moves the pipeline committed
+struct pipeline_replay_stats {
+    long captured;
+    long dropped_source;
+    long dropped_preprocess;
+    long dropped_detect;
+    long dropped_output;
+    long detect_frames;
+    long detect_us;
+    long detect_worst_us;
+    long detector_us;
+    long voted;
+    long expected_moves;
+    long committed_moves;
+    long correct_moves;
+    double commit_ms;           // time from the first voted frame to the commit
+    double total_s;
+    long arm_hidden;            // frames ignored while the arm was in view
+    long arm_moves;
+    long arm_view_changes;
+};
+
+static double elapsed_ms(int64_t start){
+    return (getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+static bool load_moves(const string& path, vector<string>& moves){
+    ifstream in(path);
+    if (!in){
+        cerr << "Error: Could not open " << path << endl;
+        return false;
+    }
+    string move;
+    while (in >> move) moves.push_back(move);
+    return true;
+}
+
+// Rectify a camera frame, or resize it when the recording is already a top-down board view
+static void to_board(const board_remap* remap, const Mat& frame, Mat& board){
+    if (remap){
+        warp_board_frame(*remap, frame, board);
+    } else {
+        resize(frame, board, Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+    }
+}
+
+// Source spec of a sequence: its game.* recording, or the directory itself
+static bool sequence_source(const string& dir, bool video, string& spec){
+    spec = dir;
+    if (!video) return true;
+    vector<string> files;
+    glob(dir + "/game.*", files, false);
+    if (files.empty()){
+        cerr << "Error: No game.* recording in " << dir << endl;
+        return false;
+    }
+    spec = files[0];
+    return true;
+}
+
+static bool replay_sequence(const string& dir, bool video, const board_calibration* calib, replay_stats& stats){
+    vector<string> moves;
+    if (!load_moves(dir + "/moves.txt", moves)) return false;
+    string spec;
+    if (!sequence_source(dir, video, spec)) return false;
+    camera_source source;
+    if (!open_camera_source(source, spec)) return false;
+
+    chess_state_t* chess = new chess_state_t;
+    init_chess_board(chess);
+    move_detector_context ctx;
+    init_move_detector(ctx);
+    frame_gate gate;
+    init_frame_gate(gate, NULL);
+    board_remap remap;
+    bool use_remap = false;
+    Mat frame, board;
+    size_t next_move = 0;
+    int64_t sequence_start = getTickCount();
+
+    while (next_move < moves.size()){
+        int64_t start = getTickCount();
+        if (!read_camera_frame(source, frame)) break;
+        stats.decode_ms += elapsed_ms(start);
+        stats.frames++;
+        if (calib && !use_remap){
+            if (!build_board_remap(*calib, frame.size(), VISION_BOARD_PIXELS, remap)) break;
+            use_remap = true;
+        }
+        // Rectification and gating run on every frame and are charged to preprocessing
+        start = getTickCount();
+        to_board(use_remap ? &remap : NULL, frame, board);
+        frame_gate_state gate_state = video ? update_frame_gate(gate, board) : GATE_STABLE;
+        stats.preprocess_ms += elapsed_ms(start);
+        if (!ctx.has_reference){
+            // Stills start with the initial position; videos wait for the first settled frame
+            if (!video || gate_state == GATE_IDLE) set_move_detector_reference(ctx, board);
+            continue;
+        }
+        if (gate_state != GATE_STABLE) continue;
+        legal_move_match match;
+        bool found = detect_legal_move(ctx, chess, board, match);
+        stats.detections++;
+        stats.preprocess_ms += ctx.timings.preprocess_ms;
+        stats.diff_ms += ctx.timings.diff_ms;
+        stats.decide_ms += ctx.timings.decide_ms;
+        // A settled video frame with no recognisable move is not charged against a ground-truth move
+        if (video && !found) continue;
+        const string& expected = moves[next_move++];
+        if (found && expected == match.move.notation) stats.correct_moves++;
+        // Follow the ground truth so one error does not derail the rest of the game
+        if (make_move(chess, expected.c_str()) != MOVE_SUCCESS){
+            cerr << "Error: Ground-truth move " << expected << " is illegal in " << dir << endl;
+            break;
+        }
+        set_move_detector_reference(ctx, board);
+        if (video) set_frame_gate_reference(gate);
+    }
+    stats.expected_moves += moves.size();
+    stats.total_s += (getTickCount() - sequence_start) / getTickFrequency();
+    close_camera_source(source);
+    delete chess;
+    return true;
+}
+
+static bool replay_pipeline(const string& dir, bool video, const board_calibration* calib, const char* arm_path,
+                            pipeline_replay_stats& stats){
+    vector<string> moves;
+    if (!load_moves(dir + "/moves.txt", moves)) return false;
+    vision_pipeline_config config;
+    if (!sequence_source(dir, video, config.source)) return false;
+    config.output = vision_annotation_config_t();
+    config.gate = frame_gate_config();
+    config.vote = move_vote_config();
+    config.remap = NULL;
+    // The remap depends on the frame size, so peek at the first frame
+    board_remap remap;
+    if (calib){
+        camera_source probe;
+        Mat frame;
+        if (!open_camera_source(probe, config.source)) return false;
+        bool ok = read_camera_frame(probe, frame) && build_board_remap(*calib, frame.size(), VISION_BOARD_PIXELS, remap);
+        close_camera_source(probe);
+        if (!ok) return false;
+        config.remap = &remap;
+    }
+
+    chess_state_t* chess = new chess_state_t;
+    init_chess_board(chess);
+    vector<string> committed;
+    double commit_ms = 0;
+    vision_pipeline* pipeline = new vision_pipeline;
+    // The arm starts parked, out of view, and reports its view changes to the pipeline
+    arm_sim_rig_t* arm = NULL;
+    if (arm_path){
+        arm = new arm_sim_rig_t;
+        if (!start_sim_arm(arm, arm_path, REPLAY_ARM_TIME_SCALE, vision_pipeline_arm_view, pipeline)){
+            delete arm;
+            delete pipeline;
+            delete chess;
+            return false;
+        }
+    }
+    int64_t start = getTickCount();
+    // Called on the detect thread; read only after the pipeline has been joined
+    bool started = start_vision_pipeline(*pipeline, config, chess, [&](const move_vote_result& result, int64_t){
+        committed.push_back(result.match.move.notation);
+        commit_ms += result.time_to_commit_ms;
+        if (arm) arm_executor_move(&arm->executor, &result.match.move);
+    });
+    if (started) wait_vision_pipeline(*pipeline);
+    stats.total_s += (getTickCount() - start) / getTickFrequency();
+    if (arm){
+        // Joined before the pipeline goes away: its view callback points at the pipeline
+        stop_sim_arm(arm);
+        stats.arm_moves += arm->executor.moves;
+        stats.arm_view_changes += arm->executor.view_changes;
+        delete arm;
+    }
+    if (started){
+        const vision_pipeline_stats& run = pipeline->stats;
+        stats.captured += run.captured;
+        stats.dropped_source += run.dropped_source;
+        stats.dropped_preprocess += run.dropped_preprocess;
+        stats.dropped_detect += run.dropped_detect;
+        stats.dropped_output += run.dropped_output;
+        stats.detect_frames += run.detect_frames;
+        stats.detect_us += run.detect_us;
+        stats.detect_worst_us = max(stats.detect_worst_us, run.detect_worst_us.load());
+        stats.detector_us += run.detector_us;
+        stats.voted += run.voted;
+        stats.arm_hidden += run.arm_hidden;
+        // The pipeline follows its own commits, so a move counts when it is the i-th of both lists
+        for (size_t i = 0; i < committed.size() && i < moves.size(); i++)
+            if (committed[i] == moves[i]) stats.correct_moves++;
+        stats.expected_moves += moves.size();
+        stats.committed_moves += committed.size();
+        stats.commit_ms += commit_ms;
+    }
+    delete pipeline;
+    delete chess;
+    return started;
+}
+
+static int run_pipeline_replay(const vector<string>& sequences, bool video, const board_calibration* calib, const char* arm_path){
+    pipeline_replay_stats stats = pipeline_replay_stats();
+    for (const string& dir : sequences){
+        pipeline_replay_stats seq = pipeline_replay_stats();
+        if (!replay_pipeline(dir, video, calib, arm_path, seq)) return 2;
+        cout << dir << ": " << seq.correct_moves << "/" << seq.expected_moves << " moves, "
+             << seq.captured << " frames in " << seq.total_s << " s, "
+             << seq.dropped_source + seq.dropped_preprocess + seq.dropped_detect + seq.dropped_output << " dropped" << endl;
+        stats.captured += seq.captured;
+        stats.dropped_source += seq.dropped_source;
+        stats.dropped_preprocess += seq.dropped_preprocess;
+        stats.dropped_detect += seq.dropped_detect;
+        stats.dropped_output += seq.dropped_output;
+        stats.detect_frames += seq.detect_frames;
+        stats.detect_us += seq.detect_us;
+        stats.detect_worst_us = max(stats.detect_worst_us, seq.detect_worst_us);
+        stats.detector_us += seq.detector_us;
+        stats.voted += seq.voted;
+        stats.arm_hidden += seq.arm_hidden;
+        stats.arm_moves += seq.arm_moves;
+        stats.arm_view_changes += seq.arm_view_changes;
+        stats.expected_moves += seq.expected_moves;
+        stats.committed_moves += seq.committed_moves;
+        stats.correct_moves += seq.correct_moves;
+        stats.commit_ms += seq.commit_ms;
+        stats.total_s += seq.total_s;
+    }
+
+    long detect_frames = stats.detect_frames > 0 ? stats.detect_frames : 1;
+    long voted = stats.voted > 0 ? stats.voted : 1;
+    long committed = stats.committed_moves > 0 ? stats.committed_moves : 1;
+    cout << endl;
+    cout << "sequences:              " << sequences.size() << endl;
+    cout << "frames captured:        " << stats.captured << endl;
+    cout << "dropped at source:      " << stats.dropped_source << " (frame pool exhausted)" << endl;
+    cout << "dropped to_preprocess:  " << stats.dropped_preprocess << endl;
+    cout << "dropped to_detect:      " << stats.dropped_detect << endl;
+    cout << "dropped to_output:      " << stats.dropped_output << endl;
+    cout << "detect (ms/frame):      " << stats.detect_us / 1000.0 / detect_frames << " over " << stats.detect_frames
+         << " frames, worst " << stats.detect_worst_us / 1000.0 << endl;
+    cout << "detector (ms/call):     " << stats.detector_us / 1000.0 / voted << " over " << stats.voted << " voted frames" << endl;
+    cout << "time to commit (ms):    " << stats.commit_ms / committed << endl;
+    if (arm_path){
+        cout << "arm moves:              " << stats.arm_moves << ", " << stats.arm_view_changes << " view transitions" << endl;
+        cout << "hidden by the arm:      " << stats.arm_hidden << " frames" << endl;
+    }
+    cout << "frames/second:          " << (stats.total_s > 0 ? stats.captured / stats.total_s : 0) << endl;
+    cout << "move accuracy:          " << stats.correct_moves << "/" << stats.expected_moves;
+    if (stats.expected_moves > 0) cout << " (" << 100.0 * stats.correct_moves / stats.expected_moves << "%)";
+    cout << ", " << stats.committed_moves << " committed" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv){
+    bool video = false;
+    bool pipeline = false;
+    board_calibration calib;
+    bool has_calib = false;
+    const char* arm_path = NULL;
+    vector<string> sequences;
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--video"){
+            video = true;
+        } else if (arg == "--pipeline"){
+            pipeline = true;
+        } else if (arg == "--arm" && i + 1 < argc){
+            arm_path = argv[++i];
+        } else if (arg == "--calib" && i + 1 < argc){
+            if (!load_board_calibration(argv[++i], calib)) return 2;
+            has_calib = true;
+        } else {
+            sequences.push_back(arg);
+        }
+    }
+    if (sequences.empty()){
+        cerr << "Usage: " << argv[0] << " [--calib calibration.yml] [--video] [--pipeline [--arm arm.cfg]] <sequence_dir>..." << endl;
+        return 2;
+    }
+    if (pipeline) return run_pipeline_replay(sequences, video, has_calib ? &calib : NULL, arm_path);
+
+    replay_stats stats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    for (const string& dir : sequences){
+        replay_stats seq = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        if (!replay_sequence(dir, video, has_calib ? &calib : NULL, seq)) return 2;
+        cout << dir << ": " << seq.correct_moves << "/" << seq.expected_moves << " moves, "
+             << seq.frames << " frames in " << seq.total_s << " s" << endl;
+        stats.frames += seq.frames;
+        stats.detections += seq.detections;
+        stats.expected_moves += seq.expected_moves;
+        stats.correct_moves += seq.correct_moves;
+        stats.decode_ms += seq.decode_ms;
+        stats.preprocess_ms += seq.preprocess_ms;
+        stats.diff_ms += seq.diff_ms;
+        stats.decide_ms += seq.decide_ms;
+        stats.total_s += seq.total_s;
+    }
+
+    long frames = stats.frames > 0 ? stats.frames : 1;
+    long detections = stats.detections > 0 ? stats.detections : 1;
+    cout << endl;
+    cout << "sequences:              " << sequences.size() << endl;
+    cout << "frames:                 " << stats.frames << endl;
+    cout << "decode (ms/frame):      " << stats.decode_ms / frames << endl;
+    cout << "preprocess (ms/frame):  " << stats.preprocess_ms / frames << " (rectify, gate, gray/blur)" << endl;
+    cout << "diff (ms/detection):    " << stats.diff_ms / detections << endl;
+    cout << "decide (ms/detection):  " << stats.decide_ms / detections << endl;
+    cout << "frames/second:          " << (stats.total_s > 0 ? stats.frames / stats.total_s : 0) << endl;
+    cout << "move accuracy:          " << stats.correct_moves << "/" << stats.expected_moves;
+    if (stats.expected_moves > 0) cout << " (" << 100.0 * stats.correct_moves / stats.expected_moves << "%)";
+    cout << endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef ARM_EXECUTOR_H
+#define ARM_EXECUTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include "arm/motion_scheduler.h"
+
+#define ARM_COMMAND_QUEUE 8
+
+// Drives the hardware (or a simulation) through a motion, blocking until it is done
+typedef struct {
+    void *context;
+    bool (*run)(void *context, const joint_pose_t *start, const arm_motion_t *motion);
+} arm_backend_t;
+
+// Simulated arm: sleeps for the time the motion would take, scaled by time_scale (0: no sleep)
+typedef struct {
+    const arm_config_t *config;
+    double time_scale;
+    double busy_s;              // simulated seconds of motion so far
+    long motions;
+} arm_sim_backend_t;
+
+arm_backend_t sim_arm_backend(arm_sim_backend_t *sim);
+
+typedef enum {
+    ARM_COMMAND_PREPARE = 0,    // hover at travel height over the first pick of a likely move
+    ARM_COMMAND_MOVE,           // execute a move
+    ARM_COMMAND_PARK            // leave the camera view
+} arm_command_type_t;
+
+typedef struct {
+    arm_command_type_t type;
+    move_t move;
+} arm_command_t;
+
+// Called from the executor thread when the arm enters or leaves the camera view
+typedef void (*arm_view_fn)(void *context, bool in_view);
+
+struct arm_executor {
+    const arm_scheduler_t *scheduler;
+    arm_backend_t backend;
+    arm_view_fn on_view;
+    void *view_context;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;             // queue or busy state changed
+    arm_command_t queue[ARM_COMMAND_QUEUE];
+    int head;
+    int count;
+    bool busy;
+    bool stop;
+    // Owned by the executor thread
+    move_converter_t converter;
+    int location;                       // location the arm is over, -1 while parked
+    joint_pose_t pose;
+    bool in_view;
+    // Statistics, read after arm_executor_wait
+    long moves;
+    long prepares;
+    long prepares_replaced;             // superseded by a newer PV before the arm got to them
+    long parks;                         // explicit parks, e.g. after a search that ended without a move
+    long view_changes;                  // times the arm entered or left the camera view
+    long failures;
+    double last_move_estimated_s;
+};
+typedef struct arm_executor arm_executor_t;
+
+// Start the executor thread with the arm parked at the configured home pose
+bool start_arm_executor(arm_executor_t *executor, const arm_scheduler_t *scheduler, arm_backend_t backend,
+                        arm_view_fn on_view, void *view_context);
+
+// Pre-position for a move the engine is likely to play; replaces a queued, not yet started prepare
+bool arm_executor_prepare(arm_executor_t *executor, const move_t *move);
+
+// Queue a move followed by parking; drops queued prepares, which are stale once the move is known
+bool arm_executor_move(arm_executor_t *executor, const move_t *move);
+
+// Drop queued prepares and leave the camera view, e.g. when a search ends without a move: a
+// prepare with no move after it would otherwise leave the arm hovering over the board
+bool arm_executor_park(arm_executor_t *executor);
+
+// Block until every queued command has been executed
+void arm_executor_wait(arm_executor_t *executor);
+
+// Finish the queued commands and join the thread
+void stop_arm_executor(arm_executor_t *executor);
+
+// A simulated arm and everything it needs, loaded from an arm configuration file (config/arm.cfg)
+struct arm_sim_rig {
+    arm_config_t config;
+    arm_kinematics_t kinematics;
+    trajectory_cache_t cache;
+    arm_scheduler_t scheduler;
+    arm_sim_backend_t sim;
+    arm_executor_t executor;
+};
+typedef struct arm_sim_rig arm_sim_rig_t;
+
+// Build the pose table, trajectory cache and scheduler and start an executor on the sim backend.
+// time_scale paces the simulation (1: real time, 0: no waiting); on_view may be NULL.
+bool start_sim_arm(arm_sim_rig_t *rig, const char *config_path, double time_scale, arm_view_fn on_view, void *view_context);
+void stop_sim_arm(arm_sim_rig_t *rig);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef ARM_KINEMATICS_H
+#define ARM_KINEMATICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/arm_types.h"
+
+typedef enum {
+    ARM_JOINT_REVOLUTE = 0,
+    ARM_JOINT_PRISMATIC
+} arm_joint_type_t;
+
+// Standard Denavit-Hartenberg link; the joint variable adds to theta (revolute) or d (prismatic).
+// Lengths in metres, angles in radians.
+typedef struct {
+    arm_joint_type_t type;
+    double a, alpha, d, theta;
+    double min, max;            // joint limits
+} dh_joint_t;
+
+// Arm and workspace description, all positions in the arm base frame. The gripper approaches
+// along the z axis of the last DH frame and must point straight down at every location.
+typedef struct {
+    int n_joints;
+    dh_joint_t joints[ARM_MAX_JOINTS];
+    double home[ARM_MAX_JOINTS];                // cold-start pose
+    double board[3][3];                         // centres of a8, h8 and a1
+    double graveyard[2][3][3];                  // per colour: first slot, next slot step, second row step
+    double rack[2][2][3];                       // per colour: queen slot, next slot step
+    double heights[ARM_HEIGHT_TRAVEL + 1];      // gripper height above the location surface
+    int max_iterations;
+    double position_tolerance;                  // metres
+    double orientation_tolerance;               // radians between the approach axis and straight down
+    double max_velocity[ARM_MAX_JOINTS];        // per joint, rad/s or m/s
+    double max_acceleration[ARM_MAX_JOINTS];    // per joint, rad/s^2 or m/s^2
+    double gripper_seconds;                     // to open or close the gripper
+} arm_config_t;
+
+typedef struct {
+    bool converged;
+    int iterations;
+    double position_error;
+    double orientation_error;
+} ik_result_t;
+
+// Every location at every height solved once at startup. Stored as float: the table is what
+// the trajectory cache and every warm start read, and float keeps it a few kilobytes.
+typedef struct {
+    arm_config_t config;
+    float poses[ARM_LOCATIONS][ARM_HEIGHT_TRAVEL + 1][ARM_MAX_JOINTS];
+    float targets[ARM_LOCATIONS][ARM_HEIGHT_TRAVEL + 1][3];
+    bool ready;
+    double build_ms;
+    long build_iterations;
+} arm_kinematics_t;
+
+// Parse a text config. One entry per line, '#' starts a comment:
+//   joint <revolute|prismatic> <a> <alpha deg> <d> <theta deg> <min> <max>   (limits in deg or m)
+//   home <q1> ... <qn>
+//   board <a8|h8|a1> <x> <y> <z>
+//   graveyard <white|black> <x y z> <step dx dy dz> <row dx dy dz>
+//   rack <white|black> <x y z> <step dx dy dz>
+//   heights <grasp> <above> <travel>
+//   ik <max iterations> <position tolerance m> <orientation tolerance deg>
+//   velocity <v1> ... <vn>                     (deg/s or m/s, default 90 deg/s or 0.1 m/s)
+//   acceleration <a1> ... <an>                 (deg/s^2 or m/s^2, default twice the velocity)
+//   gripper <seconds>
+bool load_arm_config(const char *path, arm_config_t *config);
+
+// Gripper target for a location at a height; false for an unknown location
+bool arm_location_position(const arm_config_t *config, int location, arm_height_t height, double position[3]);
+
+// Gripper position and approach axis for joint values q
+void arm_forward_kinematics(const arm_config_t *config, const double *q, double position[3], double approach[3]);
+
+// Damped least-squares solve for a downward-pointing gripper at target, starting from seed.
+// q receives the best pose found even when the solve does not converge.
+bool arm_solve_ik(const arm_config_t *config, const double target[3], const double *seed, double *q, ik_result_t *result);
+
+// Solve the pose table for every location and height; each entry is warm-started from the
+// nearest one already solved
+bool init_arm_kinematics(arm_kinematics_t *kinematics, const arm_config_t *config);
+
+// Online solve seeded from the table entry nearest to target
+bool arm_solve_ik_warm(const arm_kinematics_t *kinematics, const double target[3], double *q, ik_result_t *result);
+
+// arm_pose_solver_fn over the pose table, for build_trajectory_cache; context is an arm_kinematics_t
+bool arm_table_pose_solver(void *context, int location, arm_height_t height, joint_pose_t *pose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ARM_SIMULATOR_H
+#define ARM_SIMULATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arm/arm_kinematics.h"
+#include "arm/trajectory_cache.h"
+
+// Time a motion the way a joint-space controller executes it: straight lines between waypoints
+// under the per-joint velocity and acceleration limits, a full stop at every corner and wherever
+// the gripper opens or closes, and no stop between collinear waypoints such as a cached transit.
+// arrival receives the time each waypoint is reached (before any gripper actuation), may be NULL.
+// Returns the seconds from rest at start to the end of the motion, gripper actuation included.
+double time_arm_motion(const arm_config_t *config, const joint_pose_t *start, const arm_motion_t *motion, double *arrival);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef MOTION_SCHEDULER_H
+#define MOTION_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arm/arm_kinematics.h"
+#include "arm/arm_simulator.h"
+#include "arm/trajectory_cache.h"
+#include "game/move_converter.h"
+
+// A pick followed by the place of the same piece
+#define ARM_MAX_TRANSFERS (ARM_MAX_ACTIONS / 2)
+
+// Travel-time model over the trajectory cache, built once
+typedef struct {
+    const arm_config_t *config;
+    const trajectory_cache_t *cache;
+    float travel[ARM_LOCATIONS][ARM_LOCATIONS];     // seconds from above one location to above another via travel height
+    float handle[ARM_LOCATIONS];                    // seconds to descend, open or close the gripper and rise again
+    bool ready;
+} arm_scheduler_t;
+
+typedef struct {
+    arm_plan_t plan;            // scheduled order and graveyard slots
+    arm_motion_t motion;
+    int end_location;           // where the arm is left, the start_location of the next move
+    double baseline_s;          // estimate for the converter's own order and slots
+    double estimated_s;         // estimate for the scheduled plan
+    double simulated_s;         // scheduled motion timed waypoint by waypoint by the arm simulator
+} arm_schedule_t;
+
+// Fill the cost matrix from the joint poses of a built trajectory cache; keeps both pointers
+bool init_arm_scheduler(arm_scheduler_t *scheduler, const arm_config_t *config, const trajectory_cache_t *cache);
+
+// Estimated seconds to execute a plan with the arm starting above start_location (-1: above the first action)
+double estimate_plan_seconds(const arm_scheduler_t *scheduler, const arm_plan_t *plan, int start_location);
+
+// Convert a move and choose the transfer order and the free graveyard slots with the least
+// estimated travel. A piece is only placed on a location once every piece leaving it has been
+// picked. The converter's graveyard bookkeeping follows the chosen slots.
+bool schedule_arm_move(const arm_scheduler_t *scheduler, move_converter_t *converter, const move_t *move,
+                       int start_location, arm_schedule_t *schedule);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
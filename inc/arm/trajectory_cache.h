@@ -0,0 +1,48 @@
+#ifndef TRAJECTORY_CACHE_H
+#define TRAJECTORY_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/arm_types.h"
+
+// Waypoints of a cached transit between two locations at travel height, endpoints included
+#define ARM_TRANSIT_POINTS 8
+// A pick or place is a transit plus above, grasp and above again
+#define ARM_MAX_WAYPOINTS (ARM_MAX_ACTIONS * (ARM_TRANSIT_POINTS + 3))
+
+// Joint pose that puts the gripper at a location and height; supplied by the IK layer
+typedef bool (*arm_pose_solver_fn)(void *context, int location, arm_height_t height, joint_pose_t *pose);
+
+// Joint-space poses of every location and transits between every pair of locations, solved once
+typedef struct {
+    int n_joints;
+    joint_pose_t poses[ARM_LOCATIONS][ARM_HEIGHT_TRAVEL + 1];
+    joint_pose_t *transits;     // ARM_LOCATIONS x ARM_LOCATIONS x ARM_TRANSIT_POINTS
+    bool ready;
+} trajectory_cache_t;
+
+typedef struct {
+    arm_waypoint_t points[ARM_MAX_WAYPOINTS];   // gripper_closed is the gripper state once the point is reached
+    int n_points;
+} arm_motion_t;
+
+void init_trajectory_cache(trajectory_cache_t *cache);
+
+// Solve every location at every height and precompute all transits; fails if any pose is unreachable
+bool build_trajectory_cache(trajectory_cache_t *cache, int n_joints, arm_pose_solver_fn solver, void *context);
+void free_trajectory_cache(trajectory_cache_t *cache);
+
+// ARM_TRANSIT_POINTS poses from travel height over from to travel height over to
+const joint_pose_t *cached_transit(const trajectory_cache_t *cache, int from, int to);
+
+// Expand a pick/place plan into waypoints by table lookups only. start_location is where the arm
+// waits at travel height, or -1 to start directly above the first action.
+bool plan_arm_motion(const trajectory_cache_t *cache, const arm_plan_t *plan, int start_location, arm_motion_t *motion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef ARM_TYPES_H
+#define ARM_TYPES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+
+#define ARM_MAX_JOINTS 6
+
+// Places the arm can pick from or place on: the 64 squares, a graveyard slot per possibly
+// captured piece of each colour, and a promotion rack holding Q, R, B, N of each colour
+#define ARM_GRAVEYARD_SLOTS_PER_COLOR 16
+#define ARM_RACK_SLOTS_PER_COLOR 4
+#define ARM_SQUARE_LOCATIONS (BOARD_SIZE * BOARD_SIZE)
+#define ARM_GRAVEYARD_BASE ARM_SQUARE_LOCATIONS
+#define ARM_RACK_BASE (ARM_GRAVEYARD_BASE + 2 * ARM_GRAVEYARD_SLOTS_PER_COLOR)
+#define ARM_LOCATIONS (ARM_RACK_BASE + 2 * ARM_RACK_SLOTS_PER_COLOR)
+
+// At most three pick/place pairs: a promotion with capture removes the captured piece and the
+// pawn, then places the promoted piece
+#define ARM_MAX_ACTIONS 6
+
+typedef enum {
+    ARM_PICK = 0,
+    ARM_PLACE
+} arm_action_type_t;
+
+// One pick or place primitive; location is a square (row * 8 + col), graveyard or rack index
+typedef struct {
+    arm_action_type_t type;
+    int location;
+    piece_t piece;
+} arm_action_t;
+
+typedef struct {
+    arm_action_t actions[ARM_MAX_ACTIONS];
+    int n_actions;
+} arm_plan_t;
+
+// Heights above a location the arm moves through
+typedef enum {
+    ARM_HEIGHT_GRASP = 0,   // gripper around the piece
+    ARM_HEIGHT_ABOVE,       // just clear of the pieces
+    ARM_HEIGHT_TRAVEL       // safe height for moving across the board
+} arm_height_t;
+
+typedef struct {
+    double q[ARM_MAX_JOINTS];   // joint angles in radians (or metres for prismatic joints)
+} joint_pose_t;
+
+typedef struct {
+    joint_pose_t pose;
+    bool gripper_closed;
+} arm_waypoint_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,6 +9,7 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <fcntl.h>
@@ -19,6 +20,7 @@ extern "C" {
 
 #define BOARD_SIZE 8
 #define MAX_MOVES 1000
+#define MAX_LEGAL_MOVES 256
 #define MAX_UCI_RESPONSE 4096
 #define MAX_ENGINE_PATH 256
 #define MAX_MESSAGE_LEN 256
@@ -69,6 +71,7 @@ typedef struct {
     bool is_running;
     char response_buffer[MAX_UCI_RESPONSE];
     char engine_path[MAX_ENGINE_PATH];
+    bool echo;                  // print the UCI traffic to stdout; cleared by uci_start_engine
 } uci_engine_t;
 
 typedef enum {
@@ -96,16 +99,53 @@ typedef enum {
     MOVE_GAME_OVER
 } move_result_t;
 
+typedef enum {
+    RESULT_ONGOING = 0, RESULT_WHITE_WINS, RESULT_BLACK_WINS, RESULT_DRAW
+} game_result_t;
+
+typedef enum {
+    TERMINATION_NONE = 0,
+    TERMINATION_CHECKMATE,
+    TERMINATION_STALEMATE,
+    TERMINATION_TIMEOUT,
+    TERMINATION_RESIGNATION,
+    TERMINATION_AGREEMENT,
+    TERMINATION_REPETITION,             // threefold
+    TERMINATION_FIFTY_MOVES,
+    TERMINATION_INSUFFICIENT_MATERIAL,
+    TERMINATION_MOVE_LIMIT              // move history full
+} game_termination_t;
+
+typedef struct {
+    int64_t initial_ms;                 // 0: untimed
+    int64_t increment_ms;
+} time_control_t;
+
+// One game: position, legal moves, clocks and result. Owns no global state, so any number of
+// games can be hosted side by side; the caller supplies the time.
 typedef struct {
-    game_state_type_t state;
     chess_state_t chess;
+    time_control_t time_control;
+    int64_t remaining_ms[2];            // white, black
+    int64_t turn_started_ms;
+    uint64_t position_keys[MAX_MOVES + 1];  // after each move; [0] is the starting position
+    move_t legal_moves[MAX_LEGAL_MOVES];    // of the side to move
+    int n_legal_moves;
+    bool in_check;
+    game_result_t result;
+    game_termination_t termination;
+} game_t;
+
+typedef struct {
+    game_state_type_t state;
+    game_t game;
     uci_engine_t engine;
     player_type_t white_player;
     player_type_t black_player;
     char last_move[16];
     char status_message[MAX_MESSAGE_LEN];
-    bool game_over;
-    color_t winner;
+    struct arm_executor *arm;   // plays the engine's moves on the board; NULL without an arm
+    struct arm_sim_rig *sim_arm;    // owns arm when it is simulated
 } game_context_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,10 @@
+#ifndef CONSTANTS_H
+#define CONSTANTS_H
+
+// Side length in pixels of the rectified top-down board image used by vision
+#define VISION_BOARD_PIXELS 400
+#define VISION_SQUARE_PIXELS (VISION_BOARD_PIXELS / 8)
+// Cells per square side in the coarse board signature used to skip unchanged squares
+#define VISION_SIGNATURE_CELLS 5
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef VISION_TYPES_H
+#define VISION_TYPES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+
+typedef enum {
+    SQUARE_EMPTY = 0, SQUARE_WHITE_PIECE, SQUARE_BLACK_PIECE
+} square_occupancy_t;
+
+// One entry per square, indexed row * BOARD_SIZE + col (row 0 is rank 8)
+typedef struct {
+    unsigned char squares[BOARD_SIZE * BOARD_SIZE];
+} board_occupancy_t;
+
+// Per-stage processing time of one detection, in milliseconds
+typedef struct {
+    double preprocess_ms;   // signature, grayscale and blur
+    double diff_ms;         // differencing, thresholds and per-square statistics
+    double decide_ms;       // choosing the move
+    double total_ms;
+} vision_timings_t;
+
+// Structured result of one move detection
+typedef struct {
+    bool found;
+    int from_row, from_col;     // row 0 is rank 8
+    int to_row, to_col;
+    char uci[6];                // e.g. "e2e4" or "e7e8q", empty when nothing was found
+    double confidence;          // 0..1
+    vision_timings_t timings;
+} vision_detection_t;
+
+typedef enum {
+    VISION_CODEC_JPEG = 0,  // smallest files
+    VISION_CODEC_PNG,       // lossless; written at a fast compression level by default
+    VISION_CODEC_BMP        // no compression, cheapest to encode
+} vision_codec_t;
+
+// Debug-image output: which detections are annotated and how they are encoded
+typedef struct {
+    int queue_capacity;     // images waiting for the writer; more are dropped, never waited for
+    int sample_every;       // annotate every Nth detection; 1 for all, 0 for none but low-confidence ones
+    double low_confidence;  // also annotate every detection below this confidence; 0 disables
+    vision_codec_t codec;
+    int quality;            // JPEG quality 0..100 or PNG compression 0..9; negative for the default
+} vision_annotation_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
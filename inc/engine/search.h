@@ -0,0 +1,88 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+
+#define SEARCH_MAX_PLY 64
+#define SEARCH_MATE 30000               // mate in n plies scores SEARCH_MATE - n
+#define SEARCH_DEFAULT_HASH_MB 16
+
+// Zero fields are unlimited; with no limit at all the search runs to SEARCH_MAX_PLY or a stop
+typedef struct {
+    int depth;
+    int64_t movetime_ms;
+    int64_t nodes;
+    int64_t time_left_ms;               // side to move's clock, spent a slice per move
+    int64_t increment_ms;
+    int moves_to_go;                    // 0: sudden death
+} search_limits_t;
+
+// The last completed iteration
+typedef struct {
+    char best_move[6];                  // "" when the side to move has no legal move
+    int score;                          // centipawns for the side to move
+    int depth;
+    long nodes;
+    int64_t elapsed_ms;
+    char pv[SEARCH_MAX_PLY * 6];        // UCI moves separated by spaces
+} search_result_t;
+
+// Called after each completed iteration
+typedef void (*search_progress_fn)(const search_result_t *result, void *context);
+// Polled every few thousand nodes; true stops the search, which keeps its last completed iteration
+typedef bool (*search_stop_fn)(void *context);
+
+struct search_entry;
+
+// Iterative deepening alpha-beta over the legal move generator, with a transposition table,
+// move ordering (table move, captures by MVV-LVA, killers, history) and a captures-only
+// quiescence search. One engine searches one position at a time.
+typedef struct {
+    chess_state_t position;             // only the board and its flags are used, not the history
+    uint64_t keys[MAX_MOVES + SEARCH_MAX_PLY + 1];  // of every position reached, for repetitions
+    int n_keys;
+    struct search_entry *table;
+    size_t table_mask;
+    uint8_t generation;                 // ages table entries from earlier searches
+    uint16_t killers[SEARCH_MAX_PLY][2];
+    int history[64][64];
+    // Per search
+    long nodes;
+    int64_t start_ms;
+    int64_t deadline_ms;                // 0: none
+    int64_t node_limit;
+    int depth;                          // of the iteration running
+    bool stop_requested;                // a limit was hit or stop asked; honoured once depth 1 is done
+    bool stopped;
+    search_stop_fn stop;
+    void *stop_context;
+} search_engine_t;
+
+// hash_mb sizes the transposition table (rounded down to a power of two entries)
+bool init_search_engine(search_engine_t *engine, size_t hash_mb);
+void free_search_engine(search_engine_t *engine);
+
+// Forget the transposition table and move statistics, e.g. for a new game
+void clear_search_engine(search_engine_t *engine);
+
+// Search from this position. Moves that led to it are not known, so repetitions only count
+// from here on; search_play_move adds moves that do count.
+void search_set_position(search_engine_t *engine, const chess_state_t *chess);
+bool search_play_move(search_engine_t *engine, const char *uci_move);
+
+// Search the current position within limits. progress and stop may be NULL.
+bool search_best_move(search_engine_t *engine, const search_limits_t *limits, search_progress_fn progress,
+                      search_stop_fn stop, void *context, search_result_t *result);
+
+// Speak UCI on a pair of file descriptors until "quit" or end of input; the exit status
+int run_search_uci(int in_fd, int out_fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,20 @@ extern "C" {
 
 #include "common/chess_types.h"
 
+// Engine path that runs the built-in search (engine/search.h) in the engine process instead of
+// executing a binary; it also takes over when the binary cannot be executed
+#define UCI_INTERNAL_ENGINE "internal"
+
+// Progress of a running "go", assembled from the engine's info and bestmove lines
+typedef struct {
+    char pv_move[16];           // first move of the latest principal variation
+    int depth;
+    char best_move[16];
+    bool done;
+    char line[MAX_UCI_RESPONSE];    // partial output line carried over between reads
+    size_t line_length;
+} uci_search_t;
+
 bool uci_start_engine(uci_engine_t *engine, const char *path);
 void uci_stop_engine(uci_engine_t *engine);
 bool uci_send_command(uci_engine_t *engine, const char *command);
@@ -14,6 +28,11 @@ bool uci_read_response(uci_engine_t *engine, char *buffer, size_t buffer_size, i
 bool uci_get_best_move(uci_engine_t *engine, char *move_buffer, size_t buffer_size);
 bool uci_set_position(uci_engine_t *engine, const chess_state_t *chess);
 
+void uci_begin_search(uci_search_t *search);
+// Read whatever the engine printed within timeout_ms; true when the first PV move changed or the
+// search finished (best_move is then set, empty for "(none)")
+bool uci_poll_search(uci_engine_t *engine, uci_search_t *search, int timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
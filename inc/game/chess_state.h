@@ -13,6 +13,9 @@ void index_to_square(int row, int col, char *square);
 char piece_to_char(piece_t piece);
 void chess_state_to_fen(const chess_state_t *chess, char *fen_buffer, size_t buffer_size);
 
+// Set the position from a FEN string; the move history is left empty. False (chess unchanged) if malformed.
+bool chess_state_from_fen(chess_state_t *chess, const char *fen);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,116 @@
+#ifndef GAME_JOURNAL_H
+#define GAME_JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include "common/chess_types.h"
+
+#define JOURNAL_MAX_GAMES 256
+#define JOURNAL_QUEUE 1024
+#define JOURNAL_RECORD_ROOM (JOURNAL_QUEUE - JOURNAL_MAX_GAMES)    // the rest is kept for closes
+#define JOURNAL_CHECKPOINT_PLIES 32     // a FEN checkpoint follows every this many moves
+#define JOURNAL_FEN_MAX 96
+
+typedef enum {
+    JOURNAL_START = 1,      // key: initial_ms, clock_ms: increment_ms
+    JOURNAL_MOVE,           // move, clock_ms: mover's clock after the move, key: position key after it
+    JOURNAL_CHECKPOINT,     // ply: moves before it, followed by JOURNAL_FEN_MAX bytes of FEN
+    JOURNAL_END             // result, clock_ms: termination
+} journal_record_type_t;
+
+// One 32-byte journal record. The checksum covers the record and a checkpoint's FEN, so a write torn
+// by a crash is recognised and cut off when the game is resumed.
+typedef struct {
+    uint8_t type;
+    uint8_t result;
+    uint16_t move;          // from | to << 6 | promotion << 12 (0 none, 1-4 n, b, r, q)
+    int32_t clock_ms;
+    int64_t time_ms;        // wall clock
+    uint64_t key;
+    uint32_t ply;
+    uint32_t checksum;
+} journal_record_t;
+
+typedef struct {
+    int fd;                 // file the bytes are appended to
+    int action;             // write, sync and close, or close only
+    uint32_t length;
+    unsigned char data[sizeof(journal_record_t) + JOURNAL_FEN_MAX];
+} journal_entry_t;
+
+// Caller-side bookkeeping of one game's journal
+typedef struct {
+    int fd;                 // -1: not journaled
+    bool started;           // start record queued
+    int plies;              // moves queued so far
+    bool ended;
+    bool behind;            // records left out while the queue was full
+} journal_game_t;
+
+// Appends records for many games from one writer thread. The move path copies records into a
+// queue and never waits for the writer: when the queue is full, the records are left out and the
+// next journal_update_game for the game picks up from the last one queued. The writer appends
+// them and fdatasyncs the touched files at most every sync_interval_ms, so a process crash loses
+// nothing already queued to the kernel and a power loss at most the last interval.
+struct game_journal {
+    char dir[256];
+    int sync_interval_ms;
+    journal_game_t games[JOURNAL_MAX_GAMES];
+    int games_behind;                   // slots with records left out, to catch up with journal_update_game
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;             // queue filled, drained or synced
+    journal_entry_t queue[JOURNAL_QUEUE];
+    int head;
+    int count;
+    long queued;                        // entries ever queued
+    long synced;                        // of those, durable
+    int flush_waiters;                  // callers in flush_game_journal; the writer skips its wait
+    bool stop;
+    // Owned by the writer thread
+    journal_entry_t batch[JOURNAL_QUEUE];
+    int dirty[JOURNAL_QUEUE];
+    // Statistics
+    long records;
+    long syncs;
+    long overflows;                     // records left out for a later catch-up because the queue was full
+    long stalls;                        // closes that waited for a full queue
+};
+typedef struct game_journal game_journal_t;
+
+// Start the writer for journals kept in dir as game-<slot>.journal
+bool open_game_journal(game_journal_t *journal, const char *dir, int sync_interval_ms);
+
+// Begin a fresh journal for the game in a slot, replacing any earlier one
+bool journal_start_game(game_journal_t *journal, int slot, const game_t *game);
+
+// Append the moves played since the last call, checkpoints, and the result once the game is over.
+// Never waits for the writer; a slot left behind by a full queue catches up on a later call.
+void journal_update_game(game_journal_t *journal, int slot, const game_t *game);
+
+// Stop journaling a slot; discard removes its file, for games that need no resuming. Records the
+// slot is still behind on are lost, so catch it up first when the file is kept.
+void journal_close_game(game_journal_t *journal, int slot, bool discard);
+
+// Restore the game journaled in a slot and keep appending to it. The side to move's clock restarts
+// at now_ms; time the process was down is not charged. False if there is no usable journal.
+bool journal_resume_game(game_journal_t *journal, int slot, game_t *game, int64_t now_ms);
+
+// Block until everything queued so far is durable
+void flush_game_journal(game_journal_t *journal);
+
+// Flush, close every journal and join the writer
+void close_game_journal(game_journal_t *journal);
+
+// Read a journal file into game; false if it has no intact start record. *valid_length is the
+// length of the intact prefix, shorter than the file after a torn write.
+bool read_game_journal(const char *path, game_t *game, int64_t now_ms, size_t *valid_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef GAME_LOGIC_H
+#define GAME_LOGIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+
+// Zobrist position keys, shared by repetition detection, the journal and the search's table. A key
+// XORs one feature key per piece on its square, black to move, each castling right held, and the
+// en passant file when that capture can actually be played.
+#define POSITION_KEY_TURN 1000
+#define POSITION_KEY_CASTLING 1001      // white kingside, white queenside, black kingside, black queenside
+#define POSITION_KEY_EN_PASSANT 1010    // plus the file
+#define POSITION_KEY_FEATURES (POSITION_KEY_EN_PASSANT + BOARD_SIZE)
+
+static inline int position_key_piece(piece_t piece, int row, int col) {
+    return (row * BOARD_SIZE + col) * 12 + (piece.color == WHITE ? 0 : 6) + (piece.type - PAWN);
+}
+
+// Keys are derived from a fixed mix of the feature index instead of a random table, so there is
+// nothing to initialise; the search caches them in a table of its own
+static inline uint64_t position_feature_key(int feature) {
+    uint64_t z = (uint64_t)(feature + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t position_key(const chess_state_t *chess);
+
+// The en passant share of position_key: the file's key if the side to move has a legal en passant
+// capture, else 0
+uint64_t en_passant_key(const chess_state_t *chess);
+
+// Start a game from the initial position; NULL time_control: untimed
+void init_game(game_t *game, const time_control_t *time_control, int64_t now_ms);
+
+// Recompute the legal moves, the current position key and the rule-based endings after game->chess
+// was set directly, e.g. when a game is restored; earlier position keys must already be in place
+void refresh_game(game_t *game);
+
+// Play a move for the side to move. The mover's clock is charged up to now_ms (a flag fall ends
+// the game before the move), the increment added, and the new position adjudicated.
+move_result_t play_game_move(game_t *game, const char *uci_move, int64_t now_ms);
+
+// Adjudicate a flag fall without a move; true while the game goes on
+bool update_game_clock(game_t *game, int64_t now_ms);
+
+// Milliseconds left on a clock at now_ms, the running clock charged for the current turn; 0 when untimed
+int64_t game_time_left(const game_t *game, color_t color, int64_t now_ms);
+
+// The legal move matching a UCI string (case-insensitive promotion letter), NULL if none
+const move_t *find_game_move(const game_t *game, const char *uci_move);
+
+void resign_game(game_t *game, color_t color);
+void agree_draw(game_t *game);
+
+// COLOR_NONE while ongoing and for draws
+color_t game_winner(const game_t *game);
+
+// "1-0", "0-1", "1/2-1/2" or "*"
+const char *game_result_string(game_result_t result);
+const char *game_termination_string(game_termination_t termination);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef MOVE_CONVERTER_H
+#define MOVE_CONVERTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+#include "common/arm_types.h"
+
+// Off-board bookkeeping, per colour with white first
+typedef struct {
+    piece_type_t graveyard[2][ARM_GRAVEYARD_SLOTS_PER_COLOR];     // EMPTY while the slot is free
+    bool rack_used[2][ARM_RACK_SLOTS_PER_COLOR];
+} move_converter_t;
+
+void init_move_converter(move_converter_t *converter);
+
+// Location index of a square, graveyard slot or promotion-rack slot
+int square_location(int row, int col);
+int graveyard_location(color_t color, int slot);
+int rack_location(color_t color, piece_type_t type);
+
+// Turn a move into ordered pick/place primitives: captured pieces (including en passant) go to the
+// first free graveyard slot first, castling moves the king and then the rook, and a promotion swaps the
+// pawn for the rack piece, or for a captured piece of that type once the rack slot is used.
+// Fails when a graveyard is full or no piece of the promotion type is available.
+bool convert_move_to_actions(move_converter_t *converter, const move_t *move, arm_plan_t *plan);
+
+// Graveyard slot queries for a planner that picks its own slots
+bool graveyard_slot_free(const move_converter_t *converter, int location);
+// Record that the piece planned into graveyard slot from goes to the free slot to of the same colour instead
+bool reassign_graveyard_slot(move_converter_t *converter, int from, int to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,6 +13,10 @@ bool is_king_in_check(const chess_state_t *chess, color_t king_color);
 bool is_checkmate(const chess_state_t *chess);
 bool is_stalemate(const chess_state_t *chess);
 move_result_t make_move(chess_state_t *chess, const char *uci_move);
+// make_move for a move already known to be legal here, e.g. one from generate_legal_moves for this
+// position; it is not validated again
+move_result_t make_legal_move(chess_state_t *chess, const char *uci_move);
+int generate_legal_moves(const chess_state_t *chess, move_t *moves, int max_moves);
 
 #ifdef __cplusplus
 }
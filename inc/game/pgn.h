@@ -0,0 +1,83 @@
+#ifndef PGN_H
+#define PGN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+
+#define PGN_SAN_MAX 12
+#define PGN_MAX_TAGS 32
+#define PGN_TAG_NAME_MAX 32
+#define PGN_TAG_VALUE_MAX 256
+#define PGN_BUFFER 65536
+#define PGN_LINE_WIDTH 79
+
+typedef struct {
+    char name[PGN_TAG_NAME_MAX];
+    char value[PGN_TAG_VALUE_MAX];
+} pgn_tag_t;
+
+// Standard algebraic notation of a legal move in chess's position, with a check or mate suffix.
+// The position is played forward to find the suffix and restored before returning.
+bool move_to_san(chess_state_t *chess, const move_t *move, char *san, size_t san_size);
+
+// The legal move a SAN string names in chess's position (suffixes and annotations ignored);
+// false if it names none or more than one
+bool san_to_move(const chess_state_t *chess, const char *san, move_t *move);
+
+// SAN of each move in the history, replayed from start_fen (NULL: the initial position);
+// the number of moves converted
+int history_to_san(const chess_state_t *chess, const char *start_fen, char (*san)[PGN_SAN_MAX], int max_moves);
+
+// The seven-tag roster for a game (plus TimeControl and Termination); the number of tags filled
+int game_pgn_tags(const game_t *game, const char *white, const char *black, pgn_tag_t *tags, int max_tags);
+
+// Write one game: the tags in order, then the movetext wrapped at PGN_LINE_WIDTH. A FEN tag sets
+// the position the history starts from.
+bool write_pgn(FILE *file, const chess_state_t *chess, const pgn_tag_t *tags, int n_tags, const char *result);
+
+// One game as read: its tags and the position reached by replaying its moves
+typedef struct {
+    pgn_tag_t tags[PGN_MAX_TAGS];       // tags past PGN_MAX_TAGS are dropped, long values truncated
+    int n_tags;
+    chess_state_t chess;
+    char result[8];                     // "*" when the game has no result token
+    int plies;
+    bool error;                         // a move did not replay; the rest of the game was skipped
+    char error_message[128];
+} pgn_game_t;
+
+// Streams games out of a PGN file of any size through a fixed buffer. Comments, variations, NAGs
+// and escape lines are skipped.
+typedef struct {
+    int fd;
+    char buffer[PGN_BUFFER];
+    size_t length;
+    size_t position;
+    bool at_line_start;
+    bool eof;
+    // Totals
+    long games;
+    long moves;
+    long errors;
+    long long bytes;
+} pgn_reader_t;
+
+// path "-" reads standard input
+bool open_pgn_reader(pgn_reader_t *reader, const char *path);
+
+// Read and replay the next game; false once the input is exhausted
+bool read_pgn_game(pgn_reader_t *reader, pgn_game_t *game);
+
+void close_pgn_reader(pgn_reader_t *reader);
+
+// Value of a tag, NULL if the game has none
+const char *pgn_tag(const pgn_game_t *game, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
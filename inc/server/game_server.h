@@ -0,0 +1,90 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+#include "engine/uci_engine.h"
+
+#define SERVER_MAX_CLIENTS 1024
+#define SERVER_MAX_GAMES 256
+#define SERVER_LINE_MAX 1024
+#define SERVER_OUTPUT_MAX 16384
+
+// Line protocol, one request per line, one reply line per request:
+//   ping                          pong
+//   new [initial_s increment_s]   ok new <id>
+//   move <id> <uci>               ok move <id> <uci> <result>
+//   state <id>                    state <id> <result> <termination> <w|b> <white_ms> <black_ms> <fen>
+//   legal <id>                    legal <id> <count> <uci>...
+//   go <id> [movetime_ms]         ok go <id>, later bestmove <id> <uci> once the engine's move is played
+//                                 (at once for a forced move)
+//   watch <id> | unwatch          ok watch <id>; the game's events are then streamed:
+//                                 info <id> <depth> <pv move>, move <id> <uci> <result>
+//   resign <id> [w|b], draw <id>  ok resign <id>, ok draw <id>; resign defaults to the side to move
+//   close <id>                    ok close <id>
+//   quit
+// Failures reply "err <command> <reason>".
+typedef struct {
+    const char *unix_path;          // listen on this Unix-domain socket, or
+    int tcp_port;                   // on 127.0.0.1 when unix_path is NULL
+    const char *engine_path;        // NULL: "go" is refused
+    int movetime_ms;                // engine think time when "go" gives none
+    time_control_t time_control;    // for "new" without arguments
+    const char *journal_dir;        // journal games here and resume them on start; NULL: no journal
+    int journal_sync_ms;            // group commit interval of the journal writer
+} game_server_config_t;
+
+typedef struct {
+    int fd;
+    char input[SERVER_LINE_MAX];
+    size_t input_length;
+    char output[SERVER_OUTPUT_MAX];
+    size_t output_length;
+    int watching;                   // game whose events are streamed here, -1 none
+    bool want_write;                // EPOLLOUT registered while output is pending
+    bool closing;                   // disconnect once the output is flushed
+} server_client_t;
+
+typedef struct {
+    game_t *game;                   // NULL: free slot
+    bool pending;                   // queued for or being searched by the engine
+    int requester;                  // client waiting for the engine's move, -1 none
+    int movetime_ms;
+} server_game_t;
+
+typedef struct {
+    game_server_config_t config;
+    int listen_fd;
+    int epoll_fd;
+    server_client_t *clients[SERVER_MAX_CLIENTS];
+    server_game_t games[SERVER_MAX_GAMES];
+    uci_engine_t engine;
+    bool has_engine;
+    uci_search_t search;
+    int searching;                  // game the engine is searching, -1 idle
+    int queue[SERVER_MAX_GAMES];    // games waiting for the engine, oldest first
+    int queue_head;
+    int queue_count;
+    struct game_journal *journal;   // NULL without journal_dir
+    volatile sig_atomic_t stop;
+    long requests;
+} game_server_t;
+
+// Bind, listen and start the engine if one is configured
+bool start_game_server(game_server_t *server, const game_server_config_t *config);
+
+// Serve clients until stop_game_server, e.g. from a signal handler
+bool run_game_server(game_server_t *server);
+void stop_game_server(game_server_t *server);
+
+// Disconnect everyone, free the games, stop the engine and remove the socket file
+void close_game_server(game_server_t *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
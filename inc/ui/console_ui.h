@@ -6,9 +6,16 @@ extern "C" {
 #endif
 
 #include "common/chess_types.h"
+#include "arm/arm_executor.h"
 
 void init_game_context(game_context_t *ctx);
 void cleanup_game_context(game_context_t *ctx);
+
+// Play the engine's moves on a simulated arm described by arm_config_path, paced by time_scale
+// (1: real time). on_view, which may be NULL, is told when the arm enters or leaves the camera
+// view; vision_pipeline_arm_view makes a running vision pipeline ignore frames meanwhile.
+bool enable_console_arm(game_context_t *ctx, const char *arm_config_path, double time_scale,
+                        arm_view_fn on_view, void *view_context);
 game_state_type_t handle_menu_state(game_context_t *ctx);
 game_state_type_t handle_setup_state(game_context_t *ctx);
 game_state_type_t handle_playing_state(game_context_t *ctx);
@@ -0,0 +1,58 @@
+#ifndef ANNOTATION_WRITER_H
+#define ANNOTATION_WRITER_H
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/vision_types.h"
+
+// Mark the FROM square (red, "1") and the TO square (green, "2") on a board image
+void draw_move_annotation(cv::Mat& board, int from_row, int from_col, int to_row, int to_col);
+
+// Path an annotated image is written to: path itself when its extension names a supported codec
+// (.jpg/.jpeg, .png, .bmp), otherwise path with its extension replaced by the configured codec's
+std::string annotation_image_path(const vision_annotation_config_t& config, const std::string& path);
+
+// Encode to annotation_image_path(config, path). A supported extension selects the codec; the
+// configured quality only applies when it is the configured codec.
+bool write_annotation_image(const vision_annotation_config_t& config, const std::string& path, const cv::Mat& image);
+
+struct annotation_job {
+    cv::Mat board;
+    vision_detection_t detection;
+    std::string path;
+};
+
+// Background thread that draws and encodes annotated move images off the detection path.
+// The queue is bounded: when the writer falls behind, new images are dropped rather than
+// making the detector wait for the disk or the encoder.
+struct annotation_writer {
+    vision_annotation_config_t config;
+    std::deque<annotation_job> queue;
+    std::vector<cv::Mat> spare;     // written boards kept for reuse so queuing does not allocate
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::thread worker;
+    bool running;
+    bool stop;
+    long offered;                   // detections handed to queue_annotation
+    long dropped;                   // sampled detections lost to a full queue
+    long written;
+    long failed;
+};
+
+// Defaults (4 queued, every detection, JPEG quality 80) are used when config is NULL
+void start_annotation_writer(annotation_writer& writer, const vision_annotation_config_t* config);
+
+// Offer a detection for annotation. Returns true when it was sampled and queued; the board
+// is copied, so the caller's image is not kept.
+bool queue_annotation(annotation_writer& writer, const cv::Mat& board, const vision_detection_t& detection, const std::string& path);
+
+// Write every queued image, then join the thread
+void stop_annotation_writer(annotation_writer& writer);
+
+#endif // ANNOTATION_WRITER_H
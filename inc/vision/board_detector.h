@@ -0,0 +1,39 @@
+#ifndef BOARD_DETECTOR_H
+#define BOARD_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Camera intrinsics and board pose, as produced by an offline calibration
+struct board_calibration {
+    cv::Mat camera_matrix;   // 3x3 CV_64F (fx, fy, cx, cy)
+    cv::Mat dist_coeffs;     // 1x5 CV_64F (k1, k2, p1, p2, k3)
+    cv::Mat homography;      // 3x3 CV_64F, undistorted camera pixel -> normalised board [0,1]x[0,1]
+};
+
+// Precomputed fixed-point lookup table mapping every board pixel to its source camera pixel
+struct board_remap {
+    cv::Mat map_xy;          // CV_16SC2 integer source coordinates
+    cv::Mat map_frac;        // CV_16UC1 interpolation table indices
+    cv::Size frame_size;     // camera frame size the table was built for
+    int board_pixels;        // side length of the rectified output
+};
+
+// Load camera_matrix, dist_coeffs and homography from an OpenCV YAML/XML file
+bool load_board_calibration(const std::string& path, board_calibration& calib);
+
+// Load the shared camera intrinsics and a "boards" sequence with one homography (or board_corners)
+// per board, for several boards in one camera's view
+bool load_multi_board_calibration(const std::string& path, std::vector<board_calibration>& boards);
+
+// Homography from the four board corners (a8, h8, h1, a1 order) in undistorted camera pixels
+cv::Mat compute_board_homography(const cv::Point2f corners[4]);
+
+// Build the combined undistort + perspective + downscale table once per calibration
+bool build_board_remap(const board_calibration& calib, cv::Size frame_size, int board_pixels, board_remap& remap);
+
+// Rectify one camera frame into board_out with a single remap; board_out is reused across calls
+bool warp_board_frame(const board_remap& remap, const cv::Mat& frame, cv::Mat& board_out);
+
+#endif // BOARD_DETECTOR_H
\ No newline at end of file
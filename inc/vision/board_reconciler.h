@@ -0,0 +1,39 @@
+#ifndef BOARD_RECONCILER_H
+#define BOARD_RECONCILER_H
+
+#include <opencv2/opencv.hpp>
+#include "common/chess_types.h"
+#include "vision/occupancy_classifier.h"
+#include "vision/piece_recognizer.h"
+
+// How many moves past the last known position are searched for an explanation of the board
+#define RECONCILE_MAX_DEPTH 2
+
+typedef enum {
+    RECONCILE_FAILED = 0,
+    RECONCILE_UNCHANGED,    // the board still shows the last known position
+    RECONCILE_REPLAYED,     // one or two legal moves from the last known position explain the board
+    RECONCILE_REBUILT       // position rebuilt square by square; move history is not carried over
+} reconcile_method_t;
+
+struct reconcile_report {
+    reconcile_method_t method;
+    int moves_replayed;
+    char moves[RECONCILE_MAX_DEPTH][6];
+    int occupancy_mismatches;   // squares where the result disagrees with the observed occupancy
+    bool ambiguous;             // another explanation fitted equally well
+    char fen[128];
+    double elapsed_ms;
+};
+
+// Recover the game position from a single rectified board image.
+// The last known state, if any, is tried first: a short legal continuation whose occupancy matches
+// the image keeps castling rights and history intact. Otherwise every occupied square is identified
+// with the piece recognizer (or the last known piece of that colour on the square) under material
+// constraints: one king per side, at most eight pawns and none on the back ranks, promoted pieces
+// within the missing pawns, and the side not to move not in check.
+// last_known and pieces may be NULL; turn is used when rebuilding, COLOR_NONE keeps the last turn.
+bool reconcile_board_state(occupancy_classifier& classifier, piece_recognizer* pieces, const cv::Mat& board,
+                           const chess_state_t* last_known, color_t turn, chess_state_t* out, reconcile_report* report);
+
+#endif // BOARD_RECONCILER_H
@@ -0,0 +1,34 @@
+#ifndef BOARD_RENDERER_H
+#define BOARD_RENDERER_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "common/chess_types.h"
+
+// Synthetic top-down camera: renders a position as a rectified board image, so the vision code
+// can be exercised without a board, a camera or an arm
+struct board_renderer_config {
+    cv::Scalar light_square;   // BGR
+    cv::Scalar dark_square;
+    double noise_sigma;        // per-pixel Gaussian sensor noise, gray levels
+    double light_jitter;       // largest brightness offset between two renders, gray levels
+    std::string sprite_dir;    // wP.png ... bK.png, with an alpha channel; empty: built-in silhouettes
+    uint64_t seed;
+};
+
+struct board_renderer {
+    board_renderer_config config;
+    cv::Mat background;                  // the empty board
+    cv::Mat sprites[2][KING + 1];        // [colour - 1][piece type], one square in size
+    cv::Mat masks[2][KING + 1];
+    cv::Mat noise;                       // working buffer, reused between renders
+    cv::RNG rng;
+};
+
+// Defaults are used when config is NULL. False when a sprite file is missing or unreadable.
+bool init_board_renderer(board_renderer& renderer, const board_renderer_config* config);
+
+// Draw the position into board (VISION_BOARD_PIXELS square, BGR; its buffer is reused), row 0 at the top
+void render_board(board_renderer& renderer, const chess_state_t* chess, cv::Mat& board);
+
+#endif // BOARD_RENDERER_H
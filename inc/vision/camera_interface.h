@@ -0,0 +1,28 @@
+#ifndef CAMERA_INTERFACE_H
+#define CAMERA_INTERFACE_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// A live camera, a video file or a directory of still images replayed in name order
+struct camera_source {
+    cv::VideoCapture capture;
+    std::vector<std::string> image_files;
+    size_t next_image;
+    bool is_directory;
+    bool is_open;
+};
+
+// A number opens that camera device, a directory replays its images, anything else is opened as a video file
+bool open_camera_source(camera_source& source, const std::string& spec);
+
+// Read the next frame into frame (its buffer is reused when the size does not change); false at end of stream
+bool read_camera_frame(camera_source& source, cv::Mat& frame);
+
+// Skip one frame without decoding it where the backend allows
+bool skip_camera_frame(camera_source& source);
+
+void close_camera_source(camera_source& source);
+
+#endif // CAMERA_INTERFACE_H
\ No newline at end of file
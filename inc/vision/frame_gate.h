@@ -0,0 +1,46 @@
+#ifndef FRAME_GATE_H
+#define FRAME_GATE_H
+
+#include <opencv2/opencv.hpp>
+
+typedef enum {
+    GATE_MOVING = 0,    // frame-to-frame motion, e.g. a hand moving over the board
+    GATE_SETTLING,      // motion stopped but not yet for enough frames
+    GATE_OCCLUDED,      // settled, but too much of the board differs from the reference (hand or arm resting in view)
+    GATE_IDLE,          // settled and nothing new to analyse
+    GATE_STABLE         // settled with a plausible change: run the full detector on this frame
+} frame_gate_state;
+
+struct frame_gate_config {
+    int thumb_size;            // side of the downsampled gray thumbnail
+    double motion_threshold;   // mean absolute frame-to-frame difference (gray levels) still counted as still
+    int settle_frames;         // consecutive still frames required before a frame is trusted
+    double cell_threshold;     // mean absolute difference of an 8x8 grid cell against the reference counted as changed
+    int max_changed_cells;     // more changed cells than this means occlusion rather than a move
+};
+
+struct frame_gate {
+    frame_gate_config config;
+    cv::Mat small;
+    cv::Mat gray;
+    cv::Mat prev;
+    cv::Mat reference;
+    cv::Mat diff;
+    bool has_prev;
+    bool has_reference;
+    bool reported;             // STABLE already returned for the current settled period
+    int settled_count;
+    double motion_energy;      // last frame-to-frame motion
+    int changed_cells;         // last count of cells differing from the reference
+};
+
+// Defaults are used when config is NULL
+void init_frame_gate(frame_gate& gate, const frame_gate_config* config);
+
+// Classify a new frame; GATE_STABLE is returned at most once per settled period
+frame_gate_state update_frame_gate(frame_gate& gate, const cv::Mat& frame);
+
+// Make the current settled thumbnail the reference, e.g. after a move has been committed
+void set_frame_gate_reference(frame_gate& gate);
+
+#endif // FRAME_GATE_H
\ No newline at end of file
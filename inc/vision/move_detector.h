@@ -2,8 +2,16 @@
 #define CHESS_MOVE_DETECT_H
 
 #include <opencv2/opencv.hpp>
+#include <array>
 #include <string>
 #include <vector>
+#include "common/constants.h"
+#include "common/chess_types.h"
+#include "common/vision_types.h"
+#include "vision/annotation_writer.h"
+#include "vision/board_detector.h"
+#include "vision/occupancy_classifier.h"
+#include "vision/piece_recognizer.h"
 
 // Cấu trúc lưu thông tin một ô cờ
 struct square_info {
@@ -14,6 +22,64 @@ struct square_info {
     double avg_intensity_curr;
 };
 
+// Nước đi hợp lệ khớp nhất với bằng chứng thay đổi trên các ô
+struct legal_move_match {
+    move_t move;
+    double score;        // tổng thay đổi trên các ô nước đi chạm tới, trừ thay đổi trên các ô khác
+    double evidence;     // tỉ lệ điểm ảnh thay đổi trung bình trên mỗi ô nước đi chạm tới
+    double confidence;   // 0..1, khoảng cách giữa nước tốt nhất và nước tốt thứ hai
+};
+
+// Thời gian xử lý từng giai đoạn của lần phát hiện gần nhất (ms)
+struct detector_timings {
+    double preprocess_ms;   // chuyển xám + làm mờ
+    double diff_ms;         // trừ ảnh + ngưỡng + thống kê từng ô
+    double decide_ms;       // chọn nước đi
+};
+
+// Thống kê nhiễu học dần từ các khung hình đứng yên: mỗi khung hình đứng yên
+// lấy mẫu đầy đủ một ô, nên chi phí mỗi khung hình gần như không đổi
+struct detector_noise {
+    std::array<double, 64> pixel_mean;   // trung bình |hiệu| từng điểm ảnh của ô khi không có gì thay đổi
+    std::array<double, 64> pixel_var;
+    std::array<int, 64> samples;
+    double signature_level;   // độ lệch chữ ký lớn nhất trung bình của một ô sạch
+    double change_fraction;   // tỉ lệ điểm ảnh vượt ngưỡng trên ô đứng yên
+    int next_square;          // ô được lấy mẫu ở khung hình đứng yên tiếp theo
+};
+
+// Ngữ cảnh bộ phát hiện: sở hữu mọi bộ đệm của từng giai đoạn, cấp phát một lần.
+// Sau lần chạy đầu tiên, đường xử lý mỗi khung hình không cấp phát bộ nhớ heap.
+// Mỗi khung hình chỉ tính chữ ký thô của bàn cờ; các bước độ phân giải đầy đủ
+// chỉ chạy trên những ô có chữ ký lệch khỏi ảnh tham chiếu ("ô bẩn").
+// Độ sáng được bù theo hệ số khuếch đại cục bộ của từng ô, ước lượng từ chữ ký,
+// và điểm ảnh chỉ tối đi mà giữ nguyên sắc độ được coi là bóng đổ, không phải thay đổi.
+struct move_detector_context {
+    cv::Mat gray;           // ảnh xám chưa làm mờ của khung hình hiện tại
+    cv::Mat blur_tmp;       // kết quả lượt làm mờ theo chiều ngang (CV_16U)
+    cv::Mat ref_board;      // ảnh màu tham chiếu, dùng để nhận ra bóng đổ
+    cv::Mat prev_gray;      // ảnh tham chiếu đã làm mờ
+    cv::Mat curr_gray;      // chỉ hợp lệ trên các ô bẩn
+    cv::Mat diff_image;
+    cv::Mat thresh_image;   // bằng 0 trên mọi ô sạch
+    cv::Mat signature;      // độ sáng trung bình từng ô con, 8*VISION_SIGNATURE_CELLS mỗi chiều
+    cv::Mat ref_signature;
+    double signature_threshold;      // ngưỡng chữ ký tối thiểu; tăng theo noise.signature_level
+    double min_diff_score;           // tỉ lệ điểm ảnh thay đổi tối thiểu; tăng theo noise.change_fraction
+    std::array<bool, 64> dirty;
+    std::array<bool, 64> mask_set;   // ô có điểm khác 0 trong thresh_image cần xoá
+    std::array<double, 64> ref_mean; // độ sáng trung bình từng ô của ảnh tham chiếu
+    std::array<double, 64> gain;     // hệ số đưa độ sáng khung hình hiện tại về ảnh tham chiếu
+    detector_noise noise;
+    piece_recognizer* pieces;        // NULL: không kiểm tra loại quân; do người gọi sở hữu và hiệu chuẩn
+    occupancy_classifier* occupancy; // NULL: chỉ dùng ảnh thay đổi; do người gọi sở hữu và hiệu chuẩn
+    board_occupancy_t curr_occupancy; // ô trống/có quân của khung hình gần nhất có ô bẩn
+    int dirty_count;
+    std::array<square_info, 64> squares;
+    detector_timings timings;
+    bool has_reference;
+};
+
 // Hàm tính toán sự khác biệt giữa hai trạng thái bàn cờ
 std::vector<square_info> calculate_square_differences(
     const cv::Mat& diff_image,
@@ -22,11 +88,101 @@ std::vector<square_info> calculate_square_differences(
     int square_size
 );
 
-// Hàm phát hiện nước đi cờ vua dựa trên hai ảnh đầu vào
+// Như trên nhưng ghi vào mảng cố định 64 ô, không cấp phát
+void calculate_square_differences(
+    const cv::Mat& diff_image,
+    const cv::Mat& prev_gray,
+    const cv::Mat& curr_gray,
+    int square_size,
+    std::array<square_info, 64>& squares
+);
+
+// Cấp phát trước toàn bộ bộ đệm cho ảnh bàn cờ VISION_BOARD_PIXELS x VISION_BOARD_PIXELS
+void init_move_detector(move_detector_context& ctx);
+
+// Lưu ảnh bàn cờ tham chiếu (trước nước đi); chỉ xử lý một lần cho mọi khung hình sau đó
+bool set_move_detector_reference(move_detector_context& ctx, const cv::Mat& board);
+
+// Hai ô thay đổi nhiều nhất so với ảnh tham chiếu, đã phân biệt FROM/TO.
+// Trả về false ngay khi không có ô nào bẩn (bàn cờ đứng yên).
+bool detect_move_squares(
+    move_detector_context& ctx,
+    const cv::Mat& curr_board,
+    square_info& from_square,
+    square_info& to_square
+);
+
+// Nước đi hợp lệ khớp nhất giữa ảnh tham chiếu và khung hình hiện tại.
+// Khi ctx.pieces đã hiệu chuẩn, quân phong cấp được nhận dạng trên ô đích và độ tin cậy
+// giảm một nửa nếu quân nhìn thấy ở ô đích không phải quân đã đi.
+// Khi ctx.occupancy đã hiệu chuẩn, mỗi khung hình có ô bẩn được phân loại trống/có quân;
+// vector này được dùng để chấm điểm nước đi, và độ tin cậy giảm một nửa nếu riêng nó
+// chỉ ra một nước đi khác.
+bool detect_legal_move(
+    move_detector_context& ctx,
+    const chess_state_t* chess,
+    const cv::Mat& curr_board,
+    legal_move_match& match
+);
+
+// API thư viện: phát hiện nước đi so với ảnh tham chiếu và trả về kết quả có cấu trúc;
+// không in ra màn hình, không vẽ, không ghi ảnh trừ khi được yêu cầu.
+// chess khác NULL: chỉ chấp nhận nước đi hợp lệ của thế cờ; NULL: hai ô thay đổi nhiều nhất.
+// annotate khác NULL: khi tìm thấy nước đi, ảnh chú thích được vẽ và ghi ra annotate_path
+// trên luồng của annotation_writer.
+vision_detection_t detect(
+    move_detector_context& ctx,
+    const chess_state_t* chess,
+    const cv::Mat& curr_board,
+    annotation_writer* annotate = NULL,
+    const std::string& annotate_path = std::string()
+);
+
+// Như trên, giữa hai ảnh bàn cờ đã nắn thẳng, dùng bộ phát hiện riêng của luồng gọi
+vision_detection_t detect(
+    const chess_state_t* chess,
+    const cv::Mat& prev_board,
+    const cv::Mat& curr_board
+);
+
+// Hàm phát hiện nước đi cờ vua dựa trên hai ảnh đầu vào; ghi ảnh chú thích khi
+// output_image_path khác rỗng
 bool detect_chess_move(
     const std::string& prev_image_path,
     const std::string& curr_image_path,
     const std::string& output_image_path
 );
 
+// Phát hiện nước đi từ hai ảnh bàn cờ đã được nắn thẳng (VISION_BOARD_PIXELS x VISION_BOARD_PIXELS)
+bool detect_chess_move(
+    const cv::Mat& prev_board,
+    const cv::Mat& curr_board,
+    const std::string& output_image_path
+);
+
+// Phát hiện nước đi từ hai khung hình camera, nắn thẳng bằng một lần remap duy nhất
+bool detect_chess_move(
+    const board_remap& remap,
+    const cv::Mat& prev_frame,
+    const cv::Mat& curr_frame,
+    const std::string& output_image_path
+);
+
+// Chấm điểm mọi nước đi hợp lệ của thế cờ hiện tại dựa trên ảnh nhị phân thay đổi.
+// Chỉ các ô mà nước đi hợp lệ chạm tới mới được tính. curr_occupancy có thể là NULL.
+bool decode_legal_move(
+    const chess_state_t* chess,
+    const cv::Mat& change_mask,
+    const board_occupancy_t* curr_occupancy,
+    legal_move_match& match
+);
+
+// Phát hiện nước đi hợp lệ giữa hai ảnh bàn cờ đã nắn thẳng, dựa trên thế cờ hiện tại
+bool detect_chess_move(
+    const chess_state_t* chess,
+    const cv::Mat& prev_board,
+    const cv::Mat& curr_board,
+    legal_move_match& match
+);
+
 #endif // CHESS_MOVE_DETECT_H
@@ -0,0 +1,46 @@
+#ifndef MOVE_VOTE_H
+#define MOVE_VOTE_H
+
+#include "vision/move_detector.h"
+
+#define MOVE_VOTE_MAX_WINDOW 16
+
+// Commit a move only when K of the last N settled-frame results agree on it
+struct move_vote_config {
+    int window;     // N, at most MOVE_VOTE_MAX_WINDOW
+    int required;   // K
+};
+
+struct move_vote_entry {
+    bool found;
+    legal_move_match match;
+};
+
+struct move_vote {
+    move_vote_config config;
+    move_vote_entry entries[MOVE_VOTE_MAX_WINDOW];
+    int count;              // results in the window, up to config.window
+    int next;               // slot the next result overwrites
+    int64_t first_ticks;    // tick count of the first result since the last commit or reset
+};
+
+struct move_vote_result {
+    legal_move_match match;     // the agreed move; match.confidence is that of the committing frame
+    int votes;                  // results in the window naming this move
+    int window;                 // results in the window when it was committed
+    double confidence;          // votes / window times the mean per-frame confidence of those votes
+    double time_to_commit_ms;   // from the first result since the last reset to the committing one
+};
+
+// Defaults (3 of 5) are used when config is NULL
+void init_move_vote(move_vote& vote, const move_vote_config* config);
+
+// Forget every result, e.g. when the board moves again or the position changes
+void reset_move_vote(move_vote& vote);
+
+// Add one settled frame's result; found is false when the frame matched no legal move.
+// ticks is the frame's cv::getTickCount() timestamp. Returns true and fills result when
+// the move reaches the required votes; the window is then reset.
+bool add_move_vote(move_vote& vote, bool found, const legal_move_match& match, int64_t ticks, move_vote_result& result);
+
+#endif // MOVE_VOTE_H
@@ -0,0 +1,53 @@
+#ifndef MULTI_BOARD_VISION_H
+#define MULTI_BOARD_VISION_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/chess_types.h"
+#include "vision/board_detector.h"
+#include "vision/frame_gate.h"
+#include "vision/move_detector.h"
+#include "vision/move_vote.h"
+
+// One board in the camera's view, with its own rectification, reference and game position
+struct board_view {
+    board_remap remap;
+    cv::Mat board;                   // rectified VISION_BOARD_PIXELS board, reused every frame
+    frame_gate gate;
+    move_detector_context detector;
+    move_vote vote;
+    bool voting;
+    bool reference_stale;            // the next settled view becomes the reference
+    chess_state_t chess;             // this board's game, advanced by committed moves
+    chess_state_t pending_chess;
+    bool has_pending_chess;
+    std::mutex chess_mutex;
+    long detected;
+};
+
+// Called from the worker that processed the board; different boards may call it concurrently
+typedef std::function<void(int board, const move_vote_result& result, int64_t sequence)> multi_board_callback;
+
+struct multi_board_vision {
+    std::vector<std::unique_ptr<board_view>> boards;
+    multi_board_callback on_move;
+    int64_t sequence;
+};
+
+// Build one board_view per calibration for frames of frame_size; every board starts at chess.
+// gate and vote may be NULL for the defaults.
+bool init_multi_board_vision(multi_board_vision& vision, const std::vector<board_calibration>& boards, cv::Size frame_size,
+                             const chess_state_t* chess, const frame_gate_config* gate, const move_vote_config* vote,
+                             multi_board_callback on_move);
+
+// Rectify, gate and detect every board of one camera frame, boards spread over OpenCV's thread pool.
+// Returns the number of moves committed on this frame.
+int process_multi_board_frame(multi_board_vision& vision, const cv::Mat& frame);
+
+// Replace one board's position, e.g. after the engine or the arm has moved on it
+void set_multi_board_position(multi_board_vision& vision, int board, const chess_state_t* chess);
+
+#endif // MULTI_BOARD_VISION_H
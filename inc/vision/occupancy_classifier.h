@@ -0,0 +1,38 @@
+#ifndef OCCUPANCY_CLASSIFIER_H
+#define OCCUPANCY_CLASSIFIER_H
+
+#include <opencv2/opencv.hpp>
+#include "common/vision_types.h"
+
+// Colour/texture model of empty squares and pieces, learned from the starting position.
+// Index 0 is light squares, index 1 is dark squares.
+struct occupancy_classifier {
+    cv::Vec3d empty_bgr[2];       // mean colour of an empty square
+    double empty_edge[2];         // mean edge energy of an empty square
+    double colour_scale[2];       // spread of empty-square colour, used to normalise distances
+    double edge_scale[2];         // spread of empty-square edge energy
+    double occupied_threshold;    // occupancy score separating empty from occupied
+    double piece_split[2];        // centre brightness separating black pieces from white pieces
+    bool calibrated;
+    // Per-frame working buffers, reused between calls
+    cv::Mat gray;
+    cv::Mat laplacian;            // signed Laplacian (CV_16S), kept apart so neither buffer is reallocated
+    cv::Mat edges;
+};
+
+// Learn the model from a rectified board image showing the standard starting position
+bool calibrate_occupancy_classifier(occupancy_classifier& classifier, const cv::Mat& start_board);
+
+// Classify all 64 squares of a rectified BGR board image
+bool classify_board_occupancy(occupancy_classifier& classifier, const cv::Mat& board, board_occupancy_t* occupancy);
+
+// Expected occupancy of a known position
+void chess_state_to_occupancy(const chess_state_t* chess, board_occupancy_t* occupancy);
+
+// Number of squares whose occupancy differs; the first max_changed indices are written to changed
+int compare_board_occupancy(const board_occupancy_t* before, const board_occupancy_t* after, int* changed, int max_changed);
+
+// Infer the UCI move (normal, capture, castling, en passant) played by mover between two occupancy vectors
+bool occupancy_to_move(const board_occupancy_t* before, const board_occupancy_t* after, color_t mover, char* uci_move);
+
+#endif // OCCUPANCY_CLASSIFIER_H
\ No newline at end of file
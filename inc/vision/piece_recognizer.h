@@ -0,0 +1,44 @@
+#ifndef PIECE_RECOGNIZER_H
+#define PIECE_RECOGNIZER_H
+
+#include <opencv2/opencv.hpp>
+#include "common/chess_types.h"
+
+// Side of the square thumbnail a piece feature is computed from
+#define PIECE_FEATURE_CELLS 16
+#define PIECE_FEATURE_LENGTH (2 * PIECE_FEATURE_CELLS * PIECE_FEATURE_CELLS)
+
+// Normalised silhouette + gradient feature of one piece, averaged over its samples
+struct piece_template {
+    float feature[PIECE_FEATURE_LENGTH];
+    int samples;
+};
+
+// Per-piece-type template cache learned once from the starting position.
+// Templates are indexed [colour][piece type][square shade]; shade 0 is light squares.
+struct piece_recognizer {
+    piece_template templates[2][KING + 1][2];
+    double empty_gray[2];       // mean gray level of an empty square, per shade
+    bool calibrated;
+    // Working buffers, reused between calls
+    cv::Mat gray;
+    cv::Mat thumb;
+};
+
+// Build the template cache from a rectified board image showing the standard starting position
+bool calibrate_piece_recognizer(piece_recognizer& recognizer, const cv::Mat& start_board);
+
+// Template correlation (-1..1) of one square with every piece type of the given colour,
+// indexed by piece_type_t; scores[EMPTY] is -1
+bool piece_type_scores(piece_recognizer& recognizer, const cv::Mat& board, int row, int col, color_t color, double scores[KING + 1]);
+
+// Best matching piece type of the given colour on one square, among candidates (NULL for all six).
+// score is the correlation of the best template (-1..1); margin its lead over the runner-up.
+piece_type_t recognize_piece(piece_recognizer& recognizer, const cv::Mat& board, int row, int col, color_t color,
+                             const piece_type_t* candidates, int n_candidates, double* score, double* margin);
+
+// Check the piece standing on a move's destination: for a promotion the move is rewritten to the
+// recognised promotion piece, otherwise the return value says whether the moved piece was seen there
+bool verify_move_identity(piece_recognizer& recognizer, const cv::Mat& board, move_t* move, double* margin);
+
+#endif // PIECE_RECOGNIZER_H
@@ -0,0 +1,122 @@
+#ifndef VISION_PIPELINE_H
+#define VISION_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "common/chess_types.h"
+#include "vision/board_detector.h"
+#include "vision/camera_interface.h"
+#include "vision/frame_gate.h"
+#include "vision/move_detector.h"
+#include "vision/move_vote.h"
+
+#define VISION_RING_CAPACITY 4
+#define VISION_POOL_SIZE 16
+
+// Bounded single-producer/single-consumer ring of frame-pool indices.
+// When full, the producer drops the oldest entry so downstream latency stays bounded.
+struct frame_ring {
+    std::atomic<int> slots[VISION_RING_CAPACITY];
+    std::atomic<unsigned> head;   // next write position, advanced by the producer only
+    std::atomic<unsigned> tail;   // next read position, advanced by the consumer or by a dropping producer
+};
+
+// Push a frame index; if the ring was full the dropped index is stored in dropped, otherwise -1
+void frame_ring_push(frame_ring& ring, int frame, int* dropped);
+
+// Pop the oldest frame index; false when the ring is empty
+bool frame_ring_pop(frame_ring& ring, int* frame);
+
+// One pooled frame; its buffers keep their allocation as it cycles through the stages
+struct vision_frame {
+    cv::Mat raw;
+    cv::Mat board;
+    int64_t sequence;
+    int64_t capture_ticks;
+    frame_gate_state gate_state;
+    bool has_move;              // this frame committed a move
+    legal_move_match match;     // this frame's own detection
+    move_vote_result vote;      // the committed move, valid when has_move
+};
+
+struct vision_pipeline_config {
+    std::string source;              // camera_source spec
+    std::string output_dir;          // annotated move images are written here; empty disables output
+    vision_annotation_config_t output;   // sampling and codec for output_dir; queue_capacity 0 selects the defaults
+    const board_remap* remap;        // NULL when the source already delivers top-down board images
+    frame_gate_config gate;
+    move_vote_config vote;           // window 0 selects the defaults
+};
+
+struct vision_pipeline_stats {
+    std::atomic<long> captured;
+    std::atomic<long> dropped;       // frames discarded by drop-oldest or an exhausted pool, in total
+    std::atomic<long> dropped_source;       // not captured because every pool frame was in flight
+    std::atomic<long> dropped_preprocess;   // pushed out of to_preprocess
+    std::atomic<long> dropped_detect;       // pushed out of to_detect
+    std::atomic<long> dropped_output;       // pushed out of to_output
+    std::atomic<long> arm_hidden;    // frames ignored while the arm was in view
+    std::atomic<long> stable;        // frames that passed the gate
+    std::atomic<long> voted;         // settled frames run through the detector while a move was pending
+    std::atomic<long> detected;
+    std::atomic<long> written;
+    // Detect stage latency, from popping a frame to handing it on
+    std::atomic<long> detect_frames;
+    std::atomic<long> detect_us;
+    std::atomic<long> detect_worst_us;
+    std::atomic<long> detector_us;   // of which in detect_legal_move
+};
+
+typedef std::function<void(const move_vote_result& result, int64_t sequence)> vision_move_callback;
+
+struct vision_pipeline {
+    vision_pipeline_config config;
+    vision_annotation_config_t output;   // config.output with defaults filled in
+    vision_move_callback on_move;
+    camera_source source;
+    vision_frame pool[VISION_POOL_SIZE];
+    int free_frames[VISION_POOL_SIZE];
+    int free_count;
+    std::mutex pool_mutex;
+    frame_ring to_preprocess;
+    frame_ring to_detect;
+    frame_ring to_output;
+    // Detection state, owned by the detect thread except for the position hand-over
+    frame_gate gate;
+    move_detector_context detector;
+    move_vote vote;
+    bool voting;                     // a settled change is being voted on
+    chess_state_t chess;
+    chess_state_t pending_chess;
+    bool has_pending_chess;
+    std::mutex chess_mutex;
+    std::atomic<bool> arm_in_view;
+    std::thread threads[4];
+    std::atomic<bool> stop;
+    std::atomic<int> finished_stages;
+    vision_pipeline_stats stats;
+};
+
+// Start capture, preprocess, detect and annotate/output threads on a heap-allocated pipeline
+bool start_vision_pipeline(vision_pipeline& pipeline, const vision_pipeline_config& config, const chess_state_t* chess, vision_move_callback on_move);
+
+// Replace the position used for legal-move decoding, e.g. after the engine or the arm has moved
+void set_vision_pipeline_position(vision_pipeline& pipeline, const chess_state_t* chess);
+
+// While the arm is in view every frame is ignored; the first settled view after it leaves becomes
+// the new reference. Safe to call from the arm executor's view callback.
+void set_vision_pipeline_arm_in_view(vision_pipeline& pipeline, bool in_view);
+
+// The same as an arm_view_fn for start_arm_executor or enable_console_arm; context is the pipeline
+void vision_pipeline_arm_view(void* context, bool in_view);
+
+// Block until a finite source (video file, image directory) has been fully processed
+void wait_vision_pipeline(vision_pipeline& pipeline);
+
+void stop_vision_pipeline(vision_pipeline& pipeline);
+
+#endif // VISION_PIPELINE_H
\ No newline at end of file
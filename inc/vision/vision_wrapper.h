@@ -0,0 +1,52 @@
+#ifndef VISION_WRAPPER_H
+#define VISION_WRAPPER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common/chess_types.h"
+#include "common/vision_types.h"
+
+// C interface to the move detector for the game loop and UI
+typedef struct vision_detector vision_detector_t;
+
+// calibration_path may be NULL when images are already top-down views of the board
+vision_detector_t *vision_create_detector(const char *calibration_path);
+
+// Finishes any pending annotation writes before releasing the detector
+void vision_destroy_detector(vision_detector_t *detector);
+
+// Sampling and codec for annotated images; takes effect for the next detection.
+// NULL restores the defaults.
+void vision_set_annotation_config(vision_detector_t *detector, const vision_annotation_config_t *config);
+
+// Images are 8-bit BGR; stride is the row length in bytes
+bool vision_set_reference(vision_detector_t *detector, const unsigned char *bgr, int width, int height, size_t stride);
+bool vision_set_reference_image(vision_detector_t *detector, const char *image_path);
+
+// Learn piece templates and the occupancy model from an image of the starting position; later
+// detections then recognise promotion pieces and check the identity of the moved piece
+bool vision_calibrate_pieces(vision_detector_t *detector, const char *start_image_path);
+
+// Recover the position shown in one image, e.g. after a crash or a mis-detection. last_known may be
+// NULL; turn is used when the position has to be rebuilt (COLOR_NONE keeps last_known's turn).
+// Requires vision_calibrate_pieces(). fen may be NULL.
+bool vision_reconcile_image(vision_detector_t *detector, const char *image_path, const chess_state_t *last_known,
+                            color_t turn, chess_state_t *out, char *fen, size_t fen_size);
+
+// Detect the move between the reference and this image. chess may be NULL to report the two most
+// changed squares instead of a legal move. When annotate_path is not NULL and a move is found, an
+// annotated board image is written there on a background thread.
+vision_detection_t vision_detect(vision_detector_t *detector, const chess_state_t *chess, const unsigned char *bgr, int width, int height, size_t stride, const char *annotate_path);
+vision_detection_t vision_detect_image(vision_detector_t *detector, const chess_state_t *chess, const char *image_path, const char *annotate_path);
+
+// Where an annotated image for annotate_path is written: annotate_path itself when its extension
+// names a supported codec (.jpg, .jpeg, .png, .bmp), otherwise with the configured codec's extension
+bool vision_annotation_path(vision_detector_t *detector, const char *annotate_path, char *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,29 +1,19 @@
 #include "common/chess_types.h"
 #include "ui/console_ui.h"
-#include "vision/chess_move_detect.h"
+#include "vision/vision_wrapper.h"
 #include <iostream>
 #include <unistd.h>
 
-int main() {
-
-    std::string prev_image_path = "/home/lephuc/robotic-chess-playing-arm/reference_image/previous_w.png";
-    std::string curr_image_path = "/home/lephuc/robotic-chess-playing-arm/reference_image/previous_b.png";
-    std::string output_image_path = "/home/lephuc/robotic-chess-playing-arm/result.jpg";
-    
-    bool success = detect_chess_move(prev_image_path, curr_image_path, output_image_path);
-    
-    if (!success) {
-        std::cerr << "Không thể xử lý ảnh!" << std::endl;
-        return -1;
-    }
-    
-    return 0;
-}
-
-/*
-int main(void) {
+// Console game against the engine. With --arm, the engine's moves are also played by a simulated
+// arm described by an arm configuration file (config/arm.cfg).
+static int run_console(const char *arm_config_path) {
     game_context_t ctx;
     init_game_context(&ctx);
+    // The simulated arm runs in real time so its moves can be watched
+    if (arm_config_path && !enable_console_arm(&ctx, arm_config_path, 1.0, NULL, NULL)) {
+        cleanup_game_context(&ctx);
+        return -1;
+    }
 
     while (ctx.state != GAME_EXIT) {
         switch (ctx.state) {
@@ -62,5 +52,42 @@ int main(void) {
     std::cout << "\nThanks for playing!\n";
     return 0;
 }
-*/
 
+int main(int argc, char **argv) {
+
+    // Usage: robot_play_chess [prev_image] [curr_image] [output_image]
+    //        robot_play_chess --console [--arm arm.cfg]
+    if (argc > 1 && std::string(argv[1]) == "--console") {
+        return run_console(argc > 3 && std::string(argv[2]) == "--arm" ? argv[3] : NULL);
+    }
+    std::string prev_image_path = argc > 1 ? argv[1] : "../reference_image/previous_w.png";
+    std::string curr_image_path = argc > 2 ? argv[2] : "../reference_image/previous_b.png";
+    std::string output_image_path = argc > 3 ? argv[3] : "result.jpg";
+
+    vision_detector_t *detector = vision_create_detector(NULL);
+    if (!detector || !vision_set_reference_image(detector, prev_image_path.c_str())) {
+        std::cerr << "Không thể xử lý ảnh!" << std::endl;
+        vision_destroy_detector(detector);
+        return -1;
+    }
+    vision_detection_t result = vision_detect_image(detector, NULL, curr_image_path.c_str(), output_image_path.c_str());
+    // The writer keeps a .jpg/.png/.bmp name and gives any other name the codec's extension
+    char written_path[1024];
+    if (!vision_annotation_path(detector, output_image_path.c_str(), written_path, sizeof(written_path))) {
+        snprintf(written_path, sizeof(written_path), "%s", output_image_path.c_str());
+    }
+    // Waits for the annotated image to be written
+    vision_destroy_detector(detector);
+
+    if (!result.found) {
+        std::cerr << "Không thể xử lý ảnh!" << std::endl;
+        return -1;
+    }
+    std::cout << "Phát hiện nước đi thành công: " << result.uci << " (độ tin cậy " << result.confidence << ")" << std::endl;
+    std::cout << "FROM: Hàng " << result.from_row << ", Cột " << result.from_col << std::endl;
+    std::cout << "TO: Hàng " << result.to_row << ", Cột " << result.to_col << std::endl;
+    std::cout << "Ảnh kết quả đã lưu tại: " << written_path << std::endl;
+    std::cout << "Thời gian: " << result.timings.total_ms << " ms" << std::endl;
+
+    return 0;
+}
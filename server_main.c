@@ -0,0 +1,64 @@
+#include "server/game_server.h"
+
+static game_server_t server;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    stop_game_server(&server);
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--unix path | --tcp port] [--engine path|internal] [--movetime ms] [--clock initial_s increment_s] [--journal dir]\n", program);
+}
+
+int main(int argc, char **argv) {
+    // Usage: chess_server [--unix path | --tcp port] [--engine path|internal] [--movetime ms]
+    //                    [--clock initial_s increment_s] [--journal dir]
+    game_server_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.unix_path = "/tmp/chess_server.sock";
+    config.movetime_ms = 1000;
+    config.journal_sync_ms = 10;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--unix") == 0 && i + 1 < argc) {
+            config.unix_path = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+            config.unix_path = NULL;
+            config.tcp_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            config.engine_path = argv[++i];
+        } else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+            config.movetime_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--clock") == 0 && i + 2 < argc) {
+            config.time_control.initial_ms = (int64_t)(atof(argv[++i]) * 1000.0);
+            config.time_control.increment_ms = (int64_t)(atof(argv[++i]) * 1000.0);
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            config.journal_dir = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!start_game_server(&server, &config)) {
+        fprintf(stderr, "Error: Could not start the game server\n");
+        return 1;
+    }
+    if (config.unix_path) {
+        printf("Serving games on %s\n", config.unix_path);
+    } else {
+        printf("Serving games on 127.0.0.1:%d\n", config.tcp_port);
+    }
+    fflush(stdout);
+    bool ok = run_game_server(&server);
+    printf("Served %ld requests\n", server.requests);
+    close_game_server(&server);
+    return ok ? 0 : 1;
+}
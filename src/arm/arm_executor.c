@@ -0,0 +1,263 @@
+#include "arm/arm_executor.h"
+#include <time.h>
+
+static bool run_sim_arm(void *context, const joint_pose_t *start, const arm_motion_t *motion) {
+    arm_sim_backend_t *sim = (arm_sim_backend_t *)context;
+    double seconds = time_arm_motion(sim->config, start, motion, NULL);
+    sim->busy_s += seconds;
+    sim->motions++;
+    double sleep_s = seconds * sim->time_scale;
+    if (sleep_s > 0.0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)sleep_s;
+        ts.tv_nsec = (long)((sleep_s - ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+    }
+    return true;
+}
+
+arm_backend_t sim_arm_backend(arm_sim_backend_t *sim) {
+    arm_backend_t backend = {sim, run_sim_arm};
+    return backend;
+}
+
+static void set_in_view(arm_executor_t *executor, bool in_view) {
+    if (executor->in_view == in_view) return;
+    executor->in_view = in_view;
+    executor->view_changes++;
+    if (executor->on_view) executor->on_view(executor->view_context, in_view);
+}
+
+static bool run_motion(arm_executor_t *executor, const arm_motion_t *motion) {
+    if (motion->n_points == 0) return true;
+    set_in_view(executor, true);
+    if (!executor->backend.run(executor->backend.context, &executor->pose, motion)) {
+        fprintf(stderr, "Error: Arm backend failed to execute a motion\n");
+        executor->failures++;
+        return false;
+    }
+    executor->pose = motion->points[motion->n_points - 1].pose;
+    return true;
+}
+
+static void add_point(arm_motion_t *motion, const joint_pose_t *pose) {
+    arm_waypoint_t *point = &motion->points[motion->n_points++];
+    point->pose = *pose;
+    point->gripper_closed = false;
+}
+
+// Hover at travel height over where the move's schedule would pick first. The schedule is worked
+// out on a copy of the bookkeeping; the real move may still differ.
+static void execute_prepare(arm_executor_t *executor, const move_t *move) {
+    const arm_scheduler_t *scheduler = executor->scheduler;
+    move_converter_t converter = executor->converter;
+    arm_schedule_t schedule;
+    if (!schedule_arm_move(scheduler, &converter, move, executor->location, &schedule)) return;
+    int target = schedule.plan.actions[0].location;
+    if (target == executor->location) return;
+    arm_motion_t motion;
+    motion.n_points = 0;
+    if (executor->location >= 0) {
+        const joint_pose_t *transit = cached_transit(scheduler->cache, executor->location, target);
+        for (int i = 0; i < ARM_TRANSIT_POINTS; i++) add_point(&motion, &transit[i]);
+    } else {
+        add_point(&motion, &scheduler->cache->poses[target][ARM_HEIGHT_TRAVEL]);
+    }
+    if (run_motion(executor, &motion)) {
+        executor->location = target;
+        executor->prepares++;
+    }
+}
+
+static void execute_move(arm_executor_t *executor, const move_t *move) {
+    arm_schedule_t schedule;
+    if (!schedule_arm_move(executor->scheduler, &executor->converter, move, executor->location, &schedule)) {
+        fprintf(stderr, "Error: Could not plan arm motion for %s\n", move->notation);
+        executor->failures++;
+        return;
+    }
+    executor->last_move_estimated_s = schedule.estimated_s;
+    if (run_motion(executor, &schedule.motion)) {
+        executor->location = schedule.end_location;
+        executor->moves++;
+    }
+}
+
+static void execute_park(arm_executor_t *executor) {
+    if (executor->location >= 0) {
+        arm_motion_t motion;
+        motion.n_points = 0;
+        add_point(&motion, &executor->scheduler->cache->poses[executor->location][ARM_HEIGHT_TRAVEL]);
+        joint_pose_t home;
+        memset(&home, 0, sizeof(home));
+        memcpy(home.q, executor->scheduler->config->home, sizeof(double) * executor->scheduler->config->n_joints);
+        add_point(&motion, &home);
+        if (!run_motion(executor, &motion)) return;
+        executor->location = -1;
+    }
+    set_in_view(executor, false);
+}
+
+static void *executor_thread(void *arg) {
+    arm_executor_t *executor = (arm_executor_t *)arg;
+    pthread_mutex_lock(&executor->mutex);
+    while (true) {
+        while (executor->count == 0 && !executor->stop) {
+            executor->busy = false;
+            pthread_cond_broadcast(&executor->changed);
+            pthread_cond_wait(&executor->changed, &executor->mutex);
+        }
+        if (executor->count == 0) break;
+        arm_command_t command = executor->queue[executor->head];
+        executor->head = (executor->head + 1) % ARM_COMMAND_QUEUE;
+        executor->count--;
+        executor->busy = true;
+        pthread_mutex_unlock(&executor->mutex);
+
+        switch (command.type) {
+            case ARM_COMMAND_PREPARE: execute_prepare(executor, &command.move); break;
+            case ARM_COMMAND_MOVE:    execute_move(executor, &command.move); break;
+            case ARM_COMMAND_PARK:    execute_park(executor); break;
+        }
+        pthread_mutex_lock(&executor->mutex);
+    }
+    executor->busy = false;
+    pthread_cond_broadcast(&executor->changed);
+    pthread_mutex_unlock(&executor->mutex);
+    return NULL;
+}
+
+bool start_arm_executor(arm_executor_t *executor, const arm_scheduler_t *scheduler, arm_backend_t backend,
+                        arm_view_fn on_view, void *view_context) {
+    if (!executor || !scheduler || !scheduler->ready || !backend.run) return false;
+    memset(executor, 0, sizeof(*executor));
+    executor->scheduler = scheduler;
+    executor->backend = backend;
+    executor->on_view = on_view;
+    executor->view_context = view_context;
+    init_move_converter(&executor->converter);
+    executor->location = -1;
+    memcpy(executor->pose.q, scheduler->config->home, sizeof(double) * scheduler->config->n_joints);
+    pthread_mutex_init(&executor->mutex, NULL);
+    pthread_cond_init(&executor->changed, NULL);
+    if (pthread_create(&executor->thread, NULL, executor_thread, executor) != 0) {
+        fprintf(stderr, "Error: Could not start the arm executor thread\n");
+        pthread_cond_destroy(&executor->changed);
+        pthread_mutex_destroy(&executor->mutex);
+        return false;
+    }
+    return true;
+}
+
+// Queue a command; the caller holds the mutex
+static bool push_command(arm_executor_t *executor, arm_command_type_t type, const move_t *move) {
+    if (executor->count == ARM_COMMAND_QUEUE) return false;
+    arm_command_t *command = &executor->queue[(executor->head + executor->count) % ARM_COMMAND_QUEUE];
+    command->type = type;
+    if (move) command->move = *move;
+    executor->count++;
+    return true;
+}
+
+// Prepares are dropped, the rest of the queue is kept in order; the caller holds the mutex
+static void drop_prepares(arm_executor_t *executor) {
+    int kept = 0;
+    for (int i = 0; i < executor->count; i++) {
+        arm_command_t command = executor->queue[(executor->head + i) % ARM_COMMAND_QUEUE];
+        if (command.type == ARM_COMMAND_PREPARE) {
+            executor->prepares_replaced++;
+            continue;
+        }
+        executor->queue[(executor->head + kept++) % ARM_COMMAND_QUEUE] = command;
+    }
+    executor->count = kept;
+}
+
+bool arm_executor_prepare(arm_executor_t *executor, const move_t *move) {
+    if (!executor || !move) return false;
+    pthread_mutex_lock(&executor->mutex);
+    bool ok = true;
+    int last = (executor->head + executor->count - 1) % ARM_COMMAND_QUEUE;
+    if (executor->count > 0 && executor->queue[last].type == ARM_COMMAND_PREPARE) {
+        executor->queue[last].move = *move;
+        executor->prepares_replaced++;
+    } else {
+        ok = push_command(executor, ARM_COMMAND_PREPARE, move);
+    }
+    pthread_cond_broadcast(&executor->changed);
+    pthread_mutex_unlock(&executor->mutex);
+    return ok;
+}
+
+bool arm_executor_move(arm_executor_t *executor, const move_t *move) {
+    if (!executor || !move) return false;
+    pthread_mutex_lock(&executor->mutex);
+    drop_prepares(executor);
+    bool ok = executor->count + 2 <= ARM_COMMAND_QUEUE;
+    if (ok) {
+        push_command(executor, ARM_COMMAND_MOVE, move);
+        push_command(executor, ARM_COMMAND_PARK, NULL);
+    }
+    pthread_cond_broadcast(&executor->changed);
+    pthread_mutex_unlock(&executor->mutex);
+    return ok;
+}
+
+bool arm_executor_park(arm_executor_t *executor) {
+    if (!executor) return false;
+    pthread_mutex_lock(&executor->mutex);
+    drop_prepares(executor);
+    int last = (executor->head + executor->count - 1) % ARM_COMMAND_QUEUE;
+    // A move already ends with a park
+    bool ok = (executor->count > 0 && executor->queue[last].type == ARM_COMMAND_PARK) ||
+              push_command(executor, ARM_COMMAND_PARK, NULL);
+    if (ok) executor->parks++;
+    pthread_cond_broadcast(&executor->changed);
+    pthread_mutex_unlock(&executor->mutex);
+    return ok;
+}
+
+void arm_executor_wait(arm_executor_t *executor) {
+    if (!executor) return;
+    pthread_mutex_lock(&executor->mutex);
+    while (executor->count > 0 || executor->busy) pthread_cond_wait(&executor->changed, &executor->mutex);
+    pthread_mutex_unlock(&executor->mutex);
+}
+
+void stop_arm_executor(arm_executor_t *executor) {
+    if (!executor) return;
+    pthread_mutex_lock(&executor->mutex);
+    executor->stop = true;
+    pthread_cond_broadcast(&executor->changed);
+    pthread_mutex_unlock(&executor->mutex);
+    pthread_join(executor->thread, NULL);
+    pthread_cond_destroy(&executor->changed);
+    pthread_mutex_destroy(&executor->mutex);
+}
+
+bool start_sim_arm(arm_sim_rig_t *rig, const char *config_path, double time_scale, arm_view_fn on_view, void *view_context) {
+    if (!rig || !config_path) return false;
+    memset(rig, 0, sizeof(*rig));
+    init_trajectory_cache(&rig->cache);
+    if (!load_arm_config(config_path, &rig->config)) return false;
+    if (!init_arm_kinematics(&rig->kinematics, &rig->config) ||
+        !build_trajectory_cache(&rig->cache, rig->config.n_joints, arm_table_pose_solver, &rig->kinematics) ||
+        !init_arm_scheduler(&rig->scheduler, &rig->config, &rig->cache)) {
+        fprintf(stderr, "Error: Could not prepare the arm described in %s\n", config_path);
+        free_trajectory_cache(&rig->cache);
+        return false;
+    }
+    rig->sim.config = &rig->config;
+    rig->sim.time_scale = time_scale;
+    if (!start_arm_executor(&rig->executor, &rig->scheduler, sim_arm_backend(&rig->sim), on_view, view_context)) {
+        free_trajectory_cache(&rig->cache);
+        return false;
+    }
+    return true;
+}
+
+void stop_sim_arm(arm_sim_rig_t *rig) {
+    if (!rig) return;
+    stop_arm_executor(&rig->executor);
+    free_trajectory_cache(&rig->cache);
+}
@@ -0,0 +1,419 @@
+#include "arm/arm_kinematics.h"
+#include <math.h>
+#include <time.h>
+
+#define DEG_TO_RAD (M_PI / 180.0)
+// Metres per radian: weights the approach-axis error against the position error
+#define ARM_ORIENTATION_WEIGHT 0.1
+#define ARM_IK_DAMPING 0.02
+// Largest joint change per iteration, keeps the linearisation honest far from the target
+#define ARM_IK_MAX_STEP 0.25
+#define ARM_TABLE_ENTRIES (ARM_LOCATIONS * (ARM_HEIGHT_TRAVEL + 1))
+
+static const double DOWN[3] = {0.0, 0.0, -1.0};
+
+static int read_numbers(const char *text, double *values, int max) {
+    int n = 0;
+    char *end;
+    while (n < max) {
+        double value = strtod(text, &end);
+        if (end == text) break;
+        values[n++] = value;
+        text = end;
+    }
+    return n;
+}
+
+static int color_word(const char *word) {
+    if (strcmp(word, "white") == 0) return 0;
+    if (strcmp(word, "black") == 0) return 1;
+    return -1;
+}
+
+static double clamp_joint(const dh_joint_t *joint, double value) {
+    if (value < joint->min) return joint->min;
+    if (value > joint->max) return joint->max;
+    return value;
+}
+
+// Joint values in config units: degrees for revolute joints, metres for prismatic ones
+static double joint_unit(const dh_joint_t *joint) {
+    return joint->type == ARM_JOINT_REVOLUTE ? DEG_TO_RAD : 1.0;
+}
+
+bool load_arm_config(const char *path, arm_config_t *config) {
+    if (!path || !config) return false;
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open arm config %s\n", path);
+        return false;
+    }
+    memset(config, 0, sizeof(*config));
+    config->heights[ARM_HEIGHT_GRASP] = 0.02;
+    config->heights[ARM_HEIGHT_ABOVE] = 0.07;
+    config->heights[ARM_HEIGHT_TRAVEL] = 0.15;
+    config->max_iterations = 100;
+    config->position_tolerance = 0.0005;
+    config->orientation_tolerance = 1.0 * DEG_TO_RAD;
+    config->gripper_seconds = 0.3;
+
+    double home[ARM_MAX_JOINTS], velocity[ARM_MAX_JOINTS], acceleration[ARM_MAX_JOINTS];
+    int n_home = 0, n_velocity = 0, n_acceleration = 0;
+    bool have_board[3] = {false, false, false};
+    bool have_graveyard[2] = {false, false};
+    bool have_rack[2] = {false, false};
+    bool ok = true;
+    char line[256];
+    int line_number = 0;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        char key[16], word[16];
+        int consumed = 0;
+        if (sscanf(line, "%15s%n", key, &consumed) != 1) continue;
+        const char *rest = line + consumed;
+        double v[9];
+
+        if (strcmp(key, "joint") == 0) {
+            int used = 0;
+            if (config->n_joints >= ARM_MAX_JOINTS || sscanf(rest, "%15s%n", word, &used) != 1 ||
+                read_numbers(rest + used, v, 6) != 6) {
+                ok = false;
+            } else {
+                dh_joint_t *joint = &config->joints[config->n_joints++];
+                if (strcmp(word, "revolute") == 0) joint->type = ARM_JOINT_REVOLUTE;
+                else if (strcmp(word, "prismatic") == 0) joint->type = ARM_JOINT_PRISMATIC;
+                else ok = false;
+                joint->a = v[0];
+                joint->alpha = v[1] * DEG_TO_RAD;
+                joint->d = v[2];
+                joint->theta = v[3] * DEG_TO_RAD;
+                joint->min = v[4] * joint_unit(joint);
+                joint->max = v[5] * joint_unit(joint);
+                if (joint->min > joint->max) ok = false;
+            }
+        } else if (strcmp(key, "home") == 0) {
+            n_home = read_numbers(rest, home, ARM_MAX_JOINTS);
+        } else if (strcmp(key, "velocity") == 0) {
+            n_velocity = read_numbers(rest, velocity, ARM_MAX_JOINTS);
+        } else if (strcmp(key, "acceleration") == 0) {
+            n_acceleration = read_numbers(rest, acceleration, ARM_MAX_JOINTS);
+        } else if (strcmp(key, "gripper") == 0) {
+            if (read_numbers(rest, v, 1) != 1 || v[0] < 0) ok = false;
+            else config->gripper_seconds = v[0];
+        } else if (strcmp(key, "board") == 0) {
+            int used = 0;
+            int corner = -1;
+            if (sscanf(rest, "%15s%n", word, &used) == 1) {
+                if (strcmp(word, "a8") == 0) corner = 0;
+                else if (strcmp(word, "h8") == 0) corner = 1;
+                else if (strcmp(word, "a1") == 0) corner = 2;
+            }
+            if (corner < 0 || read_numbers(rest + used, v, 3) != 3) {
+                ok = false;
+            } else {
+                memcpy(config->board[corner], v, sizeof(config->board[corner]));
+                have_board[corner] = true;
+            }
+        } else if (strcmp(key, "graveyard") == 0 || strcmp(key, "rack") == 0) {
+            bool graveyard = key[0] == 'g';
+            int used = 0;
+            int ci = sscanf(rest, "%15s%n", word, &used) == 1 ? color_word(word) : -1;
+            int count = graveyard ? 9 : 6;
+            if (ci < 0 || read_numbers(rest + used, v, count) != count) {
+                ok = false;
+            } else if (graveyard) {
+                memcpy(config->graveyard[ci], v, sizeof(config->graveyard[ci]));
+                have_graveyard[ci] = true;
+            } else {
+                memcpy(config->rack[ci], v, sizeof(config->rack[ci]));
+                have_rack[ci] = true;
+            }
+        } else if (strcmp(key, "heights") == 0) {
+            if (read_numbers(rest, config->heights, ARM_HEIGHT_TRAVEL + 1) != ARM_HEIGHT_TRAVEL + 1) ok = false;
+        } else if (strcmp(key, "ik") == 0) {
+            if (read_numbers(rest, v, 3) != 3 || v[0] < 1 || v[1] <= 0 || v[2] <= 0) {
+                ok = false;
+            } else {
+                config->max_iterations = (int)v[0];
+                config->position_tolerance = v[1];
+                config->orientation_tolerance = v[2] * DEG_TO_RAD;
+            }
+        } else {
+            ok = false;
+        }
+    }
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Error: Invalid arm config entry at %s:%d\n", path, line_number);
+        return false;
+    }
+    if (config->n_joints == 0 || !have_board[0] || !have_board[1] || !have_board[2] ||
+        !have_graveyard[0] || !have_graveyard[1] || !have_rack[0] || !have_rack[1]) {
+        fprintf(stderr, "Error: Arm config %s needs joints, three board corners, both graveyards and both racks\n", path);
+        return false;
+    }
+    if ((n_home != 0 && n_home != config->n_joints) || (n_velocity != 0 && n_velocity != config->n_joints) ||
+        (n_acceleration != 0 && n_acceleration != config->n_joints)) {
+        fprintf(stderr, "Error: Arm config %s needs one home, velocity and acceleration value per joint\n", path);
+        return false;
+    }
+    for (int j = 0; j < config->n_joints; j++) {
+        const dh_joint_t *joint = &config->joints[j];
+        double unit = joint_unit(joint);
+        config->home[j] = clamp_joint(joint, n_home ? home[j] * unit : 0.0);
+        config->max_velocity[j] = n_velocity ? velocity[j] * unit : (joint->type == ARM_JOINT_REVOLUTE ? 90.0 * unit : 0.1);
+        config->max_acceleration[j] = n_acceleration ? acceleration[j] * unit : 2.0 * config->max_velocity[j];
+        if (config->max_velocity[j] <= 0 || config->max_acceleration[j] <= 0) {
+            fprintf(stderr, "Error: Arm config %s has a non-positive velocity or acceleration limit\n", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool arm_location_position(const arm_config_t *config, int location, arm_height_t height, double position[3]) {
+    if (!config || !position || location < 0 || location >= ARM_LOCATIONS ||
+        height < ARM_HEIGHT_GRASP || height > ARM_HEIGHT_TRAVEL) return false;
+    for (int k = 0; k < 3; k++) {
+        if (location < ARM_GRAVEYARD_BASE) {
+            // Squares are interpolated between the corner centres, so the board may sit at any angle
+            int row = location / BOARD_SIZE;
+            int col = location % BOARD_SIZE;
+            const double (*board)[3] = config->board;
+            position[k] = board[0][k] + (board[1][k] - board[0][k]) * col / (BOARD_SIZE - 1) +
+                          (board[2][k] - board[0][k]) * row / (BOARD_SIZE - 1);
+        } else if (location < ARM_RACK_BASE) {
+            int index = location - ARM_GRAVEYARD_BASE;
+            int slot = index % ARM_GRAVEYARD_SLOTS_PER_COLOR;
+            const double (*graveyard)[3] = config->graveyard[index / ARM_GRAVEYARD_SLOTS_PER_COLOR];
+            position[k] = graveyard[0][k] + graveyard[1][k] * (slot % BOARD_SIZE) + graveyard[2][k] * (slot / BOARD_SIZE);
+        } else {
+            int index = location - ARM_RACK_BASE;
+            const double (*rack)[3] = config->rack[index / ARM_RACK_SLOTS_PER_COLOR];
+            position[k] = rack[0][k] + rack[1][k] * (index % ARM_RACK_SLOTS_PER_COLOR);
+        }
+    }
+    position[2] += config->heights[height];
+    return true;
+}
+
+// Origin and z axis of every DH frame, base frame first; frame n is the gripper
+static void dh_frames(const arm_config_t *config, const double *q, double origins[][3], double axes[][3]) {
+    double r[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    double p[3] = {0, 0, 0};
+    for (int k = 0; k < 3; k++) {
+        origins[0][k] = p[k];
+        axes[0][k] = r[k][2];
+    }
+    for (int j = 0; j < config->n_joints; j++) {
+        const dh_joint_t *joint = &config->joints[j];
+        double theta = joint->theta + (joint->type == ARM_JOINT_REVOLUTE ? q[j] : 0.0);
+        double d = joint->d + (joint->type == ARM_JOINT_PRISMATIC ? q[j] : 0.0);
+        double ct = cos(theta), st = sin(theta);
+        double ca = cos(joint->alpha), sa = sin(joint->alpha);
+        // A = Rz(theta) Tz(d) Tx(a) Rx(alpha)
+        double a[3][3] = {{ct, -st * ca, st * sa}, {st, ct * ca, -ct * sa}, {0, sa, ca}};
+        double t[3] = {joint->a * ct, joint->a * st, d};
+        double next[3][3];
+        for (int row = 0; row < 3; row++) {
+            p[row] += r[row][0] * t[0] + r[row][1] * t[1] + r[row][2] * t[2];
+            for (int col = 0; col < 3; col++)
+                next[row][col] = r[row][0] * a[0][col] + r[row][1] * a[1][col] + r[row][2] * a[2][col];
+        }
+        memcpy(r, next, sizeof(r));
+        for (int k = 0; k < 3; k++) {
+            origins[j + 1][k] = p[k];
+            axes[j + 1][k] = r[k][2];
+        }
+    }
+}
+
+void arm_forward_kinematics(const arm_config_t *config, const double *q, double position[3], double approach[3]) {
+    if (!config || !q) return;
+    double origins[ARM_MAX_JOINTS + 1][3], axes[ARM_MAX_JOINTS + 1][3];
+    dh_frames(config, q, origins, axes);
+    if (position) memcpy(position, origins[config->n_joints], sizeof(double) * 3);
+    if (approach) memcpy(approach, axes[config->n_joints], sizeof(double) * 3);
+}
+
+static void cross(const double u[3], const double v[3], double out[3]) {
+    out[0] = u[1] * v[2] - u[2] * v[1];
+    out[1] = u[2] * v[0] - u[0] * v[2];
+    out[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+static double norm3(const double v[3]) {
+    return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+// Solve the symmetric positive definite 6x6 system m y = e in place by Cholesky
+static void cholesky_solve6(double m[6][6], double e[6]) {
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = m[i][j];
+            for (int k = 0; k < j; k++) sum -= m[i][k] * m[j][k];
+            m[i][j] = i == j ? sqrt(sum) : sum / m[j][j];
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        for (int k = 0; k < i; k++) e[i] -= m[i][k] * e[k];
+        e[i] /= m[i][i];
+    }
+    for (int i = 5; i >= 0; i--) {
+        for (int k = i + 1; k < 6; k++) e[i] -= m[k][i] * e[k];
+        e[i] /= m[i][i];
+    }
+}
+
+bool arm_solve_ik(const arm_config_t *config, const double target[3], const double *seed, double *q, ik_result_t *result) {
+    if (!config || !target || !q || config->n_joints < 1) return false;
+    int n = config->n_joints;
+    double origins[ARM_MAX_JOINTS + 1][3], axes[ARM_MAX_JOINTS + 1][3];
+    double best[ARM_MAX_JOINTS];
+    double best_cost = INFINITY;
+    ik_result_t local;
+    if (!result) result = &local;
+    memset(result, 0, sizeof(*result));
+    for (int j = 0; j < n; j++) q[j] = clamp_joint(&config->joints[j], seed ? seed[j] : config->home[j]);
+
+    for (int iteration = 0; ; iteration++) {
+        dh_frames(config, q, origins, axes);
+        double e[6], tilt[3];
+        for (int k = 0; k < 3; k++) e[k] = target[k] - origins[n][k];
+        cross(axes[n], DOWN, tilt);
+        double position_error = norm3(e);
+        double orientation_error = atan2(norm3(tilt), axes[n][0] * DOWN[0] + axes[n][1] * DOWN[1] + axes[n][2] * DOWN[2]);
+        double cost = position_error + ARM_ORIENTATION_WEIGHT * orientation_error;
+        if (cost < best_cost) {
+            best_cost = cost;
+            memcpy(best, q, sizeof(double) * n);
+            result->position_error = position_error;
+            result->orientation_error = orientation_error;
+        }
+        if (position_error <= config->position_tolerance && orientation_error <= config->orientation_tolerance) {
+            result->converged = true;
+            break;
+        }
+        if (iteration == config->max_iterations) break;
+        result->iterations = iteration + 1;
+        for (int k = 0; k < 3; k++) e[3 + k] = ARM_ORIENTATION_WEIGHT * tilt[k];
+
+        // Geometric Jacobian, orientation rows weighted like the error
+        double jac[6][ARM_MAX_JOINTS];
+        for (int j = 0; j < n; j++) {
+            double linear[3], reach[3];
+            if (config->joints[j].type == ARM_JOINT_REVOLUTE) {
+                for (int k = 0; k < 3; k++) reach[k] = origins[n][k] - origins[j][k];
+                cross(axes[j], reach, linear);
+            } else {
+                memcpy(linear, axes[j], sizeof(linear));
+            }
+            for (int k = 0; k < 3; k++) {
+                jac[k][j] = linear[k];
+                jac[3 + k][j] = config->joints[j].type == ARM_JOINT_REVOLUTE ? ARM_ORIENTATION_WEIGHT * axes[j][k] : 0.0;
+            }
+        }
+        // Damped least squares: dq = J^T (J J^T + lambda^2 I)^-1 e, well behaved at singularities
+        // and when the arm has more or fewer joints than constrained directions
+        double m[6][6];
+        for (int r = 0; r < 6; r++) {
+            for (int c = 0; c < 6; c++) {
+                double sum = r == c ? ARM_IK_DAMPING * ARM_IK_DAMPING : 0.0;
+                for (int j = 0; j < n; j++) sum += jac[r][j] * jac[c][j];
+                m[r][c] = sum;
+            }
+        }
+        cholesky_solve6(m, e);
+        for (int j = 0; j < n; j++) {
+            double step = 0.0;
+            for (int r = 0; r < 6; r++) step += jac[r][j] * e[r];
+            if (step > ARM_IK_MAX_STEP) step = ARM_IK_MAX_STEP;
+            if (step < -ARM_IK_MAX_STEP) step = -ARM_IK_MAX_STEP;
+            q[j] = clamp_joint(&config->joints[j], q[j] + step);
+        }
+    }
+    if (!result->converged) memcpy(q, best, sizeof(double) * n);
+    return result->converged;
+}
+
+// Table entry (location * heights + height) with the target closest to position, among the first count
+static int nearest_entry(const arm_kinematics_t *kinematics, const double position[3], int count) {
+    const float (*targets)[3] = kinematics->targets[0];
+    int nearest = -1;
+    double nearest_distance = INFINITY;
+    for (int i = 0; i < count; i++) {
+        double dx = targets[i][0] - position[0];
+        double dy = targets[i][1] - position[1];
+        double dz = targets[i][2] - position[2];
+        double distance = dx * dx + dy * dy + dz * dz;
+        if (distance < nearest_distance) {
+            nearest_distance = distance;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+static void table_seed(const arm_kinematics_t *kinematics, int entry, double *seed) {
+    const float *pose = kinematics->poses[0][0] + (size_t)entry * ARM_MAX_JOINTS;
+    for (int j = 0; j < kinematics->config.n_joints; j++) seed[j] = pose[j];
+}
+
+bool init_arm_kinematics(arm_kinematics_t *kinematics, const arm_config_t *config) {
+    if (!kinematics || !config || config->n_joints < 1 || config->n_joints > ARM_MAX_JOINTS) return false;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    memset(kinematics, 0, sizeof(*kinematics));
+    kinematics->config = *config;
+    int n = config->n_joints;
+    for (int loc = 0; loc < ARM_LOCATIONS; loc++) {
+        for (int h = ARM_HEIGHT_GRASP; h <= ARM_HEIGHT_TRAVEL; h++) {
+            int entry = loc * (ARM_HEIGHT_TRAVEL + 1) + h;
+            double target[3], seed[ARM_MAX_JOINTS], q[ARM_MAX_JOINTS];
+            arm_location_position(config, loc, (arm_height_t)h, target);
+            // Neighbouring squares differ by a few degrees per joint, so the nearest solved entry
+            // converges in a handful of iterations; fall back to home if it leads astray
+            int nearest = nearest_entry(kinematics, target, entry);
+            ik_result_t result;
+            bool solved = false;
+            if (nearest >= 0) {
+                table_seed(kinematics, nearest, seed);
+                solved = arm_solve_ik(config, target, seed, q, &result);
+                kinematics->build_iterations += result.iterations;
+            }
+            if (!solved) {
+                solved = arm_solve_ik(config, target, config->home, q, &result);
+                kinematics->build_iterations += result.iterations;
+            }
+            if (!solved) {
+                fprintf(stderr, "Error: Arm cannot reach location %d at height %d (%.1f mm, %.1f deg off)\n",
+                        loc, h, result.position_error * 1000.0, result.orientation_error / DEG_TO_RAD);
+                return false;
+            }
+            for (int k = 0; k < 3; k++) kinematics->targets[loc][h][k] = (float)target[k];
+            for (int j = 0; j < n; j++) kinematics->poses[loc][h][j] = (float)q[j];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    kinematics->build_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    kinematics->ready = true;
+    return true;
+}
+
+bool arm_solve_ik_warm(const arm_kinematics_t *kinematics, const double target[3], double *q, ik_result_t *result) {
+    if (!kinematics || !kinematics->ready || !target || !q) return false;
+    double seed[ARM_MAX_JOINTS];
+    table_seed(kinematics, nearest_entry(kinematics, target, ARM_TABLE_ENTRIES), seed);
+    return arm_solve_ik(&kinematics->config, target, seed, q, result);
+}
+
+bool arm_table_pose_solver(void *context, int location, arm_height_t height, joint_pose_t *pose) {
+    const arm_kinematics_t *kinematics = (const arm_kinematics_t *)context;
+    if (!kinematics || !kinematics->ready || !pose || location < 0 || location >= ARM_LOCATIONS ||
+        height < ARM_HEIGHT_GRASP || height > ARM_HEIGHT_TRAVEL) return false;
+    memset(pose, 0, sizeof(*pose));
+    for (int j = 0; j < kinematics->config.n_joints; j++) pose->q[j] = kinematics->poses[location][height][j];
+    return true;
+}
@@ -0,0 +1,82 @@
+#include "arm/arm_simulator.h"
+#include <math.h>
+
+// Cosine between successive segment directions above which the arm does not stop at the joint
+#define ARM_SIM_COLLINEAR 0.999
+
+typedef struct {
+    double length;                      // joint-space distance
+    double direction[ARM_MAX_JOINTS];
+    double max_speed;                   // along the segment, from the slowest joint for this direction
+    double max_acceleration;
+} sim_segment_t;
+
+static void measure_segment(const arm_config_t *config, const joint_pose_t *from, const joint_pose_t *to, sim_segment_t *segment) {
+    int n = config->n_joints;
+    double squared = 0.0;
+    for (int j = 0; j < n; j++) {
+        segment->direction[j] = to->q[j] - from->q[j];
+        squared += segment->direction[j] * segment->direction[j];
+    }
+    segment->length = sqrt(squared);
+    segment->max_speed = INFINITY;
+    segment->max_acceleration = INFINITY;
+    for (int j = 0; j < n; j++) {
+        if (segment->length > 0.0) segment->direction[j] /= segment->length;
+        double share = fabs(segment->direction[j]);
+        if (share <= 0.0) continue;
+        if (config->max_velocity[j] / share < segment->max_speed) segment->max_speed = config->max_velocity[j] / share;
+        if (config->max_acceleration[j] / share < segment->max_acceleration) segment->max_acceleration = config->max_acceleration[j] / share;
+    }
+}
+
+// Trapezoidal (or triangular) profile over length, entering at v0 and leaving at v1
+static double profile_seconds(const sim_segment_t *segment, double v0, double v1) {
+    double length = segment->length;
+    double acc = segment->max_acceleration;
+    if (length <= 0.0) return 0.0;
+    double peak = sqrt((2.0 * acc * length + v0 * v0 + v1 * v1) / 2.0);
+    if (peak > segment->max_speed) peak = segment->max_speed;
+    double ramps = (2.0 * peak * peak - v0 * v0 - v1 * v1) / (2.0 * acc);
+    double cruise = length > ramps ? length - ramps : 0.0;
+    return (2.0 * peak - v0 - v1) / acc + cruise / peak;
+}
+
+double time_arm_motion(const arm_config_t *config, const joint_pose_t *start, const arm_motion_t *motion, double *arrival) {
+    if (!config || !start || !motion || motion->n_points < 1 || motion->n_points > ARM_MAX_WAYPOINTS) return 0.0;
+    int n = motion->n_points;
+    sim_segment_t segments[ARM_MAX_WAYPOINTS];
+    bool actuates[ARM_MAX_WAYPOINTS];
+    double through[ARM_MAX_WAYPOINTS];      // speed carried through each waypoint
+    bool gripper_closed = false;
+    for (int k = 0; k < n; k++) {
+        measure_segment(config, k == 0 ? start : &motion->points[k - 1].pose, &motion->points[k].pose, &segments[k]);
+        actuates[k] = motion->points[k].gripper_closed != gripper_closed;
+        gripper_closed = motion->points[k].gripper_closed;
+    }
+    for (int k = 0; k < n; k++) {
+        through[k] = 0.0;
+        if (k == n - 1 || actuates[k] || segments[k].length <= 0.0 || segments[k + 1].length <= 0.0) continue;
+        double cosine = 0.0;
+        for (int j = 0; j < config->n_joints; j++) cosine += segments[k].direction[j] * segments[k + 1].direction[j];
+        if (cosine < ARM_SIM_COLLINEAR) continue;
+        through[k] = segments[k].max_speed < segments[k + 1].max_speed ? segments[k].max_speed : segments[k + 1].max_speed;
+    }
+    // Backward pass: never arrive faster than the rest of the path allows braking for
+    for (int k = n - 2; k >= 0; k--) {
+        double limit = sqrt(through[k + 1] * through[k + 1] + 2.0 * segments[k + 1].max_acceleration * segments[k + 1].length);
+        if (through[k] > limit) through[k] = limit;
+    }
+    // Forward pass: never faster than accelerating from the previous waypoint allows
+    double seconds = 0.0;
+    double entry = 0.0;
+    for (int k = 0; k < n; k++) {
+        double limit = sqrt(entry * entry + 2.0 * segments[k].max_acceleration * segments[k].length);
+        if (through[k] > limit) through[k] = limit;
+        seconds += profile_seconds(&segments[k], entry, through[k]);
+        if (arrival) arrival[k] = seconds;
+        if (actuates[k]) seconds += config->gripper_seconds;
+        entry = through[k];
+    }
+    return seconds;
+}
@@ -0,0 +1,167 @@
+#include "arm/motion_scheduler.h"
+#include <math.h>
+
+typedef struct {
+    int from;
+    int to;                                             // as planned by the converter
+    piece_t piece;
+    int candidates[ARM_GRAVEYARD_SLOTS_PER_COLOR + 1];  // possible destinations, to first
+    int n_candidates;
+} transfer_t;
+
+typedef struct {
+    const arm_scheduler_t *scheduler;
+    transfer_t transfers[ARM_MAX_TRANSFERS];
+    int n_transfers;
+    int order[ARM_MAX_TRANSFERS];
+    int to[ARM_MAX_TRANSFERS];          // chosen destination per transfer
+    bool done[ARM_MAX_TRANSFERS];
+    int best_order[ARM_MAX_TRANSFERS];
+    int best_to[ARM_MAX_TRANSFERS];
+    double best_cost;
+} schedule_search_t;
+
+// Stop-to-stop time of the slowest joint under a trapezoidal velocity profile
+static double point_to_point_seconds(const arm_config_t *config, const joint_pose_t *a, const joint_pose_t *b) {
+    double seconds = 0.0;
+    for (int j = 0; j < config->n_joints; j++) {
+        double distance = fabs(b->q[j] - a->q[j]);
+        double v = config->max_velocity[j];
+        double acc = config->max_acceleration[j];
+        double t = distance >= v * v / acc ? distance / v + v / acc : 2.0 * sqrt(distance / acc);
+        if (t > seconds) seconds = t;
+    }
+    return seconds;
+}
+
+bool init_arm_scheduler(arm_scheduler_t *scheduler, const arm_config_t *config, const trajectory_cache_t *cache) {
+    if (!scheduler || !config || !cache || !cache->ready || cache->n_joints != config->n_joints) return false;
+    scheduler->config = config;
+    scheduler->cache = cache;
+    double rise[ARM_LOCATIONS];
+    for (int loc = 0; loc < ARM_LOCATIONS; loc++) {
+        const joint_pose_t *poses = cache->poses[loc];
+        rise[loc] = point_to_point_seconds(config, &poses[ARM_HEIGHT_ABOVE], &poses[ARM_HEIGHT_TRAVEL]);
+        scheduler->handle[loc] = (float)(2.0 * point_to_point_seconds(config, &poses[ARM_HEIGHT_ABOVE], &poses[ARM_HEIGHT_GRASP]) +
+                                         config->gripper_seconds);
+    }
+    for (int from = 0; from < ARM_LOCATIONS; from++) {
+        for (int to = 0; to < ARM_LOCATIONS; to++) {
+            double transit = point_to_point_seconds(config, &cache->poses[from][ARM_HEIGHT_TRAVEL], &cache->poses[to][ARM_HEIGHT_TRAVEL]);
+            scheduler->travel[from][to] = (float)(rise[from] + transit + rise[to]);
+        }
+    }
+    scheduler->ready = true;
+    return true;
+}
+
+static double transfer_seconds(const arm_scheduler_t *scheduler, int at, int from, int to) {
+    double seconds = scheduler->handle[from] + scheduler->travel[from][to] + scheduler->handle[to];
+    if (at >= 0) seconds += scheduler->travel[at][from];
+    return seconds;
+}
+
+double estimate_plan_seconds(const arm_scheduler_t *scheduler, const arm_plan_t *plan, int start_location) {
+    if (!scheduler || !scheduler->ready || !plan) return 0.0;
+    double seconds = 0.0;
+    int at = start_location;
+    for (int i = 0; i + 1 < plan->n_actions; i += 2) {
+        seconds += transfer_seconds(scheduler, at, plan->actions[i].location, plan->actions[i + 1].location);
+        at = plan->actions[i + 1].location;
+    }
+    return seconds;
+}
+
+static bool is_graveyard(int location) {
+    return location >= ARM_GRAVEYARD_BASE && location < ARM_RACK_BASE;
+}
+
+// Depth-first over transfer orders and destinations, pruned by the best complete schedule so far
+static void search_schedule(schedule_search_t *search, int depth, int at, double cost) {
+    if (cost >= search->best_cost) return;
+    if (depth == search->n_transfers) {
+        search->best_cost = cost;
+        memcpy(search->best_order, search->order, sizeof(search->order));
+        memcpy(search->best_to, search->to, sizeof(search->to));
+        return;
+    }
+    for (int k = 0; k < search->n_transfers; k++) {
+        if (search->done[k]) continue;
+        const transfer_t *transfer = &search->transfers[k];
+        for (int c = 0; c < transfer->n_candidates; c++) {
+            int to = transfer->candidates[c];
+            // A location takes a piece only after every piece leaving it has been picked
+            bool blocked = false;
+            for (int j = 0; j < search->n_transfers; j++)
+                if (j != k && !search->done[j] && search->transfers[j].from == to) blocked = true;
+            if (blocked) continue;
+            search->done[k] = true;
+            search->order[depth] = k;
+            search->to[k] = to;
+            search_schedule(search, depth + 1, to, cost + transfer_seconds(search->scheduler, at, transfer->from, to));
+            search->done[k] = false;
+        }
+    }
+}
+
+bool schedule_arm_move(const arm_scheduler_t *scheduler, move_converter_t *converter, const move_t *move,
+                       int start_location, arm_schedule_t *schedule) {
+    if (!scheduler || !scheduler->ready || !converter || !move || !schedule) return false;
+    arm_plan_t planned;
+    if (!convert_move_to_actions(converter, move, &planned)) return false;
+
+    schedule_search_t search;
+    memset(&search, 0, sizeof(search));
+    search.scheduler = scheduler;
+    search.n_transfers = planned.n_actions / 2;
+    search.best_cost = INFINITY;
+    for (int k = 0; k < search.n_transfers; k++) {
+        const arm_action_t *pick = &planned.actions[2 * k];
+        const arm_action_t *place = &planned.actions[2 * k + 1];
+        transfer_t *transfer = &search.transfers[k];
+        transfer->from = pick->location;
+        transfer->to = place->location;
+        transfer->piece = pick->piece;
+        transfer->candidates[transfer->n_candidates++] = place->location;
+    }
+    // Any other free slot of the same colour will do for a piece going to the graveyard, except
+    // the slots the converter reserved for the other transfers of this move
+    for (int k = 0; k < search.n_transfers; k++) {
+        transfer_t *transfer = &search.transfers[k];
+        if (!is_graveyard(transfer->to)) continue;
+        int first = transfer->to - (transfer->to - ARM_GRAVEYARD_BASE) % ARM_GRAVEYARD_SLOTS_PER_COLOR;
+        for (int slot = first; slot < first + ARM_GRAVEYARD_SLOTS_PER_COLOR; slot++) {
+            bool reserved = false;
+            for (int j = 0; j < search.n_transfers; j++)
+                if (search.transfers[j].to == slot) reserved = true;
+            if (!reserved && graveyard_slot_free(converter, slot))
+                transfer->candidates[transfer->n_candidates++] = slot;
+        }
+    }
+    search_schedule(&search, 0, start_location, 0.0);
+
+    schedule->plan.n_actions = 0;
+    for (int i = 0; i < search.n_transfers; i++) {
+        int k = search.best_order[i];
+        const transfer_t *transfer = &search.transfers[k];
+        int to = search.best_to[k];
+        if (to != transfer->to) reassign_graveyard_slot(converter, transfer->to, to);
+        arm_action_t *pick = &schedule->plan.actions[schedule->plan.n_actions++];
+        pick->type = ARM_PICK;
+        pick->location = transfer->from;
+        pick->piece = transfer->piece;
+        arm_action_t *place = &schedule->plan.actions[schedule->plan.n_actions++];
+        place->type = ARM_PLACE;
+        place->location = to;
+        place->piece = transfer->piece;
+        schedule->end_location = to;
+    }
+    schedule->baseline_s = estimate_plan_seconds(scheduler, &planned, start_location);
+    schedule->estimated_s = search.best_cost;
+    if (!plan_arm_motion(scheduler->cache, &schedule->plan, start_location, &schedule->motion)) return false;
+
+    const joint_pose_t *start = start_location >= 0 ? &scheduler->cache->poses[start_location][ARM_HEIGHT_ABOVE]
+                                                    : &schedule->motion.points[0].pose;
+    schedule->simulated_s = time_arm_motion(scheduler->config, start, &schedule->motion, NULL);
+    return true;
+}
@@ -0,0 +1,87 @@
+#include "arm/trajectory_cache.h"
+#include <math.h>
+
+void init_trajectory_cache(trajectory_cache_t *cache) {
+    if (!cache) return;
+    cache->n_joints = 0;
+    cache->transits = NULL;
+    cache->ready = false;
+}
+
+bool build_trajectory_cache(trajectory_cache_t *cache, int n_joints, arm_pose_solver_fn solver, void *context) {
+    if (!cache || !solver || n_joints < 1 || n_joints > ARM_MAX_JOINTS) return false;
+    cache->ready = false;
+    cache->n_joints = n_joints;
+    for (int loc = 0; loc < ARM_LOCATIONS; loc++) {
+        for (int h = ARM_HEIGHT_GRASP; h <= ARM_HEIGHT_TRAVEL; h++) {
+            memset(&cache->poses[loc][h], 0, sizeof(joint_pose_t));
+            if (!solver(context, loc, (arm_height_t)h, &cache->poses[loc][h])) {
+                fprintf(stderr, "Error: No arm pose for location %d at height %d\n", loc, h);
+                return false;
+            }
+        }
+    }
+    if (!cache->transits) {
+        cache->transits = calloc((size_t)ARM_LOCATIONS * ARM_LOCATIONS * ARM_TRANSIT_POINTS, sizeof(joint_pose_t));
+        if (!cache->transits) return false;
+    }
+    // Joint-space interpolation with cosine spacing: dense near both ends where the arm
+    // accelerates and decelerates, sparse in the middle of the move
+    double s[ARM_TRANSIT_POINTS];
+    for (int i = 0; i < ARM_TRANSIT_POINTS; i++)
+        s[i] = 0.5 - 0.5 * cos(M_PI * i / (ARM_TRANSIT_POINTS - 1));
+    for (int from = 0; from < ARM_LOCATIONS; from++) {
+        const joint_pose_t *a = &cache->poses[from][ARM_HEIGHT_TRAVEL];
+        for (int to = 0; to < ARM_LOCATIONS; to++) {
+            const joint_pose_t *b = &cache->poses[to][ARM_HEIGHT_TRAVEL];
+            joint_pose_t *transit = &cache->transits[((size_t)from * ARM_LOCATIONS + to) * ARM_TRANSIT_POINTS];
+            for (int i = 0; i < ARM_TRANSIT_POINTS; i++) {
+                memset(&transit[i], 0, sizeof(joint_pose_t));
+                for (int j = 0; j < n_joints; j++)
+                    transit[i].q[j] = a->q[j] + s[i] * (b->q[j] - a->q[j]);
+            }
+        }
+    }
+    cache->ready = true;
+    return true;
+}
+
+void free_trajectory_cache(trajectory_cache_t *cache) {
+    if (!cache) return;
+    free(cache->transits);
+    cache->transits = NULL;
+    cache->ready = false;
+}
+
+const joint_pose_t *cached_transit(const trajectory_cache_t *cache, int from, int to) {
+    if (!cache || !cache->ready || from < 0 || from >= ARM_LOCATIONS || to < 0 || to >= ARM_LOCATIONS) return NULL;
+    return &cache->transits[((size_t)from * ARM_LOCATIONS + to) * ARM_TRANSIT_POINTS];
+}
+
+static void add_waypoint(arm_motion_t *motion, const joint_pose_t *pose, bool gripper_closed) {
+    arm_waypoint_t *point = &motion->points[motion->n_points++];
+    point->pose = *pose;
+    point->gripper_closed = gripper_closed;
+}
+
+bool plan_arm_motion(const trajectory_cache_t *cache, const arm_plan_t *plan, int start_location, arm_motion_t *motion) {
+    if (!cache || !cache->ready || !plan || !motion || plan->n_actions > ARM_MAX_ACTIONS) return false;
+    motion->n_points = 0;
+    int at = start_location;
+    bool gripper_closed = false;
+    for (int i = 0; i < plan->n_actions; i++) {
+        const arm_action_t *action = &plan->actions[i];
+        int loc = action->location;
+        if (loc < 0 || loc >= ARM_LOCATIONS) return false;
+        if (at >= 0) {
+            const joint_pose_t *transit = cached_transit(cache, at, loc);
+            for (int p = 0; p < ARM_TRANSIT_POINTS; p++) add_waypoint(motion, &transit[p], gripper_closed);
+        }
+        add_waypoint(motion, &cache->poses[loc][ARM_HEIGHT_ABOVE], gripper_closed);
+        gripper_closed = action->type == ARM_PICK;
+        add_waypoint(motion, &cache->poses[loc][ARM_HEIGHT_GRASP], gripper_closed);
+        add_waypoint(motion, &cache->poses[loc][ARM_HEIGHT_ABOVE], gripper_closed);
+        at = loc;
+    }
+    return true;
+}
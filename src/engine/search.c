@@ -0,0 +1,627 @@
+#include "engine/search.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include "game/move_validation.h"
+#include <pthread.h>
+#include <strings.h>
+#include <time.h>
+
+#define INFINITE_SCORE 32000
+#define MATE_BOUND (SEARCH_MATE - SEARCH_MAX_PLY)   // scores beyond this are mates
+#define CHECK_INTERVAL 1024                         // nodes between limit checks, a power of two
+#define QUIESCE_MAX_PLY (SEARCH_MAX_PLY + 32)
+#define KEEP_KEYS 128                               // kept when the key history fills; older plies cannot repeat
+
+enum { BOUND_NONE = 0, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct search_entry {
+    uint64_t key;
+    int16_t score;                      // mates stored relative to the entry's position
+    uint16_t move;                      // see move_code
+    int8_t depth;
+    uint8_t bound;
+    uint8_t generation;
+};
+
+// What a move changes, to play it and take it back
+typedef struct {
+    piece_t board[BOARD_SIZE][BOARD_SIZE];
+    color_t turn;
+    bool castling[4];
+    char en_passant_target[3];
+    int halfmove_clock;
+    int fullmove_number;
+} saved_position_t;
+
+static void save_position(const chess_state_t *chess, saved_position_t *saved) {
+    memcpy(saved->board, chess->board, sizeof(saved->board));
+    saved->turn = chess->turn;
+    saved->castling[0] = chess->white_can_castle_kingside;
+    saved->castling[1] = chess->white_can_castle_queenside;
+    saved->castling[2] = chess->black_can_castle_kingside;
+    saved->castling[3] = chess->black_can_castle_queenside;
+    memcpy(saved->en_passant_target, chess->en_passant_target, sizeof(saved->en_passant_target));
+    saved->halfmove_clock = chess->halfmove_clock;
+    saved->fullmove_number = chess->fullmove_number;
+}
+
+static void restore_position(chess_state_t *chess, const saved_position_t *saved) {
+    memcpy(chess->board, saved->board, sizeof(saved->board));
+    chess->turn = saved->turn;
+    chess->white_can_castle_kingside = saved->castling[0];
+    chess->white_can_castle_queenside = saved->castling[1];
+    chess->black_can_castle_kingside = saved->castling[2];
+    chess->black_can_castle_queenside = saved->castling[3];
+    memcpy(chess->en_passant_target, saved->en_passant_target, sizeof(saved->en_passant_target));
+    chess->halfmove_clock = saved->halfmove_clock;
+    chess->fullmove_number = saved->fullmove_number;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// The shared position keys (game_logic.h), cached: the search updates its key move by move
+static uint64_t zobrist[POSITION_KEY_FEATURES];
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+
+static void init_zobrist(void) {
+    for (int i = 0; i < POSITION_KEY_FEATURES; i++) zobrist[i] = position_feature_key(i);
+}
+
+static uint64_t piece_key(piece_t piece, int row, int col) {
+    return zobrist[position_key_piece(piece, row, col)];
+}
+
+static uint64_t castling_key(const chess_state_t *chess) {
+    uint64_t key = 0;
+    if (chess->white_can_castle_kingside) key ^= zobrist[POSITION_KEY_CASTLING];
+    if (chess->white_can_castle_queenside) key ^= zobrist[POSITION_KEY_CASTLING + 1];
+    if (chess->black_can_castle_kingside) key ^= zobrist[POSITION_KEY_CASTLING + 2];
+    if (chess->black_can_castle_queenside) key ^= zobrist[POSITION_KEY_CASTLING + 3];
+    return key;
+}
+
+// from square (6 bits), to square (6 bits), promotion (3 bits: q r b n); 0 is no move
+static uint16_t move_code(const move_t *move) {
+    int promotion = 0;
+    switch (move->promotion_piece) {
+        case 'q': promotion = 1; break;
+        case 'r': promotion = 2; break;
+        case 'b': promotion = 3; break;
+        case 'n': promotion = 4; break;
+    }
+    return (uint16_t)((move->from_row * BOARD_SIZE + move->from_col) |
+                      ((move->to_row * BOARD_SIZE + move->to_col) << 6) | (promotion << 12));
+}
+
+// Play a move from the move generator. Unlike make_move it neither checks legality again nor
+// records history; a capture on a rook's corner also ends that side's castling right. Returns the
+// position key after the move from key, the key before it less its en passant share.
+static uint64_t apply_move(chess_state_t *chess, const move_t *move, uint64_t key) {
+    piece_t empty = {EMPTY, COLOR_NONE};
+    piece_t moving = chess->board[move->from_row][move->from_col];
+    piece_t target = chess->board[move->to_row][move->to_col];
+    bool capture = target.type != EMPTY || move->is_en_passant;
+
+    key ^= piece_key(moving, move->from_row, move->from_col) ^ castling_key(chess) ^ zobrist[POSITION_KEY_TURN];
+    if (target.type != EMPTY) key ^= piece_key(target, move->to_row, move->to_col);
+    chess->board[move->to_row][move->to_col] = moving;
+    chess->board[move->from_row][move->from_col] = empty;
+    if (move->is_castle) {
+        int rook_from = (move->to_col == 6) ? 7 : 0;
+        int rook_to = (move->to_col == 6) ? 5 : 3;
+        piece_t rook = chess->board[move->from_row][rook_from];
+        key ^= piece_key(rook, move->from_row, rook_from) ^ piece_key(rook, move->from_row, rook_to);
+        chess->board[move->from_row][rook_to] = rook;
+        chess->board[move->from_row][rook_from] = empty;
+    }
+    if (move->is_en_passant) {
+        key ^= piece_key(chess->board[move->from_row][move->to_col], move->from_row, move->to_col);
+        chess->board[move->from_row][move->to_col] = empty;
+    }
+    if (move->is_promotion) {
+        switch (move->promotion_piece) {
+            case 'r': chess->board[move->to_row][move->to_col].type = ROOK; break;
+            case 'b': chess->board[move->to_row][move->to_col].type = BISHOP; break;
+            case 'n': chess->board[move->to_row][move->to_col].type = KNIGHT; break;
+            default: chess->board[move->to_row][move->to_col].type = QUEEN; break;
+        }
+    }
+
+    strcpy(chess->en_passant_target, "-");
+    if (moving.type == PAWN && abs(move->to_row - move->from_row) == 2) {
+        index_to_square((move->from_row + move->to_row) / 2, move->from_col, chess->en_passant_target);
+    }
+
+    if (moving.type == KING) {
+        if (moving.color == WHITE) {
+            chess->white_can_castle_kingside = false;
+            chess->white_can_castle_queenside = false;
+        } else {
+            chess->black_can_castle_kingside = false;
+            chess->black_can_castle_queenside = false;
+        }
+    }
+    for (int end = 0; end < 2; end++) {
+        int row = end ? move->to_row : move->from_row;
+        int col = end ? move->to_col : move->from_col;
+        if (row == 7 && col == 0) chess->white_can_castle_queenside = false;
+        if (row == 7 && col == 7) chess->white_can_castle_kingside = false;
+        if (row == 0 && col == 0) chess->black_can_castle_queenside = false;
+        if (row == 0 && col == 7) chess->black_can_castle_kingside = false;
+    }
+
+    chess->halfmove_clock = (moving.type == PAWN || capture) ? 0 : chess->halfmove_clock + 1;
+    chess->turn = (chess->turn == WHITE) ? BLACK : WHITE;
+    if (chess->turn == WHITE) chess->fullmove_number++;
+
+    key ^= piece_key(chess->board[move->to_row][move->to_col], move->to_row, move->to_col) ^ castling_key(chess);
+    // Only a double pawn step sets an en passant target
+    if (chess->en_passant_target[0] != '-') key ^= en_passant_key(chess);
+    return key;
+}
+
+// Material and piece-square tables, from white's side with rank 8 first; a black piece reads
+// the mirrored square. The king's table blends from middlegame to endgame as pieces come off.
+static const int piece_values[7] = {0, 100, 320, 330, 500, 900, 0};
+static const int phase_weights[7] = {0, 0, 1, 1, 2, 4, 0};
+#define PHASE_TOTAL 24
+
+static const int8_t piece_squares[6][64] = {
+    {   0,   0,   0,   0,   0,   0,   0,   0,      // pawn
+       50,  50,  50,  50,  50,  50,  50,  50,
+       10,  10,  20,  30,  30,  20,  10,  10,
+        5,   5,  10,  25,  25,  10,   5,   5,
+        0,   0,   0,  20,  20,   0,   0,   0,
+        5,  -5, -10,   0,   0, -10,  -5,   5,
+        5,  10,  10, -20, -20,  10,  10,   5,
+        0,   0,   0,   0,   0,   0,   0,   0},
+    { -50, -40, -30, -30, -30, -30, -40, -50,      // knight
+      -40, -20,   0,   0,   0,   0, -20, -40,
+      -30,   0,  10,  15,  15,  10,   0, -30,
+      -30,   5,  15,  20,  20,  15,   5, -30,
+      -30,   0,  15,  20,  20,  15,   0, -30,
+      -30,   5,  10,  15,  15,  10,   5, -30,
+      -40, -20,   0,   5,   5,   0, -20, -40,
+      -50, -40, -30, -30, -30, -30, -40, -50},
+    { -20, -10, -10, -10, -10, -10, -10, -20,      // bishop
+      -10,   0,   0,   0,   0,   0,   0, -10,
+      -10,   0,   5,  10,  10,   5,   0, -10,
+      -10,   5,   5,  10,  10,   5,   5, -10,
+      -10,   0,  10,  10,  10,  10,   0, -10,
+      -10,  10,  10,  10,  10,  10,  10, -10,
+      -10,   5,   0,   0,   0,   0,   5, -10,
+      -20, -10, -10, -10, -10, -10, -10, -20},
+    {   0,   0,   0,   0,   0,   0,   0,   0,      // rook
+        5,  10,  10,  10,  10,  10,  10,   5,
+       -5,   0,   0,   0,   0,   0,   0,  -5,
+       -5,   0,   0,   0,   0,   0,   0,  -5,
+       -5,   0,   0,   0,   0,   0,   0,  -5,
+       -5,   0,   0,   0,   0,   0,   0,  -5,
+       -5,   0,   0,   0,   0,   0,   0,  -5,
+        0,   0,   0,   5,   5,   0,   0,   0},
+    { -20, -10, -10,  -5,  -5, -10, -10, -20,      // queen
+      -10,   0,   0,   0,   0,   0,   0, -10,
+      -10,   0,   5,   5,   5,   5,   0, -10,
+       -5,   0,   5,   5,   5,   5,   0,  -5,
+        0,   0,   5,   5,   5,   5,   0,  -5,
+      -10,   5,   5,   5,   5,   5,   0, -10,
+      -10,   0,   5,   0,   0,   0,   0, -10,
+      -20, -10, -10,  -5,  -5, -10, -10, -20},
+    { -30, -40, -40, -50, -50, -40, -40, -30,      // king, middlegame
+      -30, -40, -40, -50, -50, -40, -40, -30,
+      -30, -40, -40, -50, -50, -40, -40, -30,
+      -30, -40, -40, -50, -50, -40, -40, -30,
+      -20, -30, -30, -40, -40, -30, -30, -20,
+      -10, -20, -20, -20, -20, -20, -20, -10,
+       20,  20,   0,   0,   0,   0,  20,  20,
+       20,  30,  10,   0,   0,  10,  30,  20},
+};
+
+static const int8_t king_endgame_squares[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+// Centipawns for the side to move
+static int evaluate(const chess_state_t *chess) {
+    int score = 0;
+    int phase = 0;
+    int king_middle = 0;
+    int king_end = 0;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            piece_t piece = chess->board[r][c];
+            if (piece.type == EMPTY) continue;
+            int sign = (piece.color == WHITE) ? 1 : -1;
+            int square = (piece.color == WHITE) ? r * BOARD_SIZE + c : (BOARD_SIZE - 1 - r) * BOARD_SIZE + c;
+            phase += phase_weights[piece.type];
+            if (piece.type == KING) {
+                king_middle += sign * piece_squares[KING - 1][square];
+                king_end += sign * king_endgame_squares[square];
+            } else {
+                score += sign * (piece_values[piece.type] + piece_squares[piece.type - 1][square]);
+            }
+        }
+    }
+    if (phase > PHASE_TOTAL) phase = PHASE_TOTAL;
+    score += (king_middle * phase + king_end * (PHASE_TOTAL - phase)) / PHASE_TOTAL;
+    return (chess->turn == WHITE) ? score : -score;
+}
+
+// Mate scores count plies from the root; the table stores them counted from the entry's position
+static int score_to_table(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int score_from_table(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+static void push_key(search_engine_t *engine, uint64_t key) {
+    if (engine->n_keys >= (int)(sizeof(engine->keys) / sizeof(engine->keys[0]))) {
+        memmove(engine->keys, engine->keys + engine->n_keys - KEEP_KEYS, sizeof(uint64_t) * KEEP_KEYS);
+        engine->n_keys = KEEP_KEYS;
+    }
+    engine->keys[engine->n_keys++] = key;
+}
+
+// The current key less its en passant share, which apply_move starts from
+static uint64_t move_base_key(const search_engine_t *engine) {
+    uint64_t key = engine->keys[engine->n_keys - 1];
+    if (engine->position.en_passant_target[0] != '-') key ^= en_passant_key(&engine->position);
+    return key;
+}
+
+// The current position occurred before since the last capture or pawn move
+static bool is_repetition(const search_engine_t *engine) {
+    int current = engine->n_keys - 1;
+    int oldest = current - engine->position.halfmove_clock;
+    if (oldest < 0) oldest = 0;
+    for (int i = current - 2; i >= oldest; i -= 2) {
+        if (engine->keys[i] == engine->keys[current]) return true;
+    }
+    return false;
+}
+
+static void poll_limits(search_engine_t *engine) {
+    if ((engine->deadline_ms > 0 && now_ms() >= engine->deadline_ms) ||
+        (engine->node_limit > 0 && engine->nodes >= engine->node_limit) ||
+        (engine->stop && engine->stop(engine->stop_context))) {
+        engine->stop_requested = true;
+    }
+    // Depth 1 always completes, so there is a move to play however early the stop comes
+    if (engine->stop_requested && engine->depth > 1) engine->stopped = true;
+}
+
+static void count_node(search_engine_t *engine) {
+    if ((++engine->nodes & (CHECK_INTERVAL - 1)) == 0) poll_limits(engine);
+}
+
+// Ordering: the table's move, captures by most valuable victim then least valuable attacker,
+// queen promotions, killers, then quiet moves by history
+static void score_moves(const search_engine_t *engine, const move_t *moves, int n_moves, uint16_t table_move, int ply,
+                        int *scores) {
+    for (int i = 0; i < n_moves; i++) {
+        const move_t *move = &moves[i];
+        uint16_t code = move_code(move);
+        if (code == table_move) {
+            scores[i] = 1 << 30;
+        } else if (move->captured_piece.type != EMPTY || move->promotion_piece == 'q') {
+            scores[i] = (1 << 20) + piece_values[move->captured_piece.type] * 16 - move->moved_piece.type +
+                        (move->promotion_piece == 'q' ? piece_values[QUEEN] * 16 : 0);
+        } else if (ply < SEARCH_MAX_PLY && code == engine->killers[ply][0]) {
+            scores[i] = (1 << 19) + 1;
+        } else if (ply < SEARCH_MAX_PLY && code == engine->killers[ply][1]) {
+            scores[i] = 1 << 19;
+        } else {
+            scores[i] = engine->history[code & 63][(code >> 6) & 63];
+        }
+    }
+}
+
+// Bring the best-scored of the remaining moves to position i
+static void pick_move(move_t *moves, int *scores, int n_moves, int i) {
+    int best = i;
+    for (int j = i + 1; j < n_moves; j++) {
+        if (scores[j] > scores[best]) best = j;
+    }
+    if (best == i) return;
+    move_t move = moves[i];
+    moves[i] = moves[best];
+    moves[best] = move;
+    int score = scores[i];
+    scores[i] = scores[best];
+    scores[best] = score;
+}
+
+// Captures and queen promotions only, standing pat on the static evaluation
+static int quiesce(search_engine_t *engine, int alpha, int beta, int ply) {
+    count_node(engine);
+    if (engine->stopped) return 0;
+    chess_state_t *chess = &engine->position;
+    int stand_pat = evaluate(chess);
+    if (stand_pat >= beta || ply >= QUIESCE_MAX_PLY) return stand_pat;
+    if (stand_pat > alpha) alpha = stand_pat;
+
+    move_t moves[MAX_LEGAL_MOVES];
+    int scores[MAX_LEGAL_MOVES];
+    int n_moves = generate_legal_moves(chess, moves, MAX_LEGAL_MOVES);
+    int n_tactical = 0;
+    for (int i = 0; i < n_moves; i++) {
+        if (moves[i].captured_piece.type != EMPTY || moves[i].promotion_piece == 'q') moves[n_tactical++] = moves[i];
+    }
+    score_moves(engine, moves, n_tactical, 0, SEARCH_MAX_PLY, scores);
+
+    saved_position_t saved;
+    save_position(chess, &saved);
+    for (int i = 0; i < n_tactical; i++) {
+        pick_move(moves, scores, n_tactical, i);
+        apply_move(chess, &moves[i], 0);    // no keys below the main search
+        int score = -quiesce(engine, -beta, -alpha, ply + 1);
+        restore_position(chess, &saved);
+        if (engine->stopped) return 0;
+        if (score >= beta) return score;
+        if (score > alpha) alpha = score;
+    }
+    return alpha;
+}
+
+static int alpha_beta(search_engine_t *engine, int depth, int alpha, int beta, int ply) {
+    chess_state_t *chess = &engine->position;
+    if (ply > 0) {
+        if (chess->halfmove_clock >= 100 || is_repetition(engine)) return 0;
+        if (ply >= SEARCH_MAX_PLY - 1) return evaluate(chess);
+        // No line from here can beat a mate already found nearer the root
+        if (alpha < -SEARCH_MATE + ply) alpha = -SEARCH_MATE + ply;
+        if (beta > SEARCH_MATE - ply - 1) beta = SEARCH_MATE - ply - 1;
+        if (alpha >= beta) return alpha;
+    }
+    bool in_check = is_king_in_check(chess, chess->turn);
+    if (in_check) depth++;
+    if (depth <= 0) return quiesce(engine, alpha, beta, ply);
+    count_node(engine);
+    if (engine->stopped) return 0;
+
+    uint64_t key = engine->keys[engine->n_keys - 1];
+    struct search_entry *entry = &engine->table[key & engine->table_mask];
+    uint16_t table_move = 0;
+    if (entry->key == key) {
+        table_move = entry->move;
+        if (ply > 0 && entry->depth >= depth) {
+            int score = score_from_table(entry->score, ply);
+            if (entry->bound == BOUND_EXACT || (entry->bound == BOUND_LOWER && score >= beta) ||
+                (entry->bound == BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    move_t moves[MAX_LEGAL_MOVES];
+    int scores[MAX_LEGAL_MOVES];
+    int n_moves = generate_legal_moves(chess, moves, MAX_LEGAL_MOVES);
+    if (n_moves == 0) return in_check ? -SEARCH_MATE + ply : 0;
+    score_moves(engine, moves, n_moves, table_move, ply, scores);
+
+    int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    uint16_t best_move = 0;
+    uint64_t base_key = move_base_key(engine);
+    saved_position_t saved;
+    save_position(chess, &saved);
+    for (int i = 0; i < n_moves; i++) {
+        pick_move(moves, scores, n_moves, i);
+        push_key(engine, apply_move(chess, &moves[i], base_key));
+        int score;
+        if (i == 0) {
+            score = -alpha_beta(engine, depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            // Later moves only have to be shown worse than the best so far; re-search if one is not
+            score = -alpha_beta(engine, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta) score = -alpha_beta(engine, depth - 1, -beta, -alpha, ply + 1);
+        }
+        engine->n_keys--;
+        restore_position(chess, &saved);
+        if (engine->stopped) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            best_move = move_code(&moves[i]);
+        }
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) {
+            bool quiet = moves[i].captured_piece.type == EMPTY && !moves[i].is_promotion;
+            if (quiet) {
+                if (engine->killers[ply][0] != best_move) {
+                    engine->killers[ply][1] = engine->killers[ply][0];
+                    engine->killers[ply][0] = best_move;
+                }
+                int *history = &engine->history[best_move & 63][(best_move >> 6) & 63];
+                *history += depth * depth;
+                if (*history > (1 << 18)) *history = 1 << 18;
+            }
+            break;
+        }
+    }
+
+    // Keep the deeper entry unless it is from an earlier search or for this same position
+    if (entry->key == key || entry->generation != engine->generation || depth >= entry->depth) {
+        entry->key = key;
+        entry->score = (int16_t)score_to_table(best_score, ply);
+        entry->move = best_move;
+        entry->depth = (int8_t)depth;
+        entry->bound = (best_score >= beta) ? BOUND_LOWER : (best_score > original_alpha) ? BOUND_EXACT : BOUND_UPPER;
+        entry->generation = engine->generation;
+    }
+    return best_score;
+}
+
+// Follow the table's moves from the current position
+static void extract_pv(search_engine_t *engine, search_result_t *result) {
+    chess_state_t *chess = &engine->position;
+    saved_position_t saved;
+    save_position(chess, &saved);
+    int start_keys = engine->n_keys;
+    size_t length = 0;
+    result->pv[0] = '\0';
+    move_t moves[MAX_LEGAL_MOVES];
+    for (int ply = 0; ply < result->depth && ply < SEARCH_MAX_PLY - 1; ply++) {
+        uint64_t key = engine->keys[engine->n_keys - 1];
+        const struct search_entry *entry = &engine->table[key & engine->table_mask];
+        if (entry->key != key || entry->move == 0) break;
+        int n_moves = generate_legal_moves(chess, moves, MAX_LEGAL_MOVES);
+        int found = -1;
+        for (int i = 0; i < n_moves && found < 0; i++) {
+            if (move_code(&moves[i]) == entry->move) found = i;
+        }
+        if (found < 0) break;
+        if (ply == 0) strcpy(result->best_move, moves[found].notation);
+        length += (size_t)snprintf(result->pv + length, sizeof(result->pv) - length, "%s%s", ply ? " " : "",
+                                   moves[found].notation);
+        push_key(engine, apply_move(chess, &moves[found], move_base_key(engine)));
+        if (is_repetition(engine)) break;
+    }
+    engine->n_keys = start_keys;
+    restore_position(chess, &saved);
+}
+
+bool init_search_engine(search_engine_t *engine, size_t hash_mb) {
+    if (!engine) return false;
+    pthread_once(&zobrist_once, init_zobrist);
+    memset(engine, 0, sizeof(*engine));
+    size_t entries = 1;
+    size_t wanted = (hash_mb > 0 ? hash_mb : 1) * 1024 * 1024 / sizeof(struct search_entry);
+    while (entries * 2 <= wanted) entries *= 2;
+    engine->table = calloc(entries, sizeof(struct search_entry));
+    if (!engine->table) {
+        fprintf(stderr, "Error: Could not allocate a %zu MB transposition table\n", hash_mb);
+        return false;
+    }
+    engine->table_mask = entries - 1;
+    init_chess_board(&engine->position);
+    engine->keys[0] = position_key(&engine->position);
+    engine->n_keys = 1;
+    return true;
+}
+
+void free_search_engine(search_engine_t *engine) {
+    if (!engine) return;
+    free(engine->table);
+    engine->table = NULL;
+}
+
+void clear_search_engine(search_engine_t *engine) {
+    if (!engine || !engine->table) return;
+    memset(engine->table, 0, (engine->table_mask + 1) * sizeof(struct search_entry));
+    memset(engine->killers, 0, sizeof(engine->killers));
+    memset(engine->history, 0, sizeof(engine->history));
+}
+
+void search_set_position(search_engine_t *engine, const chess_state_t *chess) {
+    if (!engine || !chess) return;
+    saved_position_t position;
+    save_position(chess, &position);
+    restore_position(&engine->position, &position);
+    engine->position.move_count = 0;
+    engine->keys[0] = position_key(&engine->position);
+    engine->n_keys = 1;
+}
+
+bool search_play_move(search_engine_t *engine, const char *uci_move) {
+    if (!engine || !uci_move) return false;
+    move_t moves[MAX_LEGAL_MOVES];
+    int n_moves = generate_legal_moves(&engine->position, moves, MAX_LEGAL_MOVES);
+    for (int i = 0; i < n_moves; i++) {
+        if (strcasecmp(moves[i].notation, uci_move) != 0) continue;
+        push_key(engine, apply_move(&engine->position, &moves[i], move_base_key(engine)));
+        return true;
+    }
+    return false;
+}
+
+bool search_best_move(search_engine_t *engine, const search_limits_t *limits, search_progress_fn progress,
+                      search_stop_fn stop, void *context, search_result_t *result) {
+    if (!engine || !engine->table || !result) return false;
+    search_limits_t unlimited;
+    memset(&unlimited, 0, sizeof(unlimited));
+    if (!limits) limits = &unlimited;
+    memset(result, 0, sizeof(*result));
+
+    engine->nodes = 0;
+    engine->start_ms = now_ms();
+    engine->deadline_ms = 0;
+    engine->node_limit = limits->nodes;
+    engine->depth = 0;
+    engine->stop_requested = false;
+    engine->stopped = false;
+    engine->stop = stop;
+    engine->stop_context = context;
+    engine->generation++;
+    memset(engine->killers, 0, sizeof(engine->killers));
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) engine->history[from][to] /= 2;
+    }
+
+    // A clock is spent a slice per move: the moves left to the next control, or about 30, plus
+    // most of the increment, never more than half of what is left
+    int64_t budget_ms = 0;
+    if (limits->movetime_ms > 0) {
+        budget_ms = limits->movetime_ms;
+    } else if (limits->time_left_ms > 0) {
+        int moves_left = limits->moves_to_go > 0 ? limits->moves_to_go + 1 : 30;
+        budget_ms = limits->time_left_ms / moves_left + limits->increment_ms * 3 / 4;
+        if (budget_ms > limits->time_left_ms / 2) budget_ms = limits->time_left_ms / 2;
+        if (budget_ms < 1) budget_ms = 1;
+    }
+    if (budget_ms > 0) engine->deadline_ms = engine->start_ms + budget_ms;
+
+    move_t moves[MAX_LEGAL_MOVES];
+    int n_moves = generate_legal_moves(&engine->position, moves, MAX_LEGAL_MOVES);
+    if (n_moves == 0) {
+        result->score = is_king_in_check(&engine->position, engine->position.turn) ? -SEARCH_MATE : 0;
+        return true;
+    }
+    // A forced move needs no search unless a depth was asked for
+    if (n_moves == 1 && limits->depth == 0) {
+        strcpy(result->best_move, moves[0].notation);
+        strcpy(result->pv, moves[0].notation);
+        result->score = evaluate(&engine->position);
+        return true;
+    }
+
+    int max_depth = (limits->depth > 0 && limits->depth < SEARCH_MAX_PLY - 1) ? limits->depth : SEARCH_MAX_PLY - 1;
+    for (int depth = 1; depth <= max_depth; depth++) {
+        engine->depth = depth;
+        if (depth > 1 && engine->stop_requested) break;
+        int score = alpha_beta(engine, depth, -INFINITE_SCORE, INFINITE_SCORE, 0);
+        if (engine->stopped) break;
+        result->depth = depth;
+        result->score = score;
+        extract_pv(engine, result);
+        result->nodes = engine->nodes;
+        result->elapsed_ms = now_ms() - engine->start_ms;
+        if (progress) progress(result, context);
+        // A mate within the depth searched will not get shorter
+        if ((score > MATE_BOUND || score < -MATE_BOUND) && SEARCH_MATE - abs(score) <= depth) break;
+        // The next iteration takes several times this one; do not start what cannot finish
+        if (budget_ms > 0 && result->elapsed_ms * 2 > budget_ms) break;
+    }
+    // Should depth 1 not have produced a table move (it always does), fall back to the first legal move
+    if (result->best_move[0] == '\0') strcpy(result->best_move, moves[0].notation);
+    result->nodes = engine->nodes;
+    result->elapsed_ms = now_ms() - engine->start_ms;
+    return true;
+}
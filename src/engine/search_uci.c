@@ -0,0 +1,233 @@
+#include "engine/search.h"
+#include "game/chess_state.h"
+#include <poll.h>
+#include <stdarg.h>
+
+#define UCI_LINE_MAX 16384              // "position startpos moves ..." for a full move history
+
+// One UCI conversation: commands arrive on in_fd, replies go out on out_fd. Output is written
+// directly rather than through stdio, which a forked child shares with its parent.
+typedef struct {
+    int in_fd;
+    int out_fd;
+    char buffer[UCI_LINE_MAX];
+    size_t length;
+    bool eof;
+    bool quit;
+    search_engine_t *engine;
+    size_t hash_mb;
+} uci_session_t;
+
+static void send_line(uci_session_t *session, const char *format, ...) {
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (length < 0) return;
+    if (length > (int)sizeof(line) - 2) length = (int)sizeof(line) - 2;
+    line[length++] = '\n';
+    for (int sent = 0; sent < length;) {
+        ssize_t n = write(session->out_fd, line + sent, (size_t)(length - sent));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        sent += (int)n;
+    }
+}
+
+// Read whatever input arrives within timeout_ms (-1: wait for some); false at end of input
+static bool fill_input(uci_session_t *session, int timeout_ms) {
+    if (session->eof) return false;
+    // A line longer than the buffer is dropped; no command needs one
+    if (session->length == sizeof(session->buffer)) session->length = 0;
+    struct pollfd pfd = {session->in_fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0) return errno == EINTR;
+    if (ready == 0) return true;
+    ssize_t n = read(session->in_fd, session->buffer + session->length, sizeof(session->buffer) - session->length);
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    if (n == 0) {
+        session->eof = true;
+        return false;
+    }
+    session->length += (size_t)n;
+    return true;
+}
+
+// Copy the next complete line, without its line ending, and optionally consume it
+static bool next_line(uci_session_t *session, char *line, size_t line_size, bool consume) {
+    char *end = memchr(session->buffer, '\n', session->length);
+    if (!end) return false;
+    size_t length = (size_t)(end - session->buffer);
+    size_t copied = length < line_size - 1 ? length : line_size - 1;
+    memcpy(line, session->buffer, copied);
+    line[copied] = '\0';
+    if (copied > 0 && line[copied - 1] == '\r') line[copied - 1] = '\0';
+    if (consume) {
+        session->length -= length + 1;
+        memmove(session->buffer, end + 1, session->length);
+    }
+    return true;
+}
+
+// Polled by the search: "isready" is answered at once, "stop" ends the search, and any other
+// command ends it too but is left to run afterwards
+static bool search_interrupted(void *context) {
+    uci_session_t *session = context;
+    if (!fill_input(session, 0)) return true;
+    char line[64];
+    while (next_line(session, line, sizeof(line), false)) {
+        if (strcmp(line, "isready") == 0) {
+            next_line(session, line, sizeof(line), true);
+            send_line(session, "readyok");
+            continue;
+        }
+        if (strcmp(line, "stop") == 0 || strcmp(line, "ponderhit") == 0) next_line(session, line, sizeof(line), true);
+        return true;
+    }
+    return false;
+}
+
+static void send_progress(const search_result_t *result, void *context) {
+    uci_session_t *session = context;
+    char score[32];
+    if (result->score > SEARCH_MATE - SEARCH_MAX_PLY) {
+        snprintf(score, sizeof(score), "mate %d", (SEARCH_MATE - result->score + 1) / 2);
+    } else if (result->score < -(SEARCH_MATE - SEARCH_MAX_PLY)) {
+        snprintf(score, sizeof(score), "mate %d", -(SEARCH_MATE + result->score) / 2);
+    } else {
+        snprintf(score, sizeof(score), "cp %d", result->score);
+    }
+    long nps = result->elapsed_ms > 0 ? (long)(result->nodes * 1000 / result->elapsed_ms) : 0;
+    send_line(session, "info depth %d score %s nodes %ld nps %ld time %lld pv %s", result->depth, score, result->nodes,
+              nps, (long long)result->elapsed_ms, result->pv);
+}
+
+// "position [startpos | fen <fen>] [moves <move>...]"
+static void handle_position(uci_session_t *session, const char *args) {
+    chess_state_t *chess = malloc(sizeof(chess_state_t));
+    if (!chess) return;
+    init_chess_board(chess);
+    const char *moves = strstr(args, "moves");
+    if (strncmp(args, "fen ", 4) == 0) {
+        char fen[128];
+        size_t length = moves ? (size_t)(moves - args) - 4 : strlen(args) - 4;
+        if (length >= sizeof(fen)) length = sizeof(fen) - 1;
+        memcpy(fen, args + 4, length);
+        fen[length] = '\0';
+        if (!chess_state_from_fen(chess, fen)) {
+            send_line(session, "info string invalid fen, using the initial position");
+        }
+    }
+    search_set_position(session->engine, chess);
+    free(chess);
+    if (!moves) return;
+
+    char move[8];
+    const char *p = moves + 5;
+    while (*p) {
+        while (*p == ' ') p++;
+        size_t length = strcspn(p, " ");
+        if (length == 0) break;
+        if (length >= sizeof(move)) length = sizeof(move) - 1;
+        memcpy(move, p, length);
+        move[length] = '\0';
+        p += strcspn(p, " ");
+        if (!search_play_move(session->engine, move)) {
+            send_line(session, "info string illegal move %s, ignoring the rest", move);
+            return;
+        }
+    }
+}
+
+static void handle_go(uci_session_t *session, char *args) {
+    search_limits_t limits;
+    memset(&limits, 0, sizeof(limits));
+    bool white = session->engine->position.turn == WHITE;
+    char *words[32];
+    int n_words = 0;
+    char *save = NULL;
+    for (char *word = strtok_r(args, " ", &save); word && n_words < 32; word = strtok_r(NULL, " ", &save)) {
+        words[n_words++] = word;
+    }
+    // Keywords with a value consume it; "infinite" and "ponder" just leave the search unlimited
+    for (int i = 0; i + 1 < n_words; i++) {
+        const char *word = words[i];
+        long long value = atoll(words[i + 1]);
+        if (strcmp(word, "depth") == 0) limits.depth = (int)value;
+        else if (strcmp(word, "movetime") == 0) limits.movetime_ms = value;
+        else if (strcmp(word, "nodes") == 0) limits.nodes = value;
+        else if (strcmp(word, white ? "wtime" : "btime") == 0) limits.time_left_ms = value > 0 ? value : 1;
+        else if (strcmp(word, white ? "winc" : "binc") == 0) limits.increment_ms = value;
+        else if (strcmp(word, "movestogo") == 0) limits.moves_to_go = (int)value;
+        // The other side's clock is skipped with its value
+        else if (strcmp(word, "wtime") != 0 && strcmp(word, "btime") != 0 && strcmp(word, "winc") != 0 &&
+                 strcmp(word, "binc") != 0) continue;
+        i++;
+    }
+    search_result_t result;
+    search_best_move(session->engine, &limits, send_progress, search_interrupted, session, &result);
+    send_line(session, "bestmove %s", result.best_move[0] ? result.best_move : "(none)");
+}
+
+static void handle_command(uci_session_t *session, char *line) {
+    while (*line == ' ' || *line == '\t') line++;
+    if (strcmp(line, "uci") == 0) {
+        send_line(session, "id name Chess Robot internal search");
+        send_line(session, "id author Chess Robot");
+        send_line(session, "option name Hash type spin default %d min 1 max 1024", SEARCH_DEFAULT_HASH_MB);
+        send_line(session, "uciok");
+    } else if (strcmp(line, "isready") == 0) {
+        send_line(session, "readyok");
+    } else if (strcmp(line, "ucinewgame") == 0) {
+        clear_search_engine(session->engine);
+    } else if (strncmp(line, "setoption name Hash value ", 26) == 0) {
+        long hash_mb = atol(line + 26);
+        if (hash_mb < 1 || hash_mb > 1024 || (size_t)hash_mb == session->hash_mb) return;
+        search_engine_t *engine = session->engine;
+        free_search_engine(engine);
+        if (!init_search_engine(engine, (size_t)hash_mb)) {
+            send_line(session, "info string could not allocate %ld MB, keeping %zu MB", hash_mb, session->hash_mb);
+            init_search_engine(engine, session->hash_mb);
+            return;
+        }
+        session->hash_mb = (size_t)hash_mb;
+    } else if (strncmp(line, "position ", 9) == 0) {
+        handle_position(session, line + 9);
+    } else if (strcmp(line, "go") == 0 || strncmp(line, "go ", 3) == 0) {
+        handle_go(session, line + 2);
+    } else if (strcmp(line, "quit") == 0) {
+        session->quit = true;
+    }
+    // "stop" outside a search and anything unknown are ignored, as UCI asks
+}
+
+int run_search_uci(int in_fd, int out_fd) {
+    uci_session_t *session = calloc(1, sizeof(uci_session_t));
+    search_engine_t *engine = malloc(sizeof(search_engine_t));
+    char *line = malloc(UCI_LINE_MAX);
+    if (!session || !engine || !line || !init_search_engine(engine, SEARCH_DEFAULT_HASH_MB)) {
+        free(line);
+        free(engine);
+        free(session);
+        return 1;
+    }
+    session->in_fd = in_fd;
+    session->out_fd = out_fd;
+    session->engine = engine;
+    session->hash_mb = SEARCH_DEFAULT_HASH_MB;
+
+    while (!session->quit) {
+        if (next_line(session, line, UCI_LINE_MAX, true)) {
+            handle_command(session, line);
+        } else if (!fill_input(session, -1)) {
+            break;
+        }
+    }
+
+    free_search_engine(engine);
+    free(line);
+    free(engine);
+    free(session);
+    return 0;
+}
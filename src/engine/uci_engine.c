@@ -1,10 +1,13 @@
 #include "engine/uci_engine.h"
+#include "engine/search.h"
 #include "game/chess_state.h"
 
 bool uci_start_engine(uci_engine_t *engine, const char *path) {
     if (!engine || !path) return false;
     
-    strcpy(engine->engine_path, path);
+    // The console passes its own engine_path back in
+    if (path != engine->engine_path) snprintf(engine->engine_path, sizeof(engine->engine_path), "%s", path);
+    bool internal = strcmp(path, UCI_INTERNAL_ENGINE) == 0;
     
     if (pipe(engine->engine_in) < 0 || pipe(engine->engine_out) < 0) {
         perror("Failed to create pipes");
@@ -28,9 +31,19 @@ bool uci_start_engine(uci_engine_t *engine, const char *path) {
         close(engine->engine_out[0]);
         close(engine->engine_out[1]);
         
-        execlp(path, path, NULL);
-        perror("Failed to exec engine");
-        exit(1);
+        // Without the engine binary the built-in search answers in its place, so there is always
+        // something to play against. _exit: the parent's unflushed stdio must not reach the pipe.
+        if (!internal) {
+            execlp(path, path, NULL);
+            dprintf(STDOUT_FILENO, "info string cannot run %s (%s), using the internal search\n", path,
+                    strerror(errno));
+        }
+        // No exec closes the parent's close-on-exec descriptors (e.g. the server's listening
+        // socket) here, and the search needs none but its pipes
+        long max_fd = sysconf(_SC_OPEN_MAX);
+        if (max_fd < 0 || max_fd > 65536) max_fd = 65536;
+        for (int fd = STDERR_FILENO + 1; fd < max_fd; fd++) close(fd);
+        _exit(run_search_uci(STDIN_FILENO, STDOUT_FILENO));
     }
     
     // Parent process
@@ -42,12 +55,13 @@ bool uci_start_engine(uci_engine_t *engine, const char *path) {
     fcntl(engine->engine_out[0], F_SETFL, flags | O_NONBLOCK);
     
     engine->is_running = true;
+    engine->echo = false;
     
-    // Initialize engine
+    // Initialize engine; the internal search is ready as soon as it is forked
     uci_send_command(engine, "uci");
-    usleep(500000); // 0.5 second
+    if (!internal) usleep(500000); // 0.5 second
     uci_send_command(engine, "isready");
-    usleep(200000); // 0.2 second
+    if (!internal) usleep(200000); // 0.2 second
     
     return true;
 }
@@ -77,7 +91,7 @@ void uci_stop_engine(uci_engine_t *engine) {
 bool uci_send_command(uci_engine_t *engine, const char *command) {
     if (!engine || !command || !engine->is_running) return false;
     
-    printf("→ Engine: %s\n", command);
+    if (engine->echo) printf("→ Engine: %s\n", command);
     
     size_t len = strlen(command);
     ssize_t written = write(engine->engine_in[1], command, len);
@@ -107,7 +121,7 @@ bool uci_read_response(uci_engine_t *engine, char *buffer, size_t buffer_size, i
     ssize_t n = read(engine->engine_out[0], buffer, buffer_size - 1);
     if (n > 0) {
         buffer[n] = '\0';
-        if (strstr(buffer, "bestmove") == NULL) {
+        if (engine->echo && strstr(buffer, "bestmove") == NULL) {
             printf("← Engine: %s", buffer);
         }
         return true;
@@ -145,7 +159,7 @@ bool uci_get_best_move(uci_engine_t *engine, char *move_buffer, size_t buffer_si
                     move_buffer[i] = '\0';
                 }
                 
-                printf("← Engine: bestmove %s\n", move_buffer);
+                if (engine->echo) printf("← Engine: bestmove %s\n", move_buffer);
                 return strlen(move_buffer) > 0 && strcmp(move_buffer, "(none)") != 0;
             }
         }
@@ -158,15 +172,85 @@ bool uci_get_best_move(uci_engine_t *engine, char *move_buffer, size_t buffer_si
 bool uci_set_position(uci_engine_t *engine, const chess_state_t *chess) {
     if (!engine || !chess) return false;
     
-    char command[1024] = "position startpos";
+    // Sized for the whole move list; long games overflow any fixed buffer
+    char *command = malloc(32 + (size_t)chess->move_count * 6);
+    if (!command) return false;
+    size_t length = (size_t)sprintf(command, "position startpos");
     
     if (chess->move_count > 0) {
-        strcat(command, " moves");
+        length += (size_t)sprintf(command + length, " moves");
         for (int i = 0; i < chess->move_count; i++) {
-            strcat(command, " ");
-            strcat(command, chess->move_history[i].notation);
+            length += (size_t)sprintf(command + length, " %s", chess->move_history[i].notation);
         }
     }
     
-    return uci_send_command(engine, command);
-}
\ No newline at end of file
+    bool sent = uci_send_command(engine, command);
+    free(command);
+    return sent;
+}
+void uci_begin_search(uci_search_t *search) {
+    if (!search) return;
+    memset(search, 0, sizeof(*search));
+}
+
+// Copy the whitespace-delimited word at text into out
+static void copy_word(const char *text, char *out, size_t out_size) {
+    size_t n = 0;
+    while (text[n] && !isspace((unsigned char)text[n]) && n + 1 < out_size) {
+        out[n] = text[n];
+        n++;
+    }
+    out[n] = '\0';
+}
+
+// Apply one complete output line; true when it changed the first PV move or ended the search
+static bool apply_search_line(uci_search_t *search, const char *line) {
+    if (strncmp(line, "bestmove ", 9) == 0) {
+        copy_word(line + 9, search->best_move, sizeof(search->best_move));
+        if (strcmp(search->best_move, "(none)") == 0) search->best_move[0] = '\0';
+        search->done = true;
+        return true;
+    }
+    if (strncmp(line, "info ", 5) != 0) return false;
+    const char *depth = strstr(line, " depth ");
+    if (depth) search->depth = atoi(depth + 7);
+    const char *pv = strstr(line, " pv ");
+    if (!pv) return false;
+    char move[16];
+    copy_word(pv + 4, move, sizeof(move));
+    if (move[0] == '\0' || strcmp(move, search->pv_move) == 0) return false;
+    strcpy(search->pv_move, move);
+    return true;
+}
+
+bool uci_poll_search(uci_engine_t *engine, uci_search_t *search, int timeout_ms) {
+    if (!engine || !search || !engine->is_running || search->done) return false;
+
+    fd_set readfds;
+    struct timeval timeout;
+
+    FD_ZERO(&readfds);
+    FD_SET(engine->engine_out[0], &readfds);
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    if (select(engine->engine_out[0] + 1, &readfds, NULL, NULL, &timeout) <= 0) return false;
+
+    char chunk[1024];
+    ssize_t n = read(engine->engine_out[0], chunk, sizeof(chunk));
+    bool changed = false;
+    for (ssize_t i = 0; i < n && !search->done; i++) {
+        if (chunk[i] != '\n') {
+            // Overlong lines are truncated; only their start matters
+            if (search->line_length + 1 < sizeof(search->line)) search->line[search->line_length++] = chunk[i];
+            continue;
+        }
+        search->line[search->line_length] = '\0';
+        if (search->line_length > 0 && search->line[search->line_length - 1] == '\r')
+            search->line[search->line_length - 1] = '\0';
+        if (apply_search_line(search, search->line)) changed = true;
+        search->line_length = 0;
+    }
+    return changed;
+}
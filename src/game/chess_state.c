@@ -132,4 +132,77 @@ void chess_state_to_fen(const chess_state_t *chess, char *fen_buffer, size_t buf
     
     strncpy(fen_buffer, fen, buffer_size - 1);
     fen_buffer[buffer_size - 1] = '\0';
-}
\ No newline at end of file
+}
+static piece_t char_to_piece(char ch) {
+    piece_t piece = {EMPTY, COLOR_NONE};
+    switch (tolower((unsigned char)ch)) {
+        case 'p': piece.type = PAWN; break;
+        case 'n': piece.type = KNIGHT; break;
+        case 'b': piece.type = BISHOP; break;
+        case 'r': piece.type = ROOK; break;
+        case 'q': piece.type = QUEEN; break;
+        case 'k': piece.type = KING; break;
+        default: return piece;
+    }
+    piece.color = isupper((unsigned char)ch) ? WHITE : BLACK;
+    return piece;
+}
+
+bool chess_state_from_fen(chess_state_t *chess, const char *fen) {
+    if (!chess || !fen) return false;
+    
+    // Parsed into locals so a malformed string leaves chess untouched
+    piece_t board[BOARD_SIZE][BOARD_SIZE];
+    
+    // Board position, rank 8 first
+    const char *p = fen;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        int c = 0;
+        while (c < BOARD_SIZE) {
+            if (*p >= '1' && *p <= '8') {
+                int empty = *p - '0';
+                if (c + empty > BOARD_SIZE) return false;
+                for (int i = 0; i < empty; i++) board[r][c++] = (piece_t){EMPTY, COLOR_NONE};
+            } else {
+                piece_t piece = char_to_piece(*p);
+                if (piece.type == EMPTY) return false;
+                board[r][c++] = piece;
+            }
+            p++;
+        }
+        if (r < BOARD_SIZE - 1 && *p++ != '/') return false;
+    }
+    
+    char turn = '\0';
+    char castling[8] = "";
+    char en_passant[3] = "";
+    int halfmove = 0;
+    int fullmove = 1;
+    // The move counters are optional, as in EPD
+    if (sscanf(p, " %c %7s %2s %d %d", &turn, castling, en_passant, &halfmove, &fullmove) < 3) return false;
+    if (turn != 'w' && turn != 'b') return false;
+    
+    bool rights[4] = {false, false, false, false};
+    if (strcmp(castling, "-") != 0) {
+        for (const char *ch = castling; *ch; ch++) {
+            const char *flag = strchr("KQkq", *ch);
+            if (!flag || *ch == '\0') return false;
+            rights[flag - "KQkq"] = true;
+        }
+    }
+    
+    int row, col;
+    if (strcmp(en_passant, "-") != 0 && !square_to_index(en_passant, &row, &col)) return false;
+    
+    memcpy(chess->board, board, sizeof(board));
+    chess->turn = (turn == 'w') ? WHITE : BLACK;
+    chess->white_can_castle_kingside = rights[0];
+    chess->white_can_castle_queenside = rights[1];
+    chess->black_can_castle_kingside = rights[2];
+    chess->black_can_castle_queenside = rights[3];
+    strcpy(chess->en_passant_target, en_passant);
+    chess->halfmove_clock = halfmove;
+    chess->fullmove_number = fullmove > 0 ? fullmove : 1;
+    chess->move_count = 0;
+    return true;
+}
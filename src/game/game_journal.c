@@ -0,0 +1,444 @@
+#include "game/game_journal.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include "game/move_validation.h"
+#include <stddef.h>
+#include <sys/stat.h>
+#include <time.h>
+
+enum {
+    JOURNAL_WRITE = 0,
+    JOURNAL_SYNC_CLOSE,     // the game is done with; make it durable first
+    JOURNAL_CLOSE           // the file is already unlinked
+};
+
+static const char promotion_letters[] = " nbrq";
+
+static int64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void journal_path(const game_journal_t *journal, int slot, char *path, size_t path_size) {
+    snprintf(path, path_size, "%s/game-%d.journal", journal->dir, slot);
+}
+
+// FNV-1a over the record, its checksum field taken as zero, and any payload after it
+static uint32_t record_checksum(const unsigned char *data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char byte = data[i];
+        if (i >= offsetof(journal_record_t, checksum) && i < offsetof(journal_record_t, checksum) + sizeof(uint32_t))
+            byte = 0;
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash;
+}
+
+static uint16_t pack_move(const move_t *move) {
+    int from = move->from_row * BOARD_SIZE + move->from_col;
+    int to = move->to_row * BOARD_SIZE + move->to_col;
+    int promotion = 0;
+    if (move->notation[4] != '\0') {
+        const char *letter = strchr(promotion_letters + 1, tolower((unsigned char)move->notation[4]));
+        if (letter) promotion = (int)(letter - promotion_letters);
+    }
+    return (uint16_t)(from | to << 6 | promotion << 12);
+}
+
+// Fill the squares and notation of a move; the pieces involved are not known without the board
+static void unpack_move(uint16_t packed, move_t *move) {
+    memset(move, 0, sizeof(*move));
+    int from = packed & 63;
+    int to = (packed >> 6) & 63;
+    int promotion = (packed >> 12) & 7;
+    move->from_row = from / BOARD_SIZE;
+    move->from_col = from % BOARD_SIZE;
+    move->to_row = to / BOARD_SIZE;
+    move->to_col = to % BOARD_SIZE;
+    index_to_square(move->from_row, move->from_col, move->notation);
+    index_to_square(move->to_row, move->to_col, move->notation + 2);
+    if (promotion > 0 && promotion < (int)sizeof(promotion_letters) - 1) {
+        move->notation[4] = promotion_letters[promotion];
+        move->notation[5] = '\0';
+        move->is_promotion = true;
+        move->promotion_piece = promotion_letters[promotion];
+    }
+}
+
+// Records only take JOURNAL_RECORD_ROOM entries and are refused beyond that, so the caller never
+// waits for the writer's fdatasync. A close must not be lost, as the descriptor would leak; it
+// takes the rest of the queue and waits only once that is full too.
+static bool queue_entry(game_journal_t *journal, int fd, int action, const void *data, size_t length) {
+    pthread_mutex_lock(&journal->mutex);
+    if (action == JOURNAL_WRITE && journal->count >= JOURNAL_RECORD_ROOM) {
+        journal->overflows++;
+        pthread_mutex_unlock(&journal->mutex);
+        return false;
+    }
+    if (journal->count == JOURNAL_QUEUE) {
+        journal->stalls++;
+        while (journal->count == JOURNAL_QUEUE) pthread_cond_wait(&journal->changed, &journal->mutex);
+    }
+    journal_entry_t *entry = &journal->queue[(journal->head + journal->count) % JOURNAL_QUEUE];
+    entry->fd = fd;
+    entry->action = action;
+    entry->length = (uint32_t)length;
+    if (length > 0) memcpy(entry->data, data, length);
+    journal->count++;
+    journal->queued++;
+    pthread_cond_broadcast(&journal->changed);
+    pthread_mutex_unlock(&journal->mutex);
+    return true;
+}
+
+static bool queue_record(game_journal_t *journal, int fd, journal_record_t *record, const char *fen) {
+    unsigned char data[sizeof(journal_record_t) + JOURNAL_FEN_MAX];
+    size_t length = sizeof(journal_record_t);
+    record->time_ms = wall_ms();
+    record->checksum = 0;
+    memcpy(data, record, sizeof(*record));
+    if (fen) {
+        size_t fen_length = strlen(fen);
+        if (fen_length > JOURNAL_FEN_MAX - 1) fen_length = JOURNAL_FEN_MAX - 1;
+        memset(data + length, 0, JOURNAL_FEN_MAX);
+        memcpy(data + length, fen, fen_length);
+        length += JOURNAL_FEN_MAX;
+    }
+    uint32_t checksum = record_checksum(data, length);
+    memcpy(data + offsetof(journal_record_t, checksum), &checksum, sizeof(checksum));
+    return queue_entry(journal, fd, JOURNAL_WRITE, data, length);
+}
+
+static bool write_all(int fd, const unsigned char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static void *run_writer(void *arg) {
+    game_journal_t *journal = (game_journal_t *)arg;
+    pthread_mutex_lock(&journal->mutex);
+    while (true) {
+        while (journal->count == 0 && !journal->stop) pthread_cond_wait(&journal->changed, &journal->mutex);
+        if (journal->count == 0) break;
+        // Take everything queued as one batch
+        int n = journal->count;
+        for (int i = 0; i < n; i++) journal->batch[i] = journal->queue[(journal->head + i) % JOURNAL_QUEUE];
+        journal->head = (journal->head + n) % JOURNAL_QUEUE;
+        journal->count = 0;
+        long target = journal->queued;
+        pthread_cond_broadcast(&journal->changed);
+        pthread_mutex_unlock(&journal->mutex);
+
+        int n_dirty = 0;
+        for (int i = 0; i < n; i++) {
+            journal_entry_t *entry = &journal->batch[i];
+            if (entry->action == JOURNAL_WRITE) {
+                if (!write_all(entry->fd, entry->data, entry->length)) perror("Failed to write journal");
+                bool seen = false;
+                for (int d = 0; d < n_dirty && !seen; d++) seen = journal->dirty[d] == entry->fd;
+                if (!seen) journal->dirty[n_dirty++] = entry->fd;
+                continue;
+            }
+            // A closed descriptor leaves the dirty list; its number may be reused by a later batch
+            for (int d = 0; d < n_dirty; d++) {
+                if (journal->dirty[d] == entry->fd) journal->dirty[d--] = journal->dirty[--n_dirty];
+            }
+            if (entry->action == JOURNAL_SYNC_CLOSE) fdatasync(entry->fd);
+            close(entry->fd);
+        }
+        // One sync per touched file for the whole batch
+        for (int d = 0; d < n_dirty; d++) fdatasync(journal->dirty[d]);
+
+        pthread_mutex_lock(&journal->mutex);
+        journal->records += n;
+        journal->syncs += n_dirty;
+        journal->synced = target;
+        pthread_cond_broadcast(&journal->changed);
+        // Group commit: let the next batch build up unless someone is waiting for it
+        if (journal->sync_interval_ms > 0 && !journal->stop && journal->flush_waiters == 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)journal->sync_interval_ms * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            while (!journal->stop && journal->flush_waiters == 0 && journal->count < JOURNAL_QUEUE / 2) {
+                if (pthread_cond_timedwait(&journal->changed, &journal->mutex, &deadline) == ETIMEDOUT) break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    return NULL;
+}
+
+bool open_game_journal(game_journal_t *journal, const char *dir, int sync_interval_ms) {
+    if (!journal || !dir || strlen(dir) >= sizeof(journal->dir)) return false;
+    memset(journal, 0, sizeof(*journal));
+    strcpy(journal->dir, dir);
+    journal->sync_interval_ms = sync_interval_ms;
+    for (int slot = 0; slot < JOURNAL_MAX_GAMES; slot++) journal->games[slot].fd = -1;
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Could not create journal directory %s\n", dir);
+        return false;
+    }
+    pthread_mutex_init(&journal->mutex, NULL);
+    pthread_cond_init(&journal->changed, NULL);
+    if (pthread_create(&journal->thread, NULL, run_writer, journal) != 0) {
+        fprintf(stderr, "Error: Could not start journal writer thread\n");
+        pthread_cond_destroy(&journal->changed);
+        pthread_mutex_destroy(&journal->mutex);
+        return false;
+    }
+    return true;
+}
+
+bool journal_start_game(game_journal_t *journal, int slot, const game_t *game) {
+    if (!journal || !game || slot < 0 || slot >= JOURNAL_MAX_GAMES) return false;
+    journal_close_game(journal, slot, false);
+    char path[512];
+    journal_path(journal, slot, path, sizeof(path));
+    // A new file, never the old one's inode, which may still have writes queued
+    unlink(path);
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create journal %s\n", path);
+        return false;
+    }
+    journal_game_t *state = &journal->games[slot];
+    state->fd = fd;
+    state->started = false;
+    state->plies = 0;
+    state->ended = false;
+    journal_update_game(journal, slot, game);
+    return true;
+}
+
+static void set_behind(game_journal_t *journal, journal_game_t *state, bool behind) {
+    if (state->behind == behind) return;
+    state->behind = behind;
+    journal->games_behind += behind ? 1 : -1;
+}
+
+void journal_update_game(game_journal_t *journal, int slot, const game_t *game) {
+    if (!journal || !game || slot < 0 || slot >= JOURNAL_MAX_GAMES) return;
+    journal_game_t *state = &journal->games[slot];
+    if (state->fd < 0) return;
+    const chess_state_t *chess = &game->chess;
+    journal_record_t record;
+    // Stops at the first record the queue has no room for; the next call carries on from there
+    bool queued = true;
+    if (!state->started) {
+        memset(&record, 0, sizeof(record));
+        record.type = JOURNAL_START;
+        record.key = (uint64_t)game->time_control.initial_ms;
+        record.clock_ms = (int32_t)game->time_control.increment_ms;
+        queued = state->started = queue_record(journal, state->fd, &record, NULL);
+    }
+    while (queued && state->plies < chess->move_count) {
+        memset(&record, 0, sizeof(record));
+        record.type = JOURNAL_MOVE;
+        record.move = pack_move(&chess->move_history[state->plies]);
+        // Games start from the initial position, so white moves on even plies
+        record.clock_ms = (int32_t)game->remaining_ms[state->plies % 2];
+        record.key = game->position_keys[state->plies + 1];
+        record.ply = (uint32_t)state->plies + 1;
+        queued = queue_record(journal, state->fd, &record, NULL);
+        if (!queued) break;
+        state->plies++;
+        if (state->plies % JOURNAL_CHECKPOINT_PLIES == 0 && state->plies == chess->move_count) {
+            char fen[JOURNAL_FEN_MAX];
+            chess_state_to_fen(chess, fen, sizeof(fen));
+            memset(&record, 0, sizeof(record));
+            record.type = JOURNAL_CHECKPOINT;
+            record.ply = (uint32_t)state->plies;
+            // A checkpoint left out only makes the replay on resume longer
+            queue_record(journal, state->fd, &record, fen);
+        }
+    }
+    if (queued && game->result != RESULT_ONGOING && !state->ended) {
+        memset(&record, 0, sizeof(record));
+        record.type = JOURNAL_END;
+        record.result = (uint8_t)game->result;
+        record.clock_ms = (int32_t)game->termination;
+        record.ply = (uint32_t)state->plies;
+        queued = state->ended = queue_record(journal, state->fd, &record, NULL);
+    }
+    set_behind(journal, state, !queued);
+}
+
+void journal_close_game(game_journal_t *journal, int slot, bool discard) {
+    if (!journal || slot < 0 || slot >= JOURNAL_MAX_GAMES) return;
+    journal_game_t *state = &journal->games[slot];
+    if (state->fd < 0) return;
+    set_behind(journal, state, false);
+    if (discard) {
+        char path[512];
+        journal_path(journal, slot, path, sizeof(path));
+        unlink(path);
+    }
+    queue_entry(journal, state->fd, discard ? JOURNAL_CLOSE : JOURNAL_SYNC_CLOSE, NULL, 0);
+    state->fd = -1;
+}
+
+bool read_game_journal(const char *path, game_t *game, int64_t now_ms, size_t *valid_length) {
+    if (!path || !game) return false;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat info;
+    unsigned char *data = NULL;
+    size_t size = 0;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = (size_t)info.st_size;
+        data = malloc(size);
+        size_t done = 0;
+        while (data && done < size) {
+            ssize_t n = read(fd, data + done, size - done);
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        size = done;
+    }
+    close(fd);
+    if (!data) return false;
+
+    // Scan the intact prefix: the start record, then moves, checkpoints and an end record
+    static const size_t record_size = sizeof(journal_record_t);
+    journal_record_t record;
+    journal_record_t moves[MAX_MOVES];
+    int n_moves = 0;
+    time_control_t time_control = {0, 0};
+    const char *checkpoint = NULL;
+    int checkpoint_ply = 0;
+    bool started = false;
+    bool ended = false;
+    game_result_t result = RESULT_ONGOING;
+    game_termination_t termination = TERMINATION_NONE;
+    size_t offset = 0;
+    while (offset + record_size <= size) {
+        memcpy(&record, data + offset, record_size);
+        size_t length = record_size + (record.type == JOURNAL_CHECKPOINT ? JOURNAL_FEN_MAX : 0);
+        if (offset + length > size || record_checksum(data + offset, length) != record.checksum) break;
+        if (!started) {
+            if (record.type != JOURNAL_START) break;
+            time_control.initial_ms = (int64_t)record.key;
+            time_control.increment_ms = record.clock_ms;
+            started = true;
+        } else if (ended) {
+            break;
+        } else if (record.type == JOURNAL_MOVE) {
+            if (record.ply != (uint32_t)n_moves + 1 || n_moves == MAX_MOVES) break;
+            moves[n_moves++] = record;
+        } else if (record.type == JOURNAL_CHECKPOINT) {
+            if (record.ply != (uint32_t)n_moves) break;
+            checkpoint = (const char *)data + offset + record_size;
+            checkpoint_ply = n_moves;
+        } else if (record.type == JOURNAL_END) {
+            result = (game_result_t)record.result;
+            termination = (game_termination_t)record.clock_ms;
+            ended = true;
+        } else {
+            break;
+        }
+        offset += length;
+    }
+    if (valid_length) *valid_length = offset;
+    if (!started) {
+        free(data);
+        return false;
+    }
+
+    // Seek to the latest checkpoint and replay only the moves after it
+    init_game(game, &time_control, now_ms);
+    chess_state_t *chess = &game->chess;
+    int replay_from = 0;
+    char fen[JOURNAL_FEN_MAX];
+    if (checkpoint) {
+        memcpy(fen, checkpoint, JOURNAL_FEN_MAX);
+        fen[JOURNAL_FEN_MAX - 1] = '\0';
+        if (chess_state_from_fen(chess, fen)) {
+            for (int i = 0; i < checkpoint_ply; i++) unpack_move(moves[i].move, &chess->move_history[i]);
+            chess->move_count = checkpoint_ply;
+            replay_from = checkpoint_ply;
+        } else {
+            init_chess_board(chess);
+        }
+    }
+    free(data);
+    for (int i = replay_from; i < n_moves; i++) {
+        move_t move;
+        unpack_move(moves[i].move, &move);
+        if (make_move(chess, move.notation) != MOVE_SUCCESS) {
+            fprintf(stderr, "Error: Journal %s has an illegal move %s at ply %d\n", path, move.notation, i + 1);
+            return false;
+        }
+    }
+    for (int i = 0; i < n_moves; i++) {
+        game->position_keys[i + 1] = moves[i].key;
+        game->remaining_ms[i % 2] = moves[i].clock_ms;
+    }
+    game->turn_started_ms = now_ms;
+    refresh_game(game);
+    if (ended && game->result == RESULT_ONGOING) {
+        game->result = result;
+        game->termination = termination;
+        // A flag fall is adjudicated without a move; the fallen clock reads zero
+        if (termination == TERMINATION_TIMEOUT) game->remaining_ms[chess->turn == WHITE ? 0 : 1] = 0;
+    }
+    return true;
+}
+
+bool journal_resume_game(game_journal_t *journal, int slot, game_t *game, int64_t now_ms) {
+    if (!journal || !game || slot < 0 || slot >= JOURNAL_MAX_GAMES) return false;
+    char path[512];
+    journal_path(journal, slot, path, sizeof(path));
+    size_t valid_length = 0;
+    // Writes still queued for an open journal of the slot land before the file is read and cut
+    if (journal->games[slot].fd >= 0) {
+        journal_close_game(journal, slot, false);
+        flush_game_journal(journal);
+    }
+    if (!read_game_journal(path, game, now_ms, &valid_length)) return false;
+    // Cut a torn tail off so the next record follows the last intact one
+    if (truncate(path, (off_t)valid_length) < 0) {
+        perror("Failed to truncate journal");
+        return false;
+    }
+    int fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) return false;
+    journal_game_t *state = &journal->games[slot];
+    state->fd = fd;
+    state->started = true;
+    state->plies = game->chess.move_count;
+    state->ended = game->result != RESULT_ONGOING;
+    return true;
+}
+
+void flush_game_journal(game_journal_t *journal) {
+    if (!journal) return;
+    pthread_mutex_lock(&journal->mutex);
+    long target = journal->queued;
+    journal->flush_waiters++;
+    pthread_cond_broadcast(&journal->changed);
+    while (journal->synced < target) pthread_cond_wait(&journal->changed, &journal->mutex);
+    journal->flush_waiters--;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+void close_game_journal(game_journal_t *journal) {
+    if (!journal) return;
+    for (int slot = 0; slot < JOURNAL_MAX_GAMES; slot++) journal_close_game(journal, slot, false);
+    pthread_mutex_lock(&journal->mutex);
+    journal->stop = true;
+    pthread_cond_broadcast(&journal->changed);
+    pthread_mutex_unlock(&journal->mutex);
+    pthread_join(journal->thread, NULL);
+    pthread_cond_destroy(&journal->changed);
+    pthread_mutex_destroy(&journal->mutex);
+}
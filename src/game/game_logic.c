@@ -0,0 +1,266 @@
+#include "game/game_logic.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+
+// Plies without a capture or pawn move after which the game is drawn
+#define FIFTY_MOVE_PLIES 100
+
+uint64_t en_passant_key(const chess_state_t *chess) {
+    int row, col;
+    if (!chess || !square_to_index(chess->en_passant_target, &row, &col)) return 0;
+    // The capturing pawns stand beside the pawn that just moved two squares
+    int from_row = (chess->turn == WHITE) ? row + 1 : row - 1;
+    if (from_row < 0 || from_row >= BOARD_SIZE) return 0;
+    for (int side = -1; side <= 1; side += 2) {
+        int from_col = col + side;
+        if (from_col < 0 || from_col >= BOARD_SIZE) continue;
+        piece_t p = chess->board[from_row][from_col];
+        if (p.type != PAWN || p.color != chess->turn) continue;
+        char move[5];
+        index_to_square(from_row, from_col, move);
+        index_to_square(row, col, move + 2);
+        if (is_legal_move(chess, move)) return position_feature_key(POSITION_KEY_EN_PASSANT + col);
+    }
+    return 0;
+}
+
+uint64_t position_key(const chess_state_t *chess) {
+    uint64_t key = 0;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            piece_t p = chess->board[r][c];
+            if (p.type != EMPTY) key ^= position_feature_key(position_key_piece(p, r, c));
+        }
+    }
+    if (chess->turn == BLACK) key ^= position_feature_key(POSITION_KEY_TURN);
+    if (chess->white_can_castle_kingside) key ^= position_feature_key(POSITION_KEY_CASTLING);
+    if (chess->white_can_castle_queenside) key ^= position_feature_key(POSITION_KEY_CASTLING + 1);
+    if (chess->black_can_castle_kingside) key ^= position_feature_key(POSITION_KEY_CASTLING + 2);
+    if (chess->black_can_castle_queenside) key ^= position_feature_key(POSITION_KEY_CASTLING + 3);
+    return key ^ en_passant_key(chess);
+}
+
+// Neither side can mate: bare kings, a single minor piece, or bishops all on one square colour
+static bool is_insufficient_material(const chess_state_t *chess) {
+    int minors = 0;
+    int knights = 0;
+    int bishop_shades[2] = {0, 0};
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            piece_t p = chess->board[r][c];
+            switch (p.type) {
+                case PAWN:
+                case ROOK:
+                case QUEEN:
+                    return false;
+                case KNIGHT:
+                    minors++;
+                    knights++;
+                    break;
+                case BISHOP:
+                    minors++;
+                    bishop_shades[(r + c) % 2]++;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    if (minors <= 1) return true;
+    return knights == 0 && (bishop_shades[0] == 0 || bishop_shades[1] == 0);
+}
+
+// Whether color could still mate, for adjudicating the opponent's flag fall
+static bool has_mating_material(const chess_state_t *chess, color_t color) {
+    int pieces = 0;
+    bool major = false;
+    bool opponent_bare = true;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            piece_t p = chess->board[r][c];
+            if (p.type == EMPTY || p.type == KING) continue;
+            if (p.color != color) {
+                opponent_bare = false;
+                continue;
+            }
+            pieces++;
+            if (p.type == PAWN || p.type == ROOK || p.type == QUEEN) major = true;
+        }
+    }
+    if (pieces == 0) return false;
+    // A lone minor piece only mates with help from the opponent's own pieces
+    return major || pieces > 1 || !opponent_bare;
+}
+
+static int clock_index(color_t color) {
+    return color == WHITE ? 0 : 1;
+}
+
+static void end_game(game_t *game, game_result_t result, game_termination_t termination) {
+    game->result = result;
+    game->termination = termination;
+}
+
+static game_result_t win_for(color_t color) {
+    return color == WHITE ? RESULT_WHITE_WINS : RESULT_BLACK_WINS;
+}
+
+// Refresh the legal moves and the position key, then apply the rules that end a game
+static void adjudicate(game_t *game) {
+    chess_state_t *chess = &game->chess;
+    game->n_legal_moves = generate_legal_moves(chess, game->legal_moves, MAX_LEGAL_MOVES);
+    game->in_check = is_king_in_check(chess, chess->turn);
+    game->position_keys[chess->move_count] = position_key(chess);
+
+    if (game->n_legal_moves == 0) {
+        if (game->in_check) {
+            end_game(game, win_for(chess->turn == WHITE ? BLACK : WHITE), TERMINATION_CHECKMATE);
+        } else {
+            end_game(game, RESULT_DRAW, TERMINATION_STALEMATE);
+        }
+        return;
+    }
+    if (is_insufficient_material(chess)) {
+        end_game(game, RESULT_DRAW, TERMINATION_INSUFFICIENT_MATERIAL);
+        return;
+    }
+    if (chess->halfmove_clock >= FIFTY_MOVE_PLIES) {
+        end_game(game, RESULT_DRAW, TERMINATION_FIFTY_MOVES);
+        return;
+    }
+    // Only positions since the last capture or pawn move can repeat, and only with the same side to move
+    int current = chess->move_count;
+    int oldest = current - chess->halfmove_clock;
+    if (oldest < 0) oldest = 0;
+    int repeats = 0;
+    for (int i = current - 2; i >= oldest; i -= 2) {
+        if (game->position_keys[i] == game->position_keys[current] && ++repeats == 2) {
+            end_game(game, RESULT_DRAW, TERMINATION_REPETITION);
+            return;
+        }
+    }
+    if (chess->move_count >= MAX_MOVES) {
+        end_game(game, RESULT_DRAW, TERMINATION_MOVE_LIMIT);
+    }
+}
+
+void init_game(game_t *game, const time_control_t *time_control, int64_t now_ms) {
+    if (!game) return;
+    init_chess_board(&game->chess);
+    game->time_control.initial_ms = time_control ? time_control->initial_ms : 0;
+    game->time_control.increment_ms = time_control ? time_control->increment_ms : 0;
+    game->remaining_ms[0] = game->time_control.initial_ms;
+    game->remaining_ms[1] = game->time_control.initial_ms;
+    game->turn_started_ms = now_ms;
+    game->result = RESULT_ONGOING;
+    game->termination = TERMINATION_NONE;
+    adjudicate(game);
+}
+
+void refresh_game(game_t *game) {
+    if (!game) return;
+    adjudicate(game);
+}
+
+int64_t game_time_left(const game_t *game, color_t color, int64_t now_ms) {
+    if (!game || game->time_control.initial_ms <= 0) return 0;
+    int64_t left = game->remaining_ms[clock_index(color)];
+    if (color == game->chess.turn && game->result == RESULT_ONGOING) left -= now_ms - game->turn_started_ms;
+    return left;
+}
+
+bool update_game_clock(game_t *game, int64_t now_ms) {
+    if (!game) return false;
+    if (game->result != RESULT_ONGOING) return false;
+    if (game->time_control.initial_ms <= 0) return true;
+    color_t mover = game->chess.turn;
+    if (game_time_left(game, mover, now_ms) > 0) return true;
+    game->remaining_ms[clock_index(mover)] = 0;
+    color_t opponent = mover == WHITE ? BLACK : WHITE;
+    if (has_mating_material(&game->chess, opponent)) {
+        end_game(game, win_for(opponent), TERMINATION_TIMEOUT);
+    } else {
+        end_game(game, RESULT_DRAW, TERMINATION_TIMEOUT);
+    }
+    return false;
+}
+
+const move_t *find_game_move(const game_t *game, const char *uci_move) {
+    if (!game || !uci_move) return NULL;
+    size_t length = strlen(uci_move);
+    if (length < 4 || length > 5) return NULL;
+    for (int i = 0; i < game->n_legal_moves; i++) {
+        const char *notation = game->legal_moves[i].notation;
+        if (strncmp(notation, uci_move, 4) != 0) continue;
+        if (tolower((unsigned char)uci_move[4]) == notation[4]) return &game->legal_moves[i];
+    }
+    return NULL;
+}
+
+move_result_t play_game_move(game_t *game, const char *uci_move, int64_t now_ms) {
+    if (!game || !uci_move) return MOVE_INVALID_FORMAT;
+    if (!update_game_clock(game, now_ms)) return MOVE_GAME_OVER;
+    size_t length = strlen(uci_move);
+    if (length < 4 || length > 5) return MOVE_INVALID_FORMAT;
+    int from_row, from_col, to_row, to_col;
+    if (!square_to_index(uci_move, &from_row, &from_col) || !square_to_index(uci_move + 2, &to_row, &to_col)) {
+        return MOVE_INVALID_SQUARE;
+    }
+    piece_t moving = game->chess.board[from_row][from_col];
+    if (moving.type == EMPTY || moving.color != game->chess.turn) return MOVE_NO_PIECE;
+    const move_t *move = find_game_move(game, uci_move);
+    if (!move) return MOVE_ILLEGAL;
+
+    if (game->time_control.initial_ms > 0) {
+        int index = clock_index(game->chess.turn);
+        game->remaining_ms[index] -= now_ms - game->turn_started_ms;
+        game->remaining_ms[index] += game->time_control.increment_ms;
+    }
+    game->turn_started_ms = now_ms;
+    // The move is one of the legal moves adjudicate generated for this position
+    move_result_t result = make_legal_move(&game->chess, move->notation);
+    if (result != MOVE_SUCCESS) return result;
+    adjudicate(game);
+    return MOVE_SUCCESS;
+}
+
+void resign_game(game_t *game, color_t color) {
+    if (!game || game->result != RESULT_ONGOING) return;
+    end_game(game, win_for(color == WHITE ? BLACK : WHITE), TERMINATION_RESIGNATION);
+}
+
+void agree_draw(game_t *game) {
+    if (!game || game->result != RESULT_ONGOING) return;
+    end_game(game, RESULT_DRAW, TERMINATION_AGREEMENT);
+}
+
+color_t game_winner(const game_t *game) {
+    if (!game) return COLOR_NONE;
+    if (game->result == RESULT_WHITE_WINS) return WHITE;
+    if (game->result == RESULT_BLACK_WINS) return BLACK;
+    return COLOR_NONE;
+}
+
+const char *game_result_string(game_result_t result) {
+    switch (result) {
+        case RESULT_WHITE_WINS: return "1-0";
+        case RESULT_BLACK_WINS: return "0-1";
+        case RESULT_DRAW:       return "1/2-1/2";
+        default:                return "*";
+    }
+}
+
+const char *game_termination_string(game_termination_t termination) {
+    switch (termination) {
+        case TERMINATION_CHECKMATE:             return "Checkmate";
+        case TERMINATION_STALEMATE:             return "Stalemate";
+        case TERMINATION_TIMEOUT:               return "Time forfeit";
+        case TERMINATION_RESIGNATION:           return "Resignation";
+        case TERMINATION_AGREEMENT:             return "Draw agreed";
+        case TERMINATION_REPETITION:            return "Threefold repetition";
+        case TERMINATION_FIFTY_MOVES:           return "50-move rule";
+        case TERMINATION_INSUFFICIENT_MATERIAL: return "Insufficient material";
+        case TERMINATION_MOVE_LIMIT:            return "Move limit reached";
+        default:                                return "In progress";
+    }
+}
@@ -0,0 +1,141 @@
+#include "game/move_converter.h"
+
+static int color_index(color_t color) {
+    return color == WHITE ? 0 : 1;
+}
+
+void init_move_converter(move_converter_t *converter) {
+    if (!converter) return;
+    memset(converter, 0, sizeof(*converter));
+}
+
+int square_location(int row, int col) {
+    return row * BOARD_SIZE + col;
+}
+
+int graveyard_location(color_t color, int slot) {
+    return ARM_GRAVEYARD_BASE + color_index(color) * ARM_GRAVEYARD_SLOTS_PER_COLOR + slot;
+}
+
+int rack_location(color_t color, piece_type_t type) {
+    int slot;
+    switch (type) {
+        case QUEEN:  slot = 0; break;
+        case ROOK:   slot = 1; break;
+        case BISHOP: slot = 2; break;
+        default:     slot = 3; break;
+    }
+    return ARM_RACK_BASE + color_index(color) * ARM_RACK_SLOTS_PER_COLOR + slot;
+}
+
+static void add_action(arm_plan_t *plan, arm_action_type_t type, int location, piece_t piece) {
+    arm_action_t *action = &plan->actions[plan->n_actions++];
+    action->type = type;
+    action->location = location;
+    action->piece = piece;
+}
+
+// Put a piece in the first free graveyard slot of its colour; -1 when full
+static int bury_piece(move_converter_t *converter, piece_t piece) {
+    int ci = color_index(piece.color);
+    for (int slot = 0; slot < ARM_GRAVEYARD_SLOTS_PER_COLOR; slot++) {
+        if (converter->graveyard[ci][slot] != EMPTY) continue;
+        converter->graveyard[ci][slot] = piece.type;
+        return graveyard_location(piece.color, slot);
+    }
+    return -1;
+}
+
+// Where the promoted piece comes from: its rack slot, else a captured piece of the same type
+static int take_promotion_piece(move_converter_t *converter, piece_t piece) {
+    int ci = color_index(piece.color);
+    int rack = rack_location(piece.color, piece.type);
+    int slot = rack - ARM_RACK_BASE - ci * ARM_RACK_SLOTS_PER_COLOR;
+    if (!converter->rack_used[ci][slot]) {
+        converter->rack_used[ci][slot] = true;
+        return rack;
+    }
+    for (int slot = 0; slot < ARM_GRAVEYARD_SLOTS_PER_COLOR; slot++) {
+        if (converter->graveyard[ci][slot] != piece.type) continue;
+        converter->graveyard[ci][slot] = EMPTY;
+        return graveyard_location(piece.color, slot);
+    }
+    return -1;
+}
+
+bool graveyard_slot_free(const move_converter_t *converter, int location) {
+    int index = location - ARM_GRAVEYARD_BASE;
+    if (!converter || index < 0 || index >= 2 * ARM_GRAVEYARD_SLOTS_PER_COLOR) return false;
+    return converter->graveyard[index / ARM_GRAVEYARD_SLOTS_PER_COLOR][index % ARM_GRAVEYARD_SLOTS_PER_COLOR] == EMPTY;
+}
+
+bool reassign_graveyard_slot(move_converter_t *converter, int from, int to) {
+    int a = from - ARM_GRAVEYARD_BASE;
+    int b = to - ARM_GRAVEYARD_BASE;
+    if (!converter || a < 0 || a >= 2 * ARM_GRAVEYARD_SLOTS_PER_COLOR || b < 0 || b >= 2 * ARM_GRAVEYARD_SLOTS_PER_COLOR ||
+        a / ARM_GRAVEYARD_SLOTS_PER_COLOR != b / ARM_GRAVEYARD_SLOTS_PER_COLOR) return false;
+    if (a == b) return true;
+    piece_type_t *slots = converter->graveyard[a / ARM_GRAVEYARD_SLOTS_PER_COLOR];
+    if (slots[a % ARM_GRAVEYARD_SLOTS_PER_COLOR] == EMPTY || slots[b % ARM_GRAVEYARD_SLOTS_PER_COLOR] != EMPTY) return false;
+    slots[b % ARM_GRAVEYARD_SLOTS_PER_COLOR] = slots[a % ARM_GRAVEYARD_SLOTS_PER_COLOR];
+    slots[a % ARM_GRAVEYARD_SLOTS_PER_COLOR] = EMPTY;
+    return true;
+}
+
+static piece_type_t promotion_type(char promotion_piece) {
+    switch (tolower((unsigned char)promotion_piece)) {
+        case 'r': return ROOK;
+        case 'b': return BISHOP;
+        case 'n': return KNIGHT;
+        default:  return QUEEN;
+    }
+}
+
+bool convert_move_to_actions(move_converter_t *converter, const move_t *move, arm_plan_t *plan) {
+    if (!converter || !move || !plan) return false;
+    plan->n_actions = 0;
+    // A move that cannot be planned must leave the bookkeeping untouched
+    move_converter_t saved = *converter;
+    int from = square_location(move->from_row, move->from_col);
+    int to = square_location(move->to_row, move->to_col);
+
+    // Clear the captured piece first so the destination is free when the mover arrives
+    if (move->captured_piece.type != EMPTY) {
+        int grave = bury_piece(converter, move->captured_piece);
+        if (grave < 0) {
+            *converter = saved;
+            return false;
+        }
+        // En passant captures the pawn beside the destination, not on it
+        int captured_at = move->is_en_passant ? square_location(move->from_row, move->to_col) : to;
+        add_action(plan, ARM_PICK, captured_at, move->captured_piece);
+        add_action(plan, ARM_PLACE, grave, move->captured_piece);
+    }
+
+    if (move->is_promotion) {
+        // The pawn leaves the board and the promoted piece comes from off the board
+        piece_t promoted = {promotion_type(move->promotion_piece), move->moved_piece.color};
+        int source = take_promotion_piece(converter, promoted);
+        int grave = source >= 0 ? bury_piece(converter, move->moved_piece) : -1;
+        if (grave < 0) {
+            *converter = saved;
+            return false;
+        }
+        add_action(plan, ARM_PICK, from, move->moved_piece);
+        add_action(plan, ARM_PLACE, grave, move->moved_piece);
+        add_action(plan, ARM_PICK, source, promoted);
+        add_action(plan, ARM_PLACE, to, promoted);
+        return true;
+    }
+
+    add_action(plan, ARM_PICK, from, move->moved_piece);
+    add_action(plan, ARM_PLACE, to, move->moved_piece);
+
+    if (move->is_castle) {
+        bool kingside = move->to_col > move->from_col;
+        piece_t rook = {ROOK, move->moved_piece.color};
+        add_action(plan, ARM_PICK, square_location(move->from_row, kingside ? 7 : 0), rook);
+        add_action(plan, ARM_PLACE, square_location(move->from_row, kingside ? 5 : 3), rook);
+    }
+    return true;
+}
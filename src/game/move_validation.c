@@ -131,83 +131,91 @@ static bool is_valid_king_move(const chess_state_t *chess, int from_row, int fro
     return false;
 }
 
-bool is_square_attacked(const chess_state_t *chess, int row, int col, color_t by_color) {
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            piece_t p = chess->board[r][c];
-            if (p.type == EMPTY || p.color != by_color) continue;
-            
-            bool can_attack = false;
-            switch (p.type) {
-                case PAWN: {
-                    int direction = (p.color == WHITE) ? -1 : 1;
-                    can_attack = (row == r + direction && (col == c - 1 || col == c + 1));
-                    break;
-                }
-                case KNIGHT:
-                    can_attack = is_valid_knight_move(r, c, row, col);
-                    break;
-                case BISHOP:
-                    can_attack = is_valid_bishop_move(chess, r, c, row, col);
-                    break;
-                case ROOK:
-                    can_attack = is_valid_rook_move(chess, r, c, row, col);
-                    break;
-                case QUEEN:
-                    can_attack = is_valid_queen_move(chess, r, c, row, col);
-                    break;
-                case KING: {
-                    int row_diff = abs(row - r);
-                    int col_diff = abs(col - c);
-                    can_attack = (row_diff <= 1 && col_diff <= 1 && (row_diff || col_diff));
-                    break;
-                }
-                default:
-                    break;
+static const int knight_offsets[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+static const int king_offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+static const int diagonal_steps[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+static const int straight_steps[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+static bool on_board(int row, int col) {
+    return row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE;
+}
+
+static bool is_piece(const piece_t *board, int row, int col, piece_type_t type, color_t color) {
+    return on_board(row, col) && board[row * BOARD_SIZE + col].type == type && board[row * BOARD_SIZE + col].color == color;
+}
+
+// First piece along each ray from the square is either a slider of by_color that moves that way, or a blocker
+static bool attacked_along(const piece_t *board, int row, int col, color_t by_color,
+                           const int steps[4][2], piece_type_t slider) {
+    for (int d = 0; d < 4; d++) {
+        int r = row + steps[d][0];
+        int c = col + steps[d][1];
+        while (on_board(r, c)) {
+            piece_t p = board[r * BOARD_SIZE + c];
+            if (p.type != EMPTY) {
+                if (p.color == by_color && (p.type == slider || p.type == QUEEN)) return true;
+                break;
             }
-            
-            if (can_attack) return true;
+            r += steps[d][0];
+            c += steps[d][1];
         }
     }
     return false;
 }
 
-bool is_king_in_check(const chess_state_t *chess, color_t king_color) {
-    // Find king position
+// Boards are passed as 64 squares, row by row. Looks outward from the square for each kind of
+// attacker instead of trying every piece of by_color
+static bool board_square_attacked(const piece_t *board, int row, int col, color_t by_color) {
+    // A pawn attacks diagonally forward, so an attacking pawn stands one row behind the square
+    int pawn_row = (by_color == WHITE) ? row + 1 : row - 1;
+    if (is_piece(board, pawn_row, col - 1, PAWN, by_color) || is_piece(board, pawn_row, col + 1, PAWN, by_color)) return true;
+    for (int i = 0; i < 8; i++) {
+        if (is_piece(board, row + knight_offsets[i][0], col + knight_offsets[i][1], KNIGHT, by_color)) return true;
+        if (is_piece(board, row + king_offsets[i][0], col + king_offsets[i][1], KING, by_color)) return true;
+    }
+    return attacked_along(board, row, col, by_color, diagonal_steps, BISHOP) ||
+           attacked_along(board, row, col, by_color, straight_steps, ROOK);
+}
+
+static bool board_king_in_check(const piece_t *board, color_t king_color) {
+    color_t opponent = (king_color == WHITE) ? BLACK : WHITE;
     for (int r = 0; r < BOARD_SIZE; r++) {
         for (int c = 0; c < BOARD_SIZE; c++) {
-            piece_t p = chess->board[r][c];
+            piece_t p = board[r * BOARD_SIZE + c];
             if (p.type == KING && p.color == king_color) {
-                color_t opponent = (king_color == WHITE) ? BLACK : WHITE;
-                return is_square_attacked(chess, r, c, opponent);
+                return board_square_attacked(board, r, c, opponent);
             }
         }
     }
     return false;
 }
 
-static bool would_move_leave_king_in_check(chess_state_t *chess, const char *uci_move) {
-    // Make temporary move
-    chess_state_t temp = *chess;
-    
-    int from_row, from_col, to_row, to_col;
-    square_to_index(uci_move, &from_row, &from_col);
-    square_to_index(uci_move + 2, &to_row, &to_col);
-    
-    piece_t moving = temp.board[from_row][from_col];
-    temp.board[to_row][to_col] = moving;
-    temp.board[from_row][from_col] = (piece_t){EMPTY, COLOR_NONE};
-    
-    return is_king_in_check(&temp, chess->turn);
+bool is_square_attacked(const chess_state_t *chess, int row, int col, color_t by_color) {
+    return board_square_attacked(&chess->board[0][0], row, col, by_color);
 }
 
-bool is_legal_move(const chess_state_t *chess, const char *uci_move) {
-    if (!chess || !uci_move || strlen(uci_move) < 4) return false;
+bool is_king_in_check(const chess_state_t *chess, color_t king_color) {
+    return board_king_in_check(&chess->board[0][0], king_color);
+}
+
+static bool would_move_leave_king_in_check(const chess_state_t *chess, int from_row, int from_col, int to_row, int to_col) {
+    // Only the board is needed, not the move history that makes up most of chess_state_t
+    piece_t board[BOARD_SIZE][BOARD_SIZE];
+    memcpy(board, chess->board, sizeof(board));
     
-    int from_row, from_col, to_row, to_col;
-    if (!square_to_index(uci_move, &from_row, &from_col)) return false;
-    if (!square_to_index(uci_move + 2, &to_row, &to_col)) return false;
+    piece_t moving = board[from_row][from_col];
+    // An en passant capture also empties the square beside the pawn, which can open a line to the king
+    if (moving.type == PAWN && from_col != to_col && board[to_row][to_col].type == EMPTY) {
+        board[from_row][to_col] = (piece_t){EMPTY, COLOR_NONE};
+    }
+    board[to_row][to_col] = moving;
+    board[from_row][from_col] = (piece_t){EMPTY, COLOR_NONE};
     
+    return board_king_in_check(&board[0][0], chess->turn);
+}
+
+// The piece's own movement rules only; whether the move leaves the king in check is not tested
+static bool is_pseudo_legal_squares(const chess_state_t *chess, int from_row, int from_col, int to_row, int to_col) {
     piece_t moving = chess->board[from_row][from_col];
     if (moving.type == EMPTY || moving.color != chess->turn) return false;
     
@@ -239,52 +247,53 @@ bool is_legal_move(const chess_state_t *chess, const char *uci_move) {
             return false;
     }
     
-    if (!valid) return false;
-    
-    // Check if move would leave king in check
-    return !would_move_leave_king_in_check((chess_state_t*)chess, uci_move);
+    return valid;
+}
+
+static bool is_legal_squares(const chess_state_t *chess, int from_row, int from_col, int to_row, int to_col) {
+    return is_pseudo_legal_squares(chess, from_row, from_col, to_row, to_col) &&
+           !would_move_leave_king_in_check(chess, from_row, from_col, to_row, to_col);
 }
 
-static bool has_legal_moves(const chess_state_t *chess, color_t color) {
-    char move[6];
+bool is_legal_move(const chess_state_t *chess, const char *uci_move) {
+    if (!chess || !uci_move || strlen(uci_move) < 4) return false;
     
-    for (int fr = 0; fr < BOARD_SIZE; fr++) {
-        for (int fc = 0; fc < BOARD_SIZE; fc++) {
-            piece_t piece = chess->board[fr][fc];
-            if (piece.type == EMPTY || piece.color != color) continue;
-            
-            for (int tr = 0; tr < BOARD_SIZE; tr++) {
-                for (int tc = 0; tc < BOARD_SIZE; tc++) {
-                    char from_sq[3], to_sq[3];
-                    index_to_square(fr, fc, from_sq);
-                    index_to_square(tr, tc, to_sq);
-                    snprintf(move, sizeof(move), "%s%s", from_sq, to_sq);
-                    
-                    if (is_legal_move(chess, move)) {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    return false;
+    int from_row, from_col, to_row, to_col;
+    if (!square_to_index(uci_move, &from_row, &from_col)) return false;
+    if (!square_to_index(uci_move + 2, &to_row, &to_col)) return false;
+    return is_legal_squares(chess, from_row, from_col, to_row, to_col);
+}
+
+// Move generation stops filling once max_moves is reached, so one slot ends the search at the first legal move
+static bool has_legal_moves(const chess_state_t *chess) {
+    move_t move;
+    return generate_legal_moves(chess, &move, 1) > 0;
 }
 
 bool is_checkmate(const chess_state_t *chess) {
-    return is_king_in_check(chess, chess->turn) && !has_legal_moves(chess, chess->turn);
+    return is_king_in_check(chess, chess->turn) && !has_legal_moves(chess);
 }
 
 bool is_stalemate(const chess_state_t *chess) {
-    return !is_king_in_check(chess, chess->turn) && !has_legal_moves(chess, chess->turn);
+    return !is_king_in_check(chess, chess->turn) && !has_legal_moves(chess);
 }
 
 move_result_t make_move(chess_state_t *chess, const char *uci_move) {
     if (!chess || !uci_move) return MOVE_INVALID_FORMAT;
     if (strlen(uci_move) < 4) return MOVE_INVALID_FORMAT;
+    // The history has no room for another move
+    if (chess->move_count >= MAX_MOVES) return MOVE_GAME_OVER;
     
     if (!is_legal_move(chess, uci_move)) {
         return MOVE_ILLEGAL;
     }
+    return make_legal_move(chess, uci_move);
+}
+
+move_result_t make_legal_move(chess_state_t *chess, const char *uci_move) {
+    if (!chess || !uci_move) return MOVE_INVALID_FORMAT;
+    if (strlen(uci_move) < 4) return MOVE_INVALID_FORMAT;
+    if (chess->move_count >= MAX_MOVES) return MOVE_GAME_OVER;
     
     int from_row, from_col, to_row, to_col;
     square_to_index(uci_move, &from_row, &from_col);
@@ -385,4 +394,205 @@ move_result_t make_move(chess_state_t *chess, const char *uci_move) {
     chess->move_count++;
     
     return MOVE_SUCCESS;
-}
\ No newline at end of file
+}
+
+// One generation's candidates share the king's square, whether it is in check and which pieces
+// are pinned to it, worked out once, and a scratch board that each candidate changes and restores
+// instead of copying the board
+typedef struct {
+    const chess_state_t *chess;
+    piece_t board[BOARD_SIZE][BOARD_SIZE];
+    int king_row;                       // -1 when the side to move has no king
+    int king_col;
+    bool in_check;
+    bool pinned[BOARD_SIZE][BOARD_SIZE];
+    move_t *moves;
+    int max_moves;
+    int count;
+} move_generator_t;
+
+// A piece of the side to move is pinned when it is the only piece between its king and an
+// opposing slider that moves along that line
+static void mark_pins(move_generator_t *gen, const int steps[4][2], piece_type_t slider, color_t opponent) {
+    for (int d = 0; d < 4; d++) {
+        int r = gen->king_row + steps[d][0];
+        int c = gen->king_col + steps[d][1];
+        int shield_row = -1;
+        int shield_col = -1;
+        while (on_board(r, c)) {
+            piece_t p = gen->board[r][c];
+            if (p.type != EMPTY) {
+                if (p.color != opponent) {
+                    if (shield_row >= 0) break;
+                    shield_row = r;
+                    shield_col = c;
+                } else {
+                    if (shield_row >= 0 && (p.type == slider || p.type == QUEEN)) gen->pinned[shield_row][shield_col] = true;
+                    break;
+                }
+            }
+            r += steps[d][0];
+            c += steps[d][1];
+        }
+    }
+}
+
+static void init_move_generator(move_generator_t *gen, const chess_state_t *chess, move_t *moves, int max_moves) {
+    gen->chess = chess;
+    memcpy(gen->board, chess->board, sizeof(gen->board));
+    gen->king_row = -1;
+    gen->king_col = -1;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (chess->board[r][c].type == KING && chess->board[r][c].color == chess->turn) {
+                gen->king_row = r;
+                gen->king_col = c;
+            }
+        }
+    }
+    color_t opponent = (chess->turn == WHITE) ? BLACK : WHITE;
+    gen->in_check = gen->king_row >= 0 && board_square_attacked(&gen->board[0][0], gen->king_row, gen->king_col, opponent);
+    memset(gen->pinned, 0, sizeof(gen->pinned));
+    if (gen->king_row >= 0) {
+        mark_pins(gen, diagonal_steps, BISHOP, opponent);
+        mark_pins(gen, straight_steps, ROOK, opponent);
+    }
+    gen->moves = moves;
+    gen->max_moves = max_moves;
+    gen->count = 0;
+}
+
+// The same test as would_move_leave_king_in_check, for a pseudo-legal move
+static bool generated_move_leaves_king_in_check(move_generator_t *gen, int from_row, int from_col, int to_row, int to_col) {
+    piece_t moving = gen->board[from_row][from_col];
+    bool en_passant = moving.type == PAWN && from_col != to_col && gen->board[to_row][to_col].type == EMPTY;
+    if (moving.type != KING) {
+        if (gen->king_row < 0) return false;
+        // Out of check, only moving a pinned piece can uncover an attack on the king. En passant
+        // also empties the captured pawn's square, so it is always tested.
+        if (!gen->in_check && !en_passant && !gen->pinned[from_row][from_col]) return false;
+    }
+
+    piece_t captured = gen->board[to_row][to_col];
+    piece_t beside = gen->board[from_row][to_col];
+    if (en_passant) gen->board[from_row][to_col] = (piece_t){EMPTY, COLOR_NONE};
+    gen->board[to_row][to_col] = moving;
+    gen->board[from_row][from_col] = (piece_t){EMPTY, COLOR_NONE};
+    int king_row = moving.type == KING ? to_row : gen->king_row;
+    int king_col = moving.type == KING ? to_col : gen->king_col;
+    color_t opponent = (moving.color == WHITE) ? BLACK : WHITE;
+    bool check = board_square_attacked(&gen->board[0][0], king_row, king_col, opponent);
+    gen->board[from_row][from_col] = moving;
+    gen->board[to_row][to_col] = captured;
+    if (en_passant) gen->board[from_row][to_col] = beside;
+    return check;
+}
+
+// Append a candidate move if it is legal; promotion_piece is 0 for non-promotions
+static void add_move_if_legal(move_generator_t *gen, int from_row, int from_col, int to_row, int to_col,
+                              char promotion_piece) {
+    if (to_row < 0 || to_row >= BOARD_SIZE || to_col < 0 || to_col >= BOARD_SIZE) return;
+    if (gen->count >= gen->max_moves) return;
+    
+    const chess_state_t *chess = gen->chess;
+    piece_t moving = chess->board[from_row][from_col];
+    if (moving.type == PAWN || moving.type == KING) {
+        if (!is_pseudo_legal_squares(chess, from_row, from_col, to_row, to_col)) return;
+    } else {
+        // Knight and slider targets are generated along the piece's own moves, up to the first blocker
+        piece_t target = chess->board[to_row][to_col];
+        if (target.type != EMPTY && target.color == moving.color) return;
+    }
+    if (generated_move_leaves_king_in_check(gen, from_row, from_col, to_row, to_col)) return;
+    
+    move_t *move = &gen->moves[gen->count];
+    index_to_square(from_row, from_col, move->notation);
+    index_to_square(to_row, to_col, move->notation + 2);
+    move->notation[4] = promotion_piece;
+    move->notation[5] = '\0';
+    
+    move->moved_piece = moving;
+    move->captured_piece = chess->board[to_row][to_col];
+    move->from_row = from_row;
+    move->from_col = from_col;
+    move->to_row = to_row;
+    move->to_col = to_col;
+    move->is_castle = (moving.type == KING && abs(to_col - from_col) == 2);
+    move->is_en_passant = (moving.type == PAWN && from_col != to_col && move->captured_piece.type == EMPTY);
+    if (move->is_en_passant) move->captured_piece = chess->board[from_row][to_col];
+    move->is_promotion = (promotion_piece != 0);
+    move->promotion_piece = promotion_piece;
+    gen->count++;
+}
+
+static void add_sliding_moves(move_generator_t *gen, int row, int col, const int directions[][2], int n_directions) {
+    for (int d = 0; d < n_directions; d++) {
+        int r = row + directions[d][0];
+        int c = col + directions[d][1];
+        while (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE) {
+            add_move_if_legal(gen, row, col, r, c, 0);
+            if (gen->chess->board[r][c].type != EMPTY) break;
+            r += directions[d][0];
+            c += directions[d][1];
+        }
+    }
+}
+
+int generate_legal_moves(const chess_state_t *chess, move_t *moves, int max_moves) {
+    if (!chess || !moves || max_moves <= 0) return 0;
+    
+    static const char promotions[4] = {'q', 'r', 'b', 'n'};
+    move_generator_t gen;
+    init_move_generator(&gen, chess, moves, max_moves);
+    
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            piece_t piece = chess->board[r][c];
+            if (piece.type == EMPTY || piece.color != chess->turn) continue;
+            
+            switch (piece.type) {
+                case PAWN: {
+                    int direction = (piece.color == WHITE) ? -1 : 1;
+                    int to_row = r + direction;
+                    bool promotes = (to_row == 0 || to_row == BOARD_SIZE - 1);
+                    for (int dc = -1; dc <= 1; dc++) {
+                        if (promotes) {
+                            for (int p = 0; p < 4; p++) {
+                                add_move_if_legal(&gen, r, c, to_row, c + dc, promotions[p]);
+                            }
+                        } else {
+                            add_move_if_legal(&gen, r, c, to_row, c + dc, 0);
+                        }
+                    }
+                    add_move_if_legal(&gen, r, c, r + 2 * direction, c, 0);
+                    break;
+                }
+                case KNIGHT:
+                    for (int i = 0; i < 8; i++) {
+                        add_move_if_legal(&gen, r, c, r + knight_offsets[i][0], c + knight_offsets[i][1], 0);
+                    }
+                    break;
+                case BISHOP:
+                    add_sliding_moves(&gen, r, c, diagonal_steps, 4);
+                    break;
+                case ROOK:
+                    add_sliding_moves(&gen, r, c, straight_steps, 4);
+                    break;
+                case QUEEN:
+                    add_sliding_moves(&gen, r, c, diagonal_steps, 4);
+                    add_sliding_moves(&gen, r, c, straight_steps, 4);
+                    break;
+                case KING:
+                    for (int i = 0; i < 8; i++) {
+                        add_move_if_legal(&gen, r, c, r + king_offsets[i][0], c + king_offsets[i][1], 0);
+                    }
+                    add_move_if_legal(&gen, r, c, r, c + 2, 0);
+                    add_move_if_legal(&gen, r, c, r, c - 2, 0);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return gen.count;
+}
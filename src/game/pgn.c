@@ -0,0 +1,567 @@
+#include "game/pgn.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include "game/move_validation.h"
+#include <time.h>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define PGN_TOKEN_MAX 64
+
+// What make_move changes besides the history, to play a move forward and take it back
+typedef struct {
+    piece_t board[BOARD_SIZE][BOARD_SIZE];
+    color_t turn;
+    bool castling[4];
+    char en_passant_target[3];
+    int halfmove_clock;
+    int fullmove_number;
+    int move_count;
+} saved_position_t;
+
+static void save_position(const chess_state_t *chess, saved_position_t *saved) {
+    memcpy(saved->board, chess->board, sizeof(saved->board));
+    saved->turn = chess->turn;
+    saved->castling[0] = chess->white_can_castle_kingside;
+    saved->castling[1] = chess->white_can_castle_queenside;
+    saved->castling[2] = chess->black_can_castle_kingside;
+    saved->castling[3] = chess->black_can_castle_queenside;
+    memcpy(saved->en_passant_target, chess->en_passant_target, sizeof(saved->en_passant_target));
+    saved->halfmove_clock = chess->halfmove_clock;
+    saved->fullmove_number = chess->fullmove_number;
+    saved->move_count = chess->move_count;
+}
+
+static void restore_position(chess_state_t *chess, const saved_position_t *saved) {
+    memcpy(chess->board, saved->board, sizeof(saved->board));
+    chess->turn = saved->turn;
+    chess->white_can_castle_kingside = saved->castling[0];
+    chess->white_can_castle_queenside = saved->castling[1];
+    chess->black_can_castle_kingside = saved->castling[2];
+    chess->black_can_castle_queenside = saved->castling[3];
+    memcpy(chess->en_passant_target, saved->en_passant_target, sizeof(saved->en_passant_target));
+    chess->halfmove_clock = saved->halfmove_clock;
+    chess->fullmove_number = saved->fullmove_number;
+    chess->move_count = saved->move_count;
+}
+
+static char piece_letter(piece_type_t type) {
+    switch (type) {
+        case KNIGHT: return 'N';
+        case BISHOP: return 'B';
+        case ROOK:   return 'R';
+        case QUEEN:  return 'Q';
+        case KING:   return 'K';
+        default:     return '\0';
+    }
+}
+
+static piece_type_t letter_piece(char letter) {
+    switch (letter) {
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default:  return EMPTY;
+    }
+}
+
+static void set_uci(move_t *move, int from_row, int from_col, int to_row, int to_col, char promotion) {
+    move->from_row = from_row;
+    move->from_col = from_col;
+    move->to_row = to_row;
+    move->to_col = to_col;
+    move->notation[0] = (char)('a' + from_col);
+    move->notation[1] = (char)('8' - from_row);
+    move->notation[2] = (char)('a' + to_col);
+    move->notation[3] = (char)('8' - to_row);
+    move->notation[4] = promotion;
+    move->notation[5] = '\0';
+}
+
+// Whether a piece of this type could reach the square on an empty board; a cheap filter in front
+// of the full legality test
+static bool could_reach(piece_type_t type, color_t color, int from_row, int from_col, int to_row, int to_col) {
+    int dr = to_row - from_row;
+    int dc = to_col - from_col;
+    int adr = abs(dr);
+    int adc = abs(dc);
+    switch (type) {
+        case PAWN: {
+            int direction = (color == WHITE) ? -1 : 1;
+            return adc <= 1 && (dr == direction || (dr == 2 * direction && dc == 0));
+        }
+        case KNIGHT: return (adr == 1 && adc == 2) || (adr == 2 && adc == 1);
+        case BISHOP: return adr == adc && adr > 0;
+        case ROOK:   return (dr == 0) != (dc == 0);
+        case QUEEN:  return (adr == adc && adr > 0) || ((dr == 0) != (dc == 0));
+        case KING:   return (adr <= 1 && adc <= 1) || (dr == 0 && adc == 2);
+        default:     return false;
+    }
+}
+
+// Legal moves of the side to move's pieces of one type to a square, optionally only from one
+// file or rank (-1: any). Fills up to max_movers moves; returns how many there are. With
+// trust_single, a lone piece that could geometrically get there is returned without the full
+// legality test, for callers that play the move through make_move, which makes that test anyway.
+static int find_movers(const chess_state_t *chess, piece_type_t type, int to_row, int to_col, int from_row_only,
+                       int from_col_only, char promotion, bool trust_single, move_t *movers, int max_movers) {
+    move_t candidates[16];
+    int n_candidates = 0;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        if (from_row_only >= 0 && r != from_row_only) continue;
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (from_col_only >= 0 && c != from_col_only) continue;
+            piece_t piece = chess->board[r][c];
+            if (piece.type != type || piece.color != chess->turn) continue;
+            if (!could_reach(type, piece.color, r, c, to_row, to_col) || n_candidates == 16) continue;
+            set_uci(&candidates[n_candidates++], r, c, to_row, to_col, promotion);
+        }
+    }
+    if (trust_single && n_candidates == 1) {
+        if (max_movers > 0) movers[0] = candidates[0];
+        return 1;
+    }
+    int count = 0;
+    for (int i = 0; i < n_candidates; i++) {
+        if (!is_legal_move(chess, candidates[i].notation)) continue;
+        if (count < max_movers) movers[count] = candidates[i];
+        count++;
+    }
+    return count;
+}
+
+// Write the SAN of a move and leave it played on the board
+static bool play_san(chess_state_t *chess, const move_t *move, char *san, size_t san_size) {
+    piece_t moving = chess->board[move->from_row][move->from_col];
+    if (moving.type == EMPTY) return false;
+    char out[PGN_SAN_MAX];
+    size_t n = 0;
+    int dc = move->to_col - move->from_col;
+    if (moving.type == KING && abs(dc) == 2) {
+        strcpy(out, dc > 0 ? "O-O" : "O-O-O");
+        n = strlen(out);
+    } else {
+        bool capture = chess->board[move->to_row][move->to_col].type != EMPTY || (moving.type == PAWN && dc != 0);
+        if (moving.type == PAWN) {
+            if (capture) out[n++] = (char)('a' + move->from_col);
+        } else {
+            out[n++] = piece_letter(moving.type);
+            // Name the file, else the rank, else both, to tell apart pieces that could also move there
+            move_t movers[16];
+            int count = find_movers(chess, moving.type, move->to_row, move->to_col, -1, -1, '\0', false, movers, 16);
+            bool others = false;
+            bool same_file = false;
+            bool same_rank = false;
+            for (int i = 0; i < count && i < 16; i++) {
+                if (movers[i].from_row == move->from_row && movers[i].from_col == move->from_col) continue;
+                others = true;
+                if (movers[i].from_col == move->from_col) same_file = true;
+                if (movers[i].from_row == move->from_row) same_rank = true;
+            }
+            if (others && (!same_file || same_rank)) out[n++] = (char)('a' + move->from_col);
+            if (others && same_file) out[n++] = (char)('8' - move->from_row);
+        }
+        if (capture) out[n++] = 'x';
+        out[n++] = (char)('a' + move->to_col);
+        out[n++] = (char)('8' - move->to_row);
+        if (move->notation[4] != '\0') {
+            out[n++] = '=';
+            out[n++] = (char)toupper((unsigned char)move->notation[4]);
+        }
+    }
+    if (make_move(chess, move->notation) != MOVE_SUCCESS) return false;
+    if (is_king_in_check(chess, chess->turn)) {
+        move_t reply;
+        out[n++] = generate_legal_moves(chess, &reply, 1) == 0 ? '#' : '+';
+    }
+    out[n] = '\0';
+    if (n + 1 > san_size) return false;
+    memcpy(san, out, n + 1);
+    return true;
+}
+
+bool move_to_san(chess_state_t *chess, const move_t *move, char *san, size_t san_size) {
+    if (!chess || !move || !san || san_size == 0) return false;
+    saved_position_t saved;
+    save_position(chess, &saved);
+    bool ok = play_san(chess, move, san, san_size);
+    restore_position(chess, &saved);
+    return ok;
+}
+
+// san_to_move, with trust_single passed on to find_movers
+static bool resolve_san(const chess_state_t *chess, const char *san, bool trust_single, move_t *move) {
+    char text[PGN_TOKEN_MAX];
+    size_t n = strlen(san);
+    if (n == 0 || n >= sizeof(text)) return false;
+    memcpy(text, san, n + 1);
+    // Check, mate and annotation suffixes
+    while (n > 0 && strchr("+#!?", text[n - 1])) text[--n] = '\0';
+
+    int home_row = (chess->turn == WHITE) ? BOARD_SIZE - 1 : 0;
+    if (strcmp(text, "O-O") == 0 || strcmp(text, "0-0") == 0 || strcmp(text, "O-O-O") == 0 || strcmp(text, "0-0-0") == 0) {
+        int to_col = (n == 3) ? 6 : 2;
+        return find_movers(chess, KING, home_row, to_col, home_row, 4, '\0', false, move, 1) == 1;
+    }
+
+    const char *p = text;
+    piece_type_t type = PAWN;
+    if (letter_piece(*p) != EMPTY) type = letter_piece(*p++);
+
+    char promotion = '\0';
+    if (n >= 2 && type == PAWN && letter_piece(text[n - 1]) != EMPTY && letter_piece(text[n - 1]) != KING) {
+        promotion = (char)tolower((unsigned char)text[n - 1]);
+        text[--n] = '\0';
+        if (n > 0 && text[n - 1] == '=') text[--n] = '\0';
+    }
+    // The destination is the last square named; anything before it is disambiguation
+    if (n < 2 || (size_t)(p - text) + 2 > n) return false;
+    int to_row, to_col;
+    if (text[n - 2] < 'a' || text[n - 2] > 'h' || !square_to_index(text + n - 2, &to_row, &to_col)) return false;
+    int from_row = -1;
+    int from_col = -1;
+    for (const char *q = p; q < text + n - 2; q++) {
+        if (*q >= 'a' && *q <= 'h') {
+            from_col = *q - 'a';
+        } else if (*q >= '1' && *q <= '8') {
+            from_row = '8' - *q;
+        } else if (*q != 'x' && *q != '-' && *q != ':') {
+            return false;
+        }
+    }
+    // A pawn move without a capture stays on its file
+    if (type == PAWN && from_col < 0) from_col = to_col;
+    // A pawn that reaches the last rank must say what it becomes
+    if (type == PAWN && promotion == '\0' && (to_row == 0 || to_row == BOARD_SIZE - 1)) return false;
+    return find_movers(chess, type, to_row, to_col, from_row, from_col, promotion, trust_single, move, 1) == 1;
+}
+
+bool san_to_move(const chess_state_t *chess, const char *san, move_t *move) {
+    if (!chess || !san || !move) return false;
+    return resolve_san(chess, san, false, move);
+}
+
+// Position before the first move of a game; false if the FEN does not parse
+static bool set_start_position(chess_state_t *chess, const char *start_fen) {
+    return chess_state_from_fen(chess, start_fen ? start_fen : START_FEN);
+}
+
+int history_to_san(const chess_state_t *chess, const char *start_fen, char (*san)[PGN_SAN_MAX], int max_moves) {
+    if (!chess || !san) return 0;
+    chess_state_t *replay = malloc(sizeof(chess_state_t));
+    if (!replay) return 0;
+    int count = 0;
+    if (set_start_position(replay, start_fen)) {
+        while (count < chess->move_count && count < max_moves &&
+               play_san(replay, &chess->move_history[count], san[count], PGN_SAN_MAX)) {
+            count++;
+        }
+    }
+    free(replay);
+    return count;
+}
+
+static void set_tag(pgn_tag_t *tag, const char *name, const char *value) {
+    snprintf(tag->name, sizeof(tag->name), "%s", name);
+    snprintf(tag->value, sizeof(tag->value), "%s", value);
+}
+
+int game_pgn_tags(const game_t *game, const char *white, const char *black, pgn_tag_t *tags, int max_tags) {
+    if (!game || !tags || max_tags < 9) return 0;
+    char date[16];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(date, sizeof(date), "%Y.%m.%d", &local);
+    char time_control[48] = "-";
+    if (game->time_control.initial_ms > 0) {
+        snprintf(time_control, sizeof(time_control), "%lld+%lld", (long long)(game->time_control.initial_ms / 1000),
+                 (long long)(game->time_control.increment_ms / 1000));
+    }
+    const char *termination = "normal";
+    if (game->result == RESULT_ONGOING) termination = "unterminated";
+    if (game->termination == TERMINATION_TIMEOUT) termination = "time forfeit";
+
+    int n = 0;
+    set_tag(&tags[n++], "Event", "Robotic chess game");
+    set_tag(&tags[n++], "Site", "?");
+    set_tag(&tags[n++], "Date", date);
+    set_tag(&tags[n++], "Round", "-");
+    set_tag(&tags[n++], "White", white ? white : "?");
+    set_tag(&tags[n++], "Black", black ? black : "?");
+    set_tag(&tags[n++], "Result", game_result_string(game->result));
+    set_tag(&tags[n++], "TimeControl", time_control);
+    set_tag(&tags[n++], "Termination", termination);
+    return n;
+}
+
+// Print a token, starting a new line when it would run past the line width
+static void put_token(FILE *file, const char *token, int *column) {
+    int length = (int)strlen(token);
+    if (*column > 0 && *column + 1 + length > PGN_LINE_WIDTH) {
+        fputc('\n', file);
+        *column = 0;
+    }
+    if (*column > 0) {
+        fputc(' ', file);
+        (*column)++;
+    }
+    fputs(token, file);
+    *column += length;
+}
+
+bool write_pgn(FILE *file, const chess_state_t *chess, const pgn_tag_t *tags, int n_tags, const char *result) {
+    if (!file || !chess) return false;
+    const char *start_fen = NULL;
+    for (int i = 0; i < n_tags; i++) {
+        fprintf(file, "[%s \"", tags[i].name);
+        for (const char *v = tags[i].value; *v; v++) {
+            if (*v == '"' || *v == '\\') fputc('\\', file);
+            fputc(*v, file);
+        }
+        fputs("\"]\n", file);
+        if (strcmp(tags[i].name, "FEN") == 0) start_fen = tags[i].value;
+    }
+    fputc('\n', file);
+
+    char (*san)[PGN_SAN_MAX] = malloc(sizeof(*san) * MAX_MOVES);
+    if (!san) return false;
+    int n = history_to_san(chess, start_fen, san, MAX_MOVES);
+    // Move numbers continue from the start position's
+    char turn = 'w';
+    int fullmove = 1;
+    if (start_fen) sscanf(start_fen, "%*s %c %*s %*s %*d %d", &turn, &fullmove);
+    bool black_first = (turn == 'b');
+    int column = 0;
+    char token[32];
+    for (int i = 0; i < n; i++) {
+        bool black = ((i % 2) == 1) != black_first;
+        int number = fullmove + (i + (black_first ? 1 : 0)) / 2;
+        if (!black) {
+            snprintf(token, sizeof(token), "%d.", number);
+            put_token(file, token, &column);
+        } else if (i == 0) {
+            snprintf(token, sizeof(token), "%d...", number);
+            put_token(file, token, &column);
+        }
+        put_token(file, san[i], &column);
+    }
+    put_token(file, result ? result : "*", &column);
+    fputs("\n\n", file);
+    free(san);
+    return n == chess->move_count && !ferror(file);
+}
+
+bool open_pgn_reader(pgn_reader_t *reader, const char *path) {
+    if (!reader || !path) return false;
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (reader->fd < 0) {
+        fprintf(stderr, "Error: Could not open PGN file %s\n", path);
+        return false;
+    }
+    reader->at_line_start = true;
+    return true;
+}
+
+void close_pgn_reader(pgn_reader_t *reader) {
+    if (!reader) return;
+    if (reader->fd > STDIN_FILENO) close(reader->fd);
+    reader->fd = -1;
+}
+
+// Next byte of the input, EOF at the end
+static int next_char(pgn_reader_t *reader) {
+    if (reader->position == reader->length) {
+        if (reader->eof) return EOF;
+        ssize_t n;
+        do {
+            n = read(reader->fd, reader->buffer, sizeof(reader->buffer));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            reader->eof = true;
+            return EOF;
+        }
+        reader->length = (size_t)n;
+        reader->position = 0;
+        reader->bytes += n;
+    }
+    int c = (unsigned char)reader->buffer[reader->position++];
+    reader->at_line_start = (c == '\n');
+    return c;
+}
+
+// Hand back the byte just read; it is always still in the buffer
+static void unread_char(pgn_reader_t *reader) {
+    reader->position--;
+}
+
+static void skip_until(pgn_reader_t *reader, int end) {
+    int c;
+    do {
+        c = next_char(reader);
+    } while (c != EOF && c != end);
+}
+
+// A (possibly nested) variation, which may hold comments with parentheses in them
+static void skip_variation(pgn_reader_t *reader) {
+    int depth = 1;
+    while (depth > 0) {
+        int c = next_char(reader);
+        if (c == EOF) return;
+        if (c == '(') depth++;
+        else if (c == ')') depth--;
+        else if (c == '{') skip_until(reader, '}');
+        else if (c == ';') skip_until(reader, '\n');
+    }
+}
+
+static void read_tag(pgn_reader_t *reader, pgn_game_t *game) {
+    char name[PGN_TAG_NAME_MAX];
+    char value[PGN_TAG_VALUE_MAX];
+    size_t n = 0;
+    int c = next_char(reader);
+    while (c == ' ' || c == '\t') c = next_char(reader);
+    while (c != EOF && !isspace(c) && c != '"' && c != ']') {
+        if (n + 1 < sizeof(name)) name[n++] = (char)c;
+        c = next_char(reader);
+    }
+    name[n] = '\0';
+    while (c != EOF && c != '"' && c != ']' && c != '\n') c = next_char(reader);
+    n = 0;
+    if (c == '"') {
+        c = next_char(reader);
+        while (c != EOF && c != '"' && c != '\n') {
+            if (c == '\\') c = next_char(reader);
+            if (c == EOF) break;
+            if (n + 1 < sizeof(value)) value[n++] = (char)c;
+            c = next_char(reader);
+        }
+    }
+    value[n] = '\0';
+    if (c != ']' && c != '\n') skip_until(reader, ']');
+    if (name[0] != '\0' && game->n_tags < PGN_MAX_TAGS) set_tag(&game->tags[game->n_tags++], name, value);
+}
+
+static bool is_result(const char *token) {
+    return strcmp(token, "1-0") == 0 || strcmp(token, "0-1") == 0 || strcmp(token, "1/2-1/2") == 0 ||
+           strcmp(token, "*") == 0;
+}
+
+static void fail_game(pgn_game_t *game, const char *message, const char *token) {
+    game->error = true;
+    snprintf(game->error_message, sizeof(game->error_message), "%s %s at ply %d", message, token, game->plies + 1);
+}
+
+// The position is set up when the movetext begins, once the FEN tag, if any, has been read
+static void begin_movetext(pgn_game_t *game, bool *started) {
+    if (*started) return;
+    *started = true;
+    const char *fen = pgn_tag(game, "FEN");
+    if (!set_start_position(&game->chess, fen)) {
+        set_start_position(&game->chess, NULL);
+        fail_game(game, "Bad FEN", fen);
+    }
+}
+
+static void play_token(pgn_game_t *game, const char *token) {
+    // Move numbers, "12." or "12...", may be glued to the move
+    const char *san = token;
+    while (isdigit((unsigned char)*san)) san++;
+    if (san != token && *san == '.') {
+        while (*san == '.') san++;
+    } else {
+        san = token;
+    }
+    if (*san == '\0' || game->error) return;
+    move_t move;
+    // make_move tests the move's legality, so a lone candidate needs no test of its own
+    if (!resolve_san(&game->chess, san, true, &move)) {
+        fail_game(game, "Illegal or ambiguous move", san);
+        return;
+    }
+    if (make_move(&game->chess, move.notation) != MOVE_SUCCESS) {
+        fail_game(game, "Could not play", san);
+        return;
+    }
+    game->plies++;
+}
+
+bool read_pgn_game(pgn_reader_t *reader, pgn_game_t *game) {
+    if (!reader || !game || reader->fd < 0) return false;
+    game->n_tags = 0;
+    game->plies = 0;
+    game->error = false;
+    game->error_message[0] = '\0';
+    strcpy(game->result, "*");
+    bool started = false;
+    bool seen = false;
+    char token[PGN_TOKEN_MAX];
+    while (true) {
+        bool line_start = reader->at_line_start;
+        int c = next_char(reader);
+        if (c == EOF) break;
+        if (isspace(c)) continue;
+        if (c == '%' && line_start) {
+            skip_until(reader, '\n');
+            continue;
+        }
+        if (c == '[') {
+            // Tags after movetext belong to the next game, which had no result token
+            if (started) {
+                unread_char(reader);
+                break;
+            }
+            read_tag(reader, game);
+            seen = true;
+            continue;
+        }
+        seen = true;
+        if (c == '{') {
+            skip_until(reader, '}');
+            continue;
+        }
+        if (c == ';') {
+            skip_until(reader, '\n');
+            continue;
+        }
+        if (c == '(') {
+            skip_variation(reader);
+            continue;
+        }
+        if (c == '$') {
+            while (isdigit(c = next_char(reader))) {
+            }
+            if (c != EOF) unread_char(reader);
+            continue;
+        }
+        size_t n = 0;
+        while (c != EOF && !isspace(c) && !strchr("{}()[];$", c)) {
+            if (n + 1 < sizeof(token)) token[n++] = (char)c;
+            c = next_char(reader);
+        }
+        if (c != EOF && !isspace(c)) unread_char(reader);
+        token[n] = '\0';
+        begin_movetext(game, &started);
+        if (is_result(token)) {
+            strcpy(game->result, token);
+            break;
+        }
+        play_token(game, token);
+    }
+    if (!seen) return false;
+    begin_movetext(game, &started);
+    reader->games++;
+    reader->moves += game->plies;
+    if (game->error) reader->errors++;
+    return true;
+}
+
+const char *pgn_tag(const pgn_game_t *game, const char *name) {
+    if (!game || !name) return NULL;
+    for (int i = 0; i < game->n_tags; i++) {
+        if (strcmp(game->tags[i].name, name) == 0) return game->tags[i].value;
+    }
+    return NULL;
+}
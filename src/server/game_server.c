@@ -0,0 +1,615 @@
+// accept4
+#define _GNU_SOURCE
+#include "server/game_server.h"
+#include "game/chess_state.h"
+#include "game/game_logic.h"
+#include "game/game_journal.h"
+#include <stdarg.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <time.h>
+
+// epoll tags above the client slots
+#define TAG_LISTEN SERVER_MAX_CLIENTS
+#define TAG_ENGINE (SERVER_MAX_CLIENTS + 1)
+
+#define SERVER_EVENTS 64
+#define SERVER_JOURNAL_RETRY_MS 5       // how soon games left behind by a full journal queue catch up
+
+static const char *termination_words[] = {
+    "none", "checkmate", "stalemate", "timeout", "resignation", "agreement",
+    "repetition", "fifty-moves", "material", "move-limit"
+};
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void watch_fd(game_server_t *server, int fd, uint32_t tag, uint32_t events, int op) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u32 = tag;
+    epoll_ctl(server->epoll_fd, op, fd, &event);
+}
+
+static void drop_client(game_server_t *server, int slot) {
+    server_client_t *client = server->clients[slot];
+    if (!client) return;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    for (int g = 0; g < SERVER_MAX_GAMES; g++)
+        if (server->games[g].requester == slot) server->games[g].requester = -1;
+    free(client);
+    server->clients[slot] = NULL;
+}
+
+// Write as much pending output as the socket takes; EPOLLOUT is only registered while some is left
+static void flush_client(game_server_t *server, int slot) {
+    server_client_t *client = server->clients[slot];
+    size_t sent = 0;
+    while (sent < client->output_length) {
+        ssize_t n = send(client->fd, client->output + sent, client->output_length - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            drop_client(server, slot);
+            return;
+        }
+    }
+    memmove(client->output, client->output + sent, client->output_length - sent);
+    client->output_length -= sent;
+    bool want_write = client->output_length > 0;
+    if (want_write != client->want_write) {
+        watch_fd(server, client->fd, (uint32_t)slot, want_write ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+        client->want_write = want_write;
+    }
+    if (!want_write && client->closing) drop_client(server, slot);
+}
+
+// Queue one reply or event line; a client that lets its output back up is disconnected
+static void send_line(game_server_t *server, int slot, const char *format, ...) {
+    server_client_t *client = server->clients[slot];
+    if (!client || client->closing) return;
+    va_list args;
+    va_start(args, format);
+    size_t room = sizeof(client->output) - client->output_length;
+    int n = vsnprintf(client->output + client->output_length, room, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n + 1 >= room) {
+        client->output_length = 0;
+        client->closing = true;
+        drop_client(server, slot);
+        return;
+    }
+    client->output_length += (size_t)n;
+    client->output[client->output_length++] = '\n';
+}
+
+// Send an event line to every client watching the game
+static void broadcast(game_server_t *server, int id, const char *line) {
+    for (int slot = 0; slot < SERVER_MAX_CLIENTS; slot++) {
+        if (!server->clients[slot] || server->clients[slot]->watching != id) continue;
+        send_line(server, slot, "%s", line);
+        if (server->clients[slot]) flush_client(server, slot);
+    }
+}
+
+static game_t *find_game(game_server_t *server, const char *text, int *id) {
+    if (!text) return NULL;
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0 || value >= SERVER_MAX_GAMES) return NULL;
+    *id = (int)value;
+    return server->games[value].game;
+}
+
+// Queue whatever changed in the game for the journal writer; cheap enough for every request
+static void journal_game(game_server_t *server, int id) {
+    if (server->journal) journal_update_game(server->journal, id, server->games[id].game);
+}
+
+// Games whose records did not fit in a full journal queue; journal_update_game picks up where each stopped
+static void catch_up_journal(game_server_t *server) {
+    for (int id = 0; id < SERVER_MAX_GAMES && server->journal->games_behind > 0; id++) {
+        if (!server->journal->games[id].behind) continue;
+        if (server->games[id].game) journal_game(server, id);
+        else journal_close_game(server->journal, id, false);
+    }
+}
+
+static void announce_move(game_server_t *server, int id, const char *uci) {
+    char line[64];
+    snprintf(line, sizeof(line), "move %d %s %s", id, uci, game_result_string(server->games[id].game->result));
+    broadcast(server, id, line);
+}
+
+static void finish_search(game_server_t *server, int id, const char *reason) {
+    server_game_t *slot = &server->games[id];
+    if (reason && slot->requester >= 0) send_line(server, slot->requester, "err go %d %s", id, reason);
+    if (slot->requester >= 0 && server->clients[slot->requester]) flush_client(server, slot->requester);
+    slot->pending = false;
+    slot->requester = -1;
+}
+
+// Take a closed game out of the queue, keeping the others in order, so its id can be queued again
+// once the slot is reused
+static void unqueue_search(game_server_t *server, int id) {
+    int kept = 0;
+    for (int i = 0; i < server->queue_count; i++) {
+        int queued = server->queue[(server->queue_head + i) % SERVER_MAX_GAMES];
+        if (queued != id) server->queue[(server->queue_head + kept++) % SERVER_MAX_GAMES] = queued;
+    }
+    server->queue_count = kept;
+}
+
+// Start the oldest queued search when the engine is free
+static void start_next_search(game_server_t *server) {
+    while (server->searching < 0 && server->queue_count > 0) {
+        int id = server->queue[server->queue_head];
+        server->queue_head = (server->queue_head + 1) % SERVER_MAX_GAMES;
+        server->queue_count--;
+        server_game_t *slot = &server->games[id];
+        if (!slot->pending) continue;
+        if (slot->game->result != RESULT_ONGOING) {
+            finish_search(server, id, "over");
+            continue;
+        }
+        char command[32];
+        snprintf(command, sizeof(command), "go movetime %d", slot->movetime_ms);
+        if (!uci_set_position(&server->engine, &slot->game->chess) || !uci_send_command(&server->engine, command)) {
+            finish_search(server, id, "engine");
+            continue;
+        }
+        uci_begin_search(&server->search);
+        server->searching = id;
+    }
+}
+
+static void handle_engine(game_server_t *server) {
+    if (server->searching < 0) {
+        // Output outside a search, or after one was abandoned because its game was closed
+        char discard[1024];
+        while (read(server->engine.engine_out[0], discard, sizeof(discard)) > 0) {
+        }
+        return;
+    }
+    int id = server->searching;
+    uci_search_t *search = &server->search;
+    if (!uci_poll_search(&server->engine, search, 0)) return;
+    server_game_t *slot = &server->games[id];
+    if (!slot->game) {
+        if (search->done) {
+            server->searching = -1;
+            start_next_search(server);
+        }
+        return;
+    }
+    if (!search->done) {
+        char line[64];
+        snprintf(line, sizeof(line), "info %d %d %s", id, search->depth, search->pv_move);
+        broadcast(server, id, line);
+        return;
+    }
+    server->searching = -1;
+    if (search->best_move[0] != '\0' && play_game_move(slot->game, search->best_move, now_ms()) == MOVE_SUCCESS) {
+        journal_game(server, id);
+        announce_move(server, id, search->best_move);
+        if (slot->requester >= 0) send_line(server, slot->requester, "bestmove %d %s", id, search->best_move);
+        finish_search(server, id, NULL);
+    } else {
+        finish_search(server, id, "no move");
+    }
+    start_next_search(server);
+}
+
+// The engine exited: fail the running and queued searches and refuse further "go"
+static void engine_lost(game_server_t *server) {
+    fprintf(stderr, "Error: Engine exited\n");
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, server->engine.engine_out[0], NULL);
+    server->has_engine = false;
+    server->searching = -1;
+    server->queue_count = 0;
+    for (int id = 0; id < SERVER_MAX_GAMES; id++)
+        if (server->games[id].pending) finish_search(server, id, "engine");
+}
+
+static void command_new(game_server_t *server, int slot, const char *initial_s, const char *increment_s) {
+    time_control_t time_control = server->config.time_control;
+    if (initial_s) {
+        time_control.initial_ms = (int64_t)(atof(initial_s) * 1000.0);
+        time_control.increment_ms = increment_s ? (int64_t)(atof(increment_s) * 1000.0) : 0;
+    }
+    for (int id = 0; id < SERVER_MAX_GAMES; id++) {
+        // A closed game's slot stays taken until its stopped search has answered
+        if (server->games[id].game || id == server->searching) continue;
+        game_t *game = malloc(sizeof(game_t));
+        if (!game) break;
+        init_game(game, &time_control, now_ms());
+        server->games[id].game = game;
+        server->games[id].pending = false;
+        server->games[id].requester = -1;
+        if (server->journal) journal_start_game(server->journal, id, game);
+        send_line(server, slot, "ok new %d", id);
+        return;
+    }
+    send_line(server, slot, "err new full");
+}
+
+static void command_state(game_server_t *server, int slot, game_t *game, int id) {
+    int64_t now = now_ms();
+    if (!update_game_clock(game, now)) journal_game(server, id);
+    char fen[128];
+    chess_state_to_fen(&game->chess, fen, sizeof(fen));
+    send_line(server, slot, "state %d %s %s %c %lld %lld %s", id, game_result_string(game->result),
+              termination_words[game->termination], game->chess.turn == WHITE ? 'w' : 'b',
+              (long long)game_time_left(game, WHITE, now), (long long)game_time_left(game, BLACK, now), fen);
+}
+
+static void command_legal(game_server_t *server, int slot, const game_t *game, int id) {
+    char line[SERVER_LINE_MAX * 2];
+    int length = snprintf(line, sizeof(line), "legal %d %d", id, game->n_legal_moves);
+    for (int i = 0; i < game->n_legal_moves && length < (int)sizeof(line) - 8; i++)
+        length += snprintf(line + length, sizeof(line) - length, " %s", game->legal_moves[i].notation);
+    send_line(server, slot, "%s", line);
+}
+
+static void command_go(game_server_t *server, int slot, int id, const char *movetime) {
+    server_game_t *game = &server->games[id];
+    if (!server->has_engine) {
+        send_line(server, slot, "err go %d no engine", id);
+        return;
+    }
+    if (game->pending) {
+        send_line(server, slot, "err go %d busy", id);
+        return;
+    }
+    if (game->game->result != RESULT_ONGOING) {
+        send_line(server, slot, "err go %d over", id);
+        return;
+    }
+    // A forced move is played at once, without waiting behind other games' searches
+    if (game->game->n_legal_moves == 1) {
+        char uci[8];
+        snprintf(uci, sizeof(uci), "%s", game->game->legal_moves[0].notation);
+        play_game_move(game->game, uci, now_ms());
+        journal_game(server, id);
+        send_line(server, slot, "ok go %d", id);
+        announce_move(server, id, uci);
+        if (server->clients[slot]) send_line(server, slot, "bestmove %d %s", id, uci);
+        return;
+    }
+    // Each game is queued at most once, so this only guards the ring against overwriting entries
+    if (server->queue_count == SERVER_MAX_GAMES) {
+        send_line(server, slot, "err go %d queue full", id);
+        return;
+    }
+    game->pending = true;
+    game->requester = slot;
+    game->movetime_ms = movetime && atoi(movetime) > 0 ? atoi(movetime) : server->config.movetime_ms;
+    server->queue[(server->queue_head + server->queue_count) % SERVER_MAX_GAMES] = id;
+    server->queue_count++;
+    send_line(server, slot, "ok go %d", id);
+    start_next_search(server);
+}
+
+static void handle_line(game_server_t *server, int slot, char *line) {
+    server_client_t *client = server->clients[slot];
+    char *save = NULL;
+    char *command = strtok_r(line, " \t\r", &save);
+    if (!command) return;
+    server->requests++;
+    char *arg1 = strtok_r(NULL, " \t\r", &save);
+    char *arg2 = strtok_r(NULL, " \t\r", &save);
+
+    if (strcmp(command, "ping") == 0) {
+        send_line(server, slot, "pong");
+        return;
+    }
+    if (strcmp(command, "new") == 0) {
+        command_new(server, slot, arg1, arg2);
+        return;
+    }
+    if (strcmp(command, "unwatch") == 0) {
+        client->watching = -1;
+        send_line(server, slot, "ok unwatch");
+        return;
+    }
+    if (strcmp(command, "quit") == 0) {
+        client->closing = true;
+        return;
+    }
+    static const char *game_commands[] = {"move", "state", "legal", "go", "watch", "resign", "draw", "close"};
+    bool known = false;
+    for (size_t i = 0; i < sizeof(game_commands) / sizeof(game_commands[0]); i++)
+        if (strcmp(command, game_commands[i]) == 0) known = true;
+    if (!known) {
+        send_line(server, slot, "err %s unknown", command);
+        return;
+    }
+    int id = -1;
+    game_t *game = find_game(server, arg1, &id);
+    if (!game) {
+        send_line(server, slot, "err %s no game", command);
+        return;
+    }
+    if (strcmp(command, "move") == 0) {
+        const char *uci = arg2;
+        if (!uci) {
+            send_line(server, slot, "err move %d no move", id);
+            return;
+        }
+        if (server->games[id].pending) {
+            send_line(server, slot, "err move %d engine to move", id);
+            return;
+        }
+        move_result_t result = play_game_move(game, uci, now_ms());
+        if (result != MOVE_SUCCESS) {
+            send_line(server, slot, "err move %d %s", id, result == MOVE_GAME_OVER ? "over" : "illegal");
+            return;
+        }
+        journal_game(server, id);
+        send_line(server, slot, "ok move %d %s %s", id, uci, game_result_string(game->result));
+        announce_move(server, id, uci);
+    } else if (strcmp(command, "state") == 0) {
+        command_state(server, slot, game, id);
+    } else if (strcmp(command, "legal") == 0) {
+        command_legal(server, slot, game, id);
+    } else if (strcmp(command, "go") == 0) {
+        command_go(server, slot, id, arg2);
+    } else if (strcmp(command, "watch") == 0) {
+        client->watching = id;
+        send_line(server, slot, "ok watch %d", id);
+    } else if (strcmp(command, "resign") == 0) {
+        resign_game(game, arg2 ? (arg2[0] == 'b' ? BLACK : WHITE) : game->chess.turn);
+        journal_game(server, id);
+        send_line(server, slot, "ok resign %d", id);
+    } else if (strcmp(command, "draw") == 0) {
+        agree_draw(game);
+        journal_game(server, id);
+        send_line(server, slot, "ok draw %d", id);
+    } else if (strcmp(command, "close") == 0) {
+        // A search still running for the game is stopped; its bestmove is discarded when it arrives
+        if (server->searching == id) uci_send_command(&server->engine, "stop");
+        if (server->journal) journal_close_game(server->journal, id, true);
+        unqueue_search(server, id);
+        free(game);
+        server->games[id].game = NULL;
+        server->games[id].pending = false;
+        server->games[id].requester = -1;
+        for (int s = 0; s < SERVER_MAX_CLIENTS; s++)
+            if (server->clients[s] && server->clients[s]->watching == id) server->clients[s]->watching = -1;
+        send_line(server, slot, "ok close %d", id);
+    }
+}
+
+static void handle_readable(game_server_t *server, int slot) {
+    server_client_t *client = server->clients[slot];
+    while (server->clients[slot]) {
+        ssize_t n = recv(client->fd, client->input + client->input_length,
+                         sizeof(client->input) - client->input_length, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            drop_client(server, slot);
+            return;
+        }
+        if (n < 0) break;
+        client->input_length += (size_t)n;
+        // Run every complete line; keep a partial one for the next read
+        size_t start = 0;
+        for (size_t i = 0; server->clients[slot] && i < client->input_length; i++) {
+            if (client->input[i] != '\n') continue;
+            client->input[i] = '\0';
+            handle_line(server, slot, client->input + start);
+            start = i + 1;
+        }
+        if (!server->clients[slot]) return;
+        if (start == 0 && client->input_length == sizeof(client->input)) {
+            send_line(server, slot, "err line too long");
+            client->input_length = 0;
+        } else {
+            memmove(client->input, client->input + start, client->input_length - start);
+            client->input_length -= start;
+        }
+    }
+    if (server->clients[slot]) flush_client(server, slot);
+}
+
+static void accept_clients(game_server_t *server) {
+    while (true) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int slot = 0;
+        while (slot < SERVER_MAX_CLIENTS && server->clients[slot]) slot++;
+        server_client_t *client = slot < SERVER_MAX_CLIENTS ? malloc(sizeof(server_client_t)) : NULL;
+        if (!client || !set_nonblocking(fd)) {
+            free(client);
+            close(fd);
+            continue;
+        }
+        if (server->config.unix_path == NULL) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        client->fd = fd;
+        client->input_length = 0;
+        client->output_length = 0;
+        client->watching = -1;
+        client->want_write = false;
+        client->closing = false;
+        server->clients[slot] = client;
+        watch_fd(server, fd, (uint32_t)slot, EPOLLIN, EPOLL_CTL_ADD);
+    }
+}
+
+static int open_listener(const game_server_config_t *config) {
+    int fd;
+    if (config->unix_path) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(config->unix_path) >= sizeof(address.sun_path)) {
+            fprintf(stderr, "Error: Socket path too long: %s\n", config->unix_path);
+            return -1;
+        }
+        strcpy(address.sun_path, config->unix_path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        unlink(config->unix_path);
+        if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+            perror("Failed to bind socket");
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)config->tcp_port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+            perror("Failed to bind socket");
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, SOMAXCONN) < 0 || !set_nonblocking(fd)) {
+        perror("Failed to listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Open the journal and bring back the games that were open when the server last stopped
+static bool resume_games(game_server_t *server) {
+    server->journal = malloc(sizeof(game_journal_t));
+    if (!server->journal) return false;
+    if (!open_game_journal(server->journal, server->config.journal_dir, server->config.journal_sync_ms)) {
+        free(server->journal);
+        server->journal = NULL;
+        return false;
+    }
+    int resumed = 0;
+    for (int id = 0; id < SERVER_MAX_GAMES; id++) {
+        game_t *game = malloc(sizeof(game_t));
+        if (!game) return false;
+        if (!journal_resume_game(server->journal, id, game, now_ms())) {
+            free(game);
+            continue;
+        }
+        server->games[id].game = game;
+        resumed++;
+    }
+    if (resumed > 0) printf("Resumed %d journaled games\n", resumed);
+    return true;
+}
+
+bool start_game_server(game_server_t *server, const game_server_config_t *config) {
+    if (!server || !config) return false;
+    memset(server, 0, sizeof(*server));
+    server->config = *config;
+    if (server->config.movetime_ms <= 0) server->config.movetime_ms = 1000;
+    server->searching = -1;
+    for (int id = 0; id < SERVER_MAX_GAMES; id++) server->games[id].requester = -1;
+    server->listen_fd = open_listener(config);
+    if (server->listen_fd < 0) return false;
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (server->epoll_fd < 0) {
+        perror("Failed to create epoll instance");
+        close(server->listen_fd);
+        return false;
+    }
+    watch_fd(server, server->listen_fd, TAG_LISTEN, EPOLLIN, EPOLL_CTL_ADD);
+    if (config->engine_path) {
+        if (!uci_start_engine(&server->engine, config->engine_path)) {
+            close_game_server(server);
+            return false;
+        }
+        server->has_engine = true;
+        watch_fd(server, server->engine.engine_out[0], TAG_ENGINE, EPOLLIN, EPOLL_CTL_ADD);
+    }
+    if (config->journal_dir && !resume_games(server)) {
+        close_game_server(server);
+        return false;
+    }
+    return true;
+}
+
+bool run_game_server(game_server_t *server) {
+    if (!server || server->epoll_fd < 0) return false;
+    struct epoll_event events[SERVER_EVENTS];
+    while (!server->stop) {
+        int timeout = server->journal && server->journal->games_behind > 0 ? SERVER_JOURNAL_RETRY_MS : -1;
+        int n = epoll_wait(server->epoll_fd, events, SERVER_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            uint32_t tag = events[i].data.u32;
+            if (tag == TAG_LISTEN) {
+                accept_clients(server);
+            } else if (tag == TAG_ENGINE) {
+                if (events[i].events & EPOLLIN) handle_engine(server);
+                if (server->has_engine && (events[i].events & (EPOLLHUP | EPOLLERR)) && !(events[i].events & EPOLLIN))
+                    engine_lost(server);
+            } else if (server->clients[tag]) {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) handle_readable(server, (int)tag);
+                if (server->clients[tag] && (events[i].events & EPOLLOUT)) flush_client(server, (int)tag);
+            }
+        }
+        if (server->journal && server->journal->games_behind > 0) catch_up_journal(server);
+    }
+    return true;
+}
+
+void stop_game_server(game_server_t *server) {
+    if (server) server->stop = 1;
+}
+
+void close_game_server(game_server_t *server) {
+    if (!server) return;
+    for (int slot = 0; slot < SERVER_MAX_CLIENTS; slot++) drop_client(server, slot);
+    // Everything left out of a full journal queue is written before the games go away
+    while (server->journal && server->journal->games_behind > 0) {
+        flush_game_journal(server->journal);
+        catch_up_journal(server);
+    }
+    for (int id = 0; id < SERVER_MAX_GAMES; id++) {
+        free(server->games[id].game);
+        server->games[id].game = NULL;
+    }
+    if (server->has_engine) uci_stop_engine(&server->engine);
+    server->has_engine = false;
+    // Open games stay journaled, to be resumed by the next start
+    if (server->journal) {
+        close_game_journal(server->journal);
+        free(server->journal);
+        server->journal = NULL;
+    }
+    if (server->epoll_fd >= 0) close(server->epoll_fd);
+    if (server->listen_fd >= 0) close(server->listen_fd);
+    server->epoll_fd = -1;
+    server->listen_fd = -1;
+    if (server->config.unix_path) unlink(server->config.unix_path);
+}
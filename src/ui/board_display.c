@@ -1,5 +1,6 @@
 #include "ui/board_display.h"
 #include "game/chess_state.h"
+#include "game/pgn.h"
 
 void print_chess_board(const chess_state_t *chess) {
     if (!chess) return;
@@ -19,8 +20,8 @@ void print_game_status(const game_context_t *ctx) {
     if (!ctx) return;
     
     printf("Turn: %s (%s)\n", 
-           (ctx->chess.turn == WHITE) ? "White" : "Black",
-           ((ctx->chess.turn == WHITE) ? ctx->white_player : ctx->black_player) == PLAYER_HUMAN ? "Human" : "Engine");
+           (ctx->game.chess.turn == WHITE) ? "White" : "Black",
+           ((ctx->game.chess.turn == WHITE) ? ctx->white_player : ctx->black_player) == PLAYER_HUMAN ? "Human" : "Engine");
     
     if (strlen(ctx->last_move) > 0) {
         printf("Last move: %s\n", ctx->last_move);
@@ -31,27 +32,32 @@ void print_game_status(const game_context_t *ctx) {
     }
     
     printf("Move: %d, Halfmove clock: %d\n", 
-           ctx->chess.fullmove_number, ctx->chess.halfmove_clock);
+           ctx->game.chess.fullmove_number, ctx->game.chess.halfmove_clock);
     printf("\n");
 }
 
 void print_move_history(const chess_state_t *chess, int last_moves) {
     if (!chess || chess->move_count == 0) return;
     
+    // SAN needs each move's position, so the whole game is replayed even for the last few moves;
+    // anything past the point the replay stops is shown in coordinates
+    char (*san)[PGN_SAN_MAX] = malloc(sizeof(*san) * (size_t)chess->move_count);
+    int n_san = san ? history_to_san(chess, NULL, san, chess->move_count) : 0;
+    
     printf("Move History (last %d):\n", last_moves);
     int start = (chess->move_count > last_moves) ? chess->move_count - last_moves : 0;
     
     for (int i = start; i < chess->move_count; i++) {
-        move_t *move = &chess->move_history[i];
-        printf("%d. %s", (i / 2) + 1, move->notation);
-        if (move->is_castle) printf(" (castle)");
-        if (move->is_en_passant) printf(" (e.p.)");
-        if (move->is_promotion) printf(" (=%c)", move->promotion_piece);
-        if (move->captured_piece.type != EMPTY) printf(" x%c", piece_to_char(move->captured_piece));
-        
-        if (i % 2 == 0) printf("  ");
-        else printf("\n");
+        const char *text = (i < n_san) ? san[i] : chess->move_history[i].notation;
+        if (i % 2 == 0) {
+            printf("%d. %-8s", (i / 2) + 1, text);
+        } else if (i == start) {
+            printf("%d... %s\n", (i / 2) + 1, text);
+        } else {
+            printf("%s\n", text);
+        }
     }
     if (chess->move_count % 2 == 1) printf("\n");
     printf("\n");
-}
\ No newline at end of file
+    free(san);
+}
@@ -1,9 +1,16 @@
 #include "ui/console_ui.h"
 #include "ui/board_display.h"
-#include "game/chess_state.h"
-#include "game/move_validation.h"
+#include "game/game_logic.h"
 #include "engine/uci_engine.h"
+#include "arm/arm_executor.h"
 #include "utils/string_utils.h"
+#include <time.h>
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
 void init_game_context(game_context_t *ctx) {
     if (!ctx) return;
@@ -13,13 +20,32 @@ void init_game_context(game_context_t *ctx) {
     ctx->white_player = PLAYER_HUMAN;
     ctx->black_player = PLAYER_ENGINE;
     strcpy(ctx->engine.engine_path, "stockfish");
-    ctx->winner = COLOR_NONE;
-    init_chess_board(&ctx->chess);
+    init_game(&ctx->game, NULL, now_ms());
 }
 
 void cleanup_game_context(game_context_t *ctx) {
     if (!ctx) return;
     uci_stop_engine(&ctx->engine);
+    if (ctx->sim_arm) {
+        stop_sim_arm(ctx->sim_arm);
+        free(ctx->sim_arm);
+        ctx->sim_arm = NULL;
+        ctx->arm = NULL;
+    }
+}
+
+bool enable_console_arm(game_context_t *ctx, const char *arm_config_path, double time_scale,
+                        arm_view_fn on_view, void *view_context) {
+    if (!ctx || !arm_config_path || ctx->arm) return false;
+    arm_sim_rig_t *rig = malloc(sizeof(arm_sim_rig_t));
+    if (!rig) return false;
+    if (!start_sim_arm(rig, arm_config_path, time_scale, on_view, view_context)) {
+        free(rig);
+        return false;
+    }
+    ctx->sim_arm = rig;
+    ctx->arm = &rig->executor;
+    return true;
 }
 
 game_state_type_t handle_menu_state(game_context_t *ctx) {
@@ -58,8 +84,8 @@ game_state_type_t handle_menu_state(game_context_t *ctx) {
             ctx->black_player = PLAYER_HUMAN;
             return GAME_PLAYING;
         case 5:
-            if (ctx->chess.move_count > 0) {
-                print_move_history(&ctx->chess, 20);
+            if (ctx->game.chess.move_count > 0) {
+                print_move_history(&ctx->game.chess, 20);
                 printf("Press Enter to continue...");
                 getchar();
             } else {
@@ -81,14 +107,19 @@ game_state_type_t handle_setup_state(game_context_t *ctx) {
     if (need_engine) {
         printf("\nStarting chess engine...\n");
         
-        if (!uci_start_engine(&ctx->engine, ctx->engine.engine_path)) {
-            strcpy(ctx->status_message, "Failed to start engine. Make sure Stockfish is installed and in PATH.");
+        // A missing Stockfish binary is covered inside uci_start_engine, which runs the internal
+        // search in its place; this only fails when no engine process can be started at all
+        if (!uci_start_engine(&ctx->engine, ctx->engine.engine_path) &&
+            !uci_start_engine(&ctx->engine, UCI_INTERNAL_ENGINE)) {
+            strcpy(ctx->status_message, "Failed to start engine process.");
             printf("Error: %s\n", ctx->status_message);
             printf("Press Enter to return to menu...");
             getchar();
             return GAME_MENU;
         }
         
+        // The console shows the UCI traffic; the server and benches keep stdout for themselves
+        ctx->engine.echo = true;
         printf("Engine started successfully!\n");
     }
     
@@ -97,39 +128,22 @@ game_state_type_t handle_setup_state(game_context_t *ctx) {
 }
 
 game_state_type_t handle_playing_state(game_context_t *ctx) {
-    print_chess_board(&ctx->chess);
+    print_chess_board(&ctx->game.chess);
     print_game_status(ctx);
     
-    // Check for game over conditions
-    if (is_checkmate(&ctx->chess)) {
-        ctx->game_over = true;
-        ctx->winner = (ctx->chess.turn == WHITE) ? BLACK : WHITE;
-        strcpy(ctx->status_message, "Checkmate!");
+    if (ctx->game.result != RESULT_ONGOING) {
+        snprintf(ctx->status_message, sizeof(ctx->status_message), "%s!", game_termination_string(ctx->game.termination));
         return GAME_GAME_OVER;
     }
     
-    if (is_stalemate(&ctx->chess)) {
-        ctx->game_over = true;
-        ctx->winner = COLOR_NONE;
-        strcpy(ctx->status_message, "Stalemate!");
-        return GAME_GAME_OVER;
-    }
-    
-    if (ctx->chess.halfmove_clock >= 50) {
-        ctx->game_over = true;
-        ctx->winner = COLOR_NONE;
-        strcpy(ctx->status_message, "50-move rule draw!");
-        return GAME_GAME_OVER;
-    }
-    
-    // Check/checkmate warning
-    if (is_king_in_check(&ctx->chess, ctx->chess.turn)) {
+    // Check warning
+    if (ctx->game.in_check) {
         printf("*** %s KING IN CHECK! ***\n", 
-               (ctx->chess.turn == WHITE) ? "WHITE" : "BLACK");
+               (ctx->game.chess.turn == WHITE) ? "WHITE" : "BLACK");
     }
     
     // Determine current player type
-    player_type_t current_player = (ctx->chess.turn == WHITE) ? ctx->white_player : ctx->black_player;
+    player_type_t current_player = (ctx->game.chess.turn == WHITE) ? ctx->white_player : ctx->black_player;
     
     if (current_player == PLAYER_HUMAN) {
         return GAME_WAITING_HUMAN;
@@ -138,11 +152,33 @@ game_state_type_t handle_playing_state(game_context_t *ctx) {
     }
 }
 
+static game_state_type_t play_engine_move(game_context_t *ctx, const char *best_move) {
+    printf("Engine plays: %s\n", best_move);
+    
+    move_result_t result = play_game_move(&ctx->game, best_move, now_ms());
+    if (result == MOVE_SUCCESS) {
+        // The arm plays the move while the game carries on; it parks out of view afterwards
+        if (ctx->arm) arm_executor_move(ctx->arm, &ctx->game.chess.move_history[ctx->game.chess.move_count - 1]);
+        snprintf(ctx->last_move, sizeof(ctx->last_move), "%s", best_move);
+        snprintf(ctx->status_message, sizeof(ctx->status_message), 
+                "Engine played: %s", best_move);
+        return GAME_PLAYING;
+    } else {
+        strcpy(ctx->status_message, "Engine made invalid move!");
+        return GAME_ERROR;
+    }
+}
+
 game_state_type_t handle_engine_thinking_state(game_context_t *ctx) {
+    // A forced move is played at once; no engine can do better
+    if (ctx->game.n_legal_moves == 1) {
+        return play_engine_move(ctx, ctx->game.legal_moves[0].notation);
+    }
+    
     printf("Engine is thinking...\n");
     
     // Set position and get move
-    if (!uci_set_position(&ctx->engine, &ctx->chess)) {
+    if (!uci_set_position(&ctx->engine, &ctx->game.chess)) {
         strcpy(ctx->status_message, "Failed to set position");
         return GAME_ERROR;
     }
@@ -152,31 +188,31 @@ game_state_type_t handle_engine_thinking_state(game_context_t *ctx) {
         return GAME_ERROR;
     }
     
-    char best_move[16];
-    if (uci_get_best_move(&ctx->engine, best_move, sizeof(best_move))) {
-        printf("Engine plays: %s\n", best_move);
-        
-        move_result_t result = make_move(&ctx->chess, best_move);
-        if (result == MOVE_SUCCESS) {
-            strcpy(ctx->last_move, best_move);
-            snprintf(ctx->status_message, sizeof(ctx->status_message), 
-                    "Engine played: %s", best_move);
-            return GAME_PLAYING;
-        } else {
-            strcpy(ctx->status_message, "Engine made invalid move!");
-            return GAME_ERROR;
+    // Follow the search so the arm can move over the likely piece before the search ends
+    uci_search_t search;
+    uci_begin_search(&search);
+    time_t deadline = time(NULL) + 10; // Max 10 seconds
+    while (!search.done && time(NULL) < deadline) {
+        if (uci_poll_search(&ctx->engine, &search, 100) && !search.done && ctx->arm) {
+            const move_t *likely = find_game_move(&ctx->game, search.pv_move);
+            if (likely) arm_executor_prepare(ctx->arm, likely);
         }
+    }
+
+    if (search.done && search.best_move[0] != '\0') {
+        return play_engine_move(ctx, search.best_move);
     } else {
-        strcpy(ctx->status_message, "Engine failed to respond or game is over");
-        ctx->game_over = true;
-        ctx->winner = (ctx->chess.turn == WHITE) ? BLACK : WHITE;
+        // A prepare with no move after it would leave the arm over the board, and vision blind
+        if (ctx->arm) arm_executor_park(ctx->arm);
+        strcpy(ctx->status_message, "Engine failed to respond");
+        resign_game(&ctx->game, ctx->game.chess.turn);
         return GAME_GAME_OVER;
     }
 }
 
 game_state_type_t handle_waiting_human_state(game_context_t *ctx) {
     printf("%s to move. Enter your move (e.g., e2e4), 'help', 'history', or 'quit': ", 
-           (ctx->chess.turn == WHITE) ? "White" : "Black");
+           (ctx->game.chess.turn == WHITE) ? "White" : "Black");
     char input[64];
     if (!fgets(input, sizeof(input), stdin)) {
         return GAME_EXIT;
@@ -194,10 +230,10 @@ game_state_type_t handle_waiting_human_state(game_context_t *ctx) {
         return GAME_WAITING_HUMAN;
     }
     if (strcmp(move, "history") == 0) {
-        print_move_history(&ctx->chess, 10);
+        print_move_history(&ctx->game.chess, 10);
         return GAME_WAITING_HUMAN;
     }
-    move_result_t result = make_move(&ctx->chess, move);
+    move_result_t result = play_game_move(&ctx->game, move, now_ms());
     switch (result) {
         case MOVE_SUCCESS:
             strcpy(ctx->last_move, move);
@@ -219,6 +255,9 @@ game_state_type_t handle_waiting_human_state(game_context_t *ctx) {
         case MOVE_KING_IN_CHECK:
             strcpy(ctx->status_message, "Move would leave king in check");
             break;
+        case MOVE_GAME_OVER:
+            strcpy(ctx->status_message, "The game is over");
+            return GAME_PLAYING;
         default:
             strcpy(ctx->status_message, "Move failed");
             break;
@@ -229,17 +268,19 @@ game_state_type_t handle_waiting_human_state(game_context_t *ctx) {
 game_state_type_t handle_game_over_state(game_context_t *ctx) {
     printf("\n=== GAME OVER ===\n");
     
-    if (ctx->winner == COLOR_NONE) {
+    color_t winner = game_winner(&ctx->game);
+    if (winner == COLOR_NONE) {
         printf("Game ended in a draw!\n");
     } else {
-        printf("%s wins!\n", (ctx->winner == WHITE) ? "White" : "Black");
+        printf("%s wins!\n", (winner == WHITE) ? "White" : "Black");
     }
+    printf("Result: %s\n", game_result_string(ctx->game.result));
     
     if (strlen(ctx->status_message) > 0) {
         printf("Reason: %s\n", ctx->status_message);
     }
     
-    print_move_history(&ctx->chess, 10);
+    print_move_history(&ctx->game.chess, 10);
     
     printf("\nOptions:\n");
     printf("1. Play again\n");
@@ -252,16 +293,12 @@ game_state_type_t handle_game_over_state(game_context_t *ctx) {
         clear_input_buffer();
         switch (choice) {
             case 1:
-                init_chess_board(&ctx->chess);
-                ctx->game_over = false;
-                ctx->winner = COLOR_NONE;
+                init_game(&ctx->game, NULL, now_ms());
                 strcpy(ctx->status_message, "New game started");
                 strcpy(ctx->last_move, "");
                 return GAME_SETUP;
             case 2:
-                init_chess_board(&ctx->chess);
-                ctx->game_over = false;
-                ctx->winner = COLOR_NONE;
+                init_game(&ctx->game, NULL, now_ms());
                 strcpy(ctx->status_message, "");
                 strcpy(ctx->last_move, "");
                 return GAME_MENU;
@@ -0,0 +1,146 @@
+#include "vision/annotation_writer.h"
+#include "common/constants.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+void draw_move_annotation(Mat& board, int from_row, int from_col, int to_row, int to_col){
+    const int SQUARE_SIZE = board.cols / 8;
+    Rect from_rect(from_col * SQUARE_SIZE, from_row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE);
+    Rect to_rect(to_col * SQUARE_SIZE, to_row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE);
+    putText(board, "1", Point(from_rect.x + SQUARE_SIZE / 2, from_rect.y + SQUARE_SIZE / 2), FONT_HERSHEY_SIMPLEX, 1.0, Scalar(0, 0, 255), 2);
+    putText(board, "2", Point(to_rect.x + SQUARE_SIZE / 2, to_rect.y + SQUARE_SIZE / 2), FONT_HERSHEY_SIMPLEX, 1.0, Scalar(0, 255, 0), 2);
+    rectangle(board, from_rect, Scalar(0, 0, 255), 2);
+    rectangle(board, to_rect, Scalar(0, 255, 0), 2);
+}
+
+// Codec named by the extension of path; false when it has none or names no supported codec
+static bool codec_from_extension(const string& path, vision_codec_t& codec){
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos || path.find('/', dot) != string::npos) return false;
+    string ext = path.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    if (ext == "jpg" || ext == "jpeg") codec = VISION_CODEC_JPEG;
+    else if (ext == "png") codec = VISION_CODEC_PNG;
+    else if (ext == "bmp") codec = VISION_CODEC_BMP;
+    else return false;
+    return true;
+}
+
+string annotation_image_path(const vision_annotation_config_t& config, const string& path){
+    vision_codec_t codec;
+    if (codec_from_extension(path, codec)) return path;
+    string base = path;
+    size_t dot = base.find_last_of('.');
+    if (dot != string::npos && base.find('/', dot) == string::npos) base.erase(dot);
+    switch (config.codec){
+        case VISION_CODEC_PNG: return base + ".png";
+        case VISION_CODEC_BMP: return base + ".bmp";
+        default: return base + ".jpg";
+    }
+}
+
+bool write_annotation_image(const vision_annotation_config_t& config, const string& path, const Mat& image){
+    vision_codec_t codec = config.codec;
+    codec_from_extension(path, codec);
+    // A quality set for one codec means nothing to another
+    int quality = codec == config.codec ? config.quality : -1;
+    string target = annotation_image_path(config, path);
+    vector<int> params;
+    switch (codec){
+        case VISION_CODEC_PNG:
+            // Level 1 is several times faster than the default 3 for a few percent larger files
+            params = {IMWRITE_PNG_COMPRESSION, quality >= 0 ? min(quality, 9) : 1};
+            return imwrite(target, image, params);
+        case VISION_CODEC_BMP:
+            return imwrite(target, image);
+        default:
+            params = {IMWRITE_JPEG_QUALITY, quality >= 0 ? min(quality, 100) : 80};
+            return imwrite(target, image, params);
+    }
+}
+
+static void writer_loop(annotation_writer& writer){
+    unique_lock<mutex> lock(writer.mutex);
+    while (true){
+        writer.ready.wait(lock, [&writer]{ return writer.stop || !writer.queue.empty(); });
+        if (writer.queue.empty()) break;
+        annotation_job job = std::move(writer.queue.front());
+        writer.queue.pop_front();
+        lock.unlock();
+        const vision_detection_t& d = job.detection;
+        draw_move_annotation(job.board, d.from_row, d.from_col, d.to_row, d.to_col);
+        bool ok = write_annotation_image(writer.config, job.path, job.board);
+        if (!ok) cerr << "Error: Could not write " << annotation_image_path(writer.config, job.path) << endl;
+        lock.lock();
+        writer.spare.push_back(job.board);
+        if (ok) writer.written++; else writer.failed++;
+    }
+}
+
+void start_annotation_writer(annotation_writer& writer, const vision_annotation_config_t* config){
+    if (config){
+        writer.config = *config;
+    } else {
+        writer.config.queue_capacity = 4;
+        writer.config.sample_every = 1;
+        writer.config.low_confidence = 0;
+        writer.config.codec = VISION_CODEC_JPEG;
+        writer.config.quality = -1;
+    }
+    writer.config.queue_capacity = max(1, writer.config.queue_capacity);
+    writer.queue.clear();
+    writer.spare.clear();
+    writer.stop = false;
+    writer.offered = 0;
+    writer.dropped = 0;
+    writer.written = 0;
+    writer.failed = 0;
+    writer.running = true;
+    writer.worker = thread(writer_loop, ref(writer));
+}
+
+bool queue_annotation(annotation_writer& writer, const Mat& board, const vision_detection_t& detection, const string& path){
+    if (!writer.running || !detection.found) return false;
+    const vision_annotation_config_t& config = writer.config;
+    long offered = ++writer.offered;
+    bool sampled = (config.sample_every > 0 && offered % config.sample_every == 0) || detection.confidence < config.low_confidence;
+    if (!sampled) return false;
+    annotation_job job;
+    {
+        // One producer, so the queue cannot fill up between this check and the push below
+        lock_guard<mutex> lock(writer.mutex);
+        if ((int)writer.queue.size() >= config.queue_capacity){
+            writer.dropped++;
+            return false;
+        }
+        if (!writer.spare.empty()){
+            job.board = writer.spare.back();
+            writer.spare.pop_back();
+        }
+    }
+    // Copying into a recycled buffer of the same size does not allocate
+    board.copyTo(job.board);
+    job.detection = detection;
+    job.path = path;
+    {
+        lock_guard<mutex> lock(writer.mutex);
+        writer.queue.push_back(std::move(job));
+    }
+    writer.ready.notify_one();
+    return true;
+}
+
+void stop_annotation_writer(annotation_writer& writer){
+    if (!writer.running) return;
+    {
+        lock_guard<mutex> lock(writer.mutex);
+        writer.stop = true;
+    }
+    writer.ready.notify_one();
+    writer.worker.join();
+    writer.running = false;
+}
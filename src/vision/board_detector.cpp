@@ -0,0 +1,150 @@
+#include "vision/board_detector.h"
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+// Read a board pose from node: a homography, or the four board corners it is computed from
+static bool read_board_pose(const FileNode& node, Mat& homography){
+    node["homography"] >> homography;
+    // Allow the board pose to be given as corners instead of a precomputed homography
+    if (homography.empty()){
+        Mat corners;
+        node["board_corners"] >> corners;
+        if (corners.rows * corners.cols != 8){
+            cerr << "Error: Calibration needs either homography or 4 board_corners" << endl;
+            return false;
+        }
+        corners.convertTo(corners, CV_32F);
+        corners = corners.reshape(1, 4);
+        Point2f pts[4];
+        for (int i = 0; i < 4; i++)
+            pts[i] = Point2f(corners.at<float>(i, 0), corners.at<float>(i, 1));
+        homography = compute_board_homography(pts);
+    }
+    return true;
+}
+
+bool load_board_calibration(const string& path, board_calibration& calib){
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()){
+        cerr << "Error: Could not open calibration file " << path << endl;
+        return false;
+    }
+    fs["camera_matrix"] >> calib.camera_matrix;
+    fs["dist_coeffs"] >> calib.dist_coeffs;
+    FileNode root = fs.root();
+    return read_board_pose(root, calib.homography);
+}
+
+bool load_multi_board_calibration(const string& path, vector<board_calibration>& boards){
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()){
+        cerr << "Error: Could not open calibration file " << path << endl;
+        return false;
+    }
+    Mat camera_matrix, dist_coeffs;
+    fs["camera_matrix"] >> camera_matrix;
+    fs["dist_coeffs"] >> dist_coeffs;
+    FileNode list = fs["boards"];
+    if (!list.isSeq() || list.size() == 0){
+        cerr << "Error: Calibration file " << path << " has no boards sequence" << endl;
+        return false;
+    }
+    boards.clear();
+    for (size_t i = 0; i < list.size(); i++){
+        board_calibration calib;
+        // Every board shares the camera intrinsics and has its own pose
+        calib.camera_matrix = camera_matrix;
+        calib.dist_coeffs = dist_coeffs;
+        if (!read_board_pose(list[(int)i], calib.homography)) return false;
+        boards.push_back(calib);
+    }
+    return true;
+}
+
+Mat compute_board_homography(const Point2f corners[4]){
+    // Corners are a8, h8, h1, a1 so that row 0 of the board image is rank 8
+    const Point2f board[4] = {Point2f(0, 0), Point2f(1, 0), Point2f(1, 1), Point2f(0, 1)};
+    Mat homography = getPerspectiveTransform(corners, board);
+    homography.convertTo(homography, CV_64F);
+    return homography;
+}
+
+bool build_board_remap(const board_calibration& calib, Size frame_size, int board_pixels, board_remap& remap){
+    if (calib.homography.rows != 3 || calib.homography.cols != 3 || board_pixels <= 0){
+        cerr << "Error: Invalid board homography" << endl;
+        return false;
+    }
+    // Without intrinsics the homography is applied to raw pixels and undistortion is skipped
+    bool undistort = calib.camera_matrix.rows == 3 && calib.camera_matrix.cols == 3;
+    double fx = 1, fy = 1, cx = 0, cy = 0;
+    double k1 = 0, k2 = 0, p1 = 0, p2 = 0, k3 = 0;
+    if (undistort){
+        Mat K;
+        calib.camera_matrix.convertTo(K, CV_64F);
+        fx = K.at<double>(0, 0);
+        fy = K.at<double>(1, 1);
+        cx = K.at<double>(0, 2);
+        cy = K.at<double>(1, 2);
+        if (!calib.dist_coeffs.empty()){
+            Mat D;
+            calib.dist_coeffs.convertTo(D, CV_64F);
+            D = D.reshape(1, 1);
+            if (D.cols > 0) k1 = D.at<double>(0);
+            if (D.cols > 1) k2 = D.at<double>(1);
+            if (D.cols > 2) p1 = D.at<double>(2);
+            if (D.cols > 3) p2 = D.at<double>(3);
+            if (D.cols > 4) k3 = D.at<double>(4);
+        }
+    }
+    // Board -> undistorted camera pixel
+    Mat H;
+    calib.homography.convertTo(H, CV_64F);
+    Mat H_inv = H.inv();
+    const double* h = H_inv.ptr<double>(0);
+    // Float maps are only needed while building the fixed-point table
+    Mat map_x(board_pixels, board_pixels, CV_32FC1);
+    Mat map_y(board_pixels, board_pixels, CV_32FC1);
+    for (int v = 0; v < board_pixels; v++){
+        float* mx = map_x.ptr<float>(v);
+        float* my = map_y.ptr<float>(v);
+        double by = (v + 0.5) / board_pixels;
+        for (int u = 0; u < board_pixels; u++){
+            double bx = (u + 0.5) / board_pixels;
+            // Perspective: board plane -> undistorted image
+            double w = h[6] * bx + h[7] * by + h[8];
+            double xu = (h[0] * bx + h[1] * by + h[2]) / w;
+            double yu = (h[3] * bx + h[4] * by + h[5]) / w;
+            if (!undistort){
+                mx[u] = (float)xu;
+                my[u] = (float)yu;
+                continue;
+            }
+            // Lens model: undistorted -> distorted (raw) image
+            double x = (xu - cx) / fx;
+            double y = (yu - cy) / fy;
+            double r2 = x * x + y * y;
+            double radial = 1 + r2 * (k1 + r2 * (k2 + r2 * k3));
+            double xd = x * radial + 2 * p1 * x * y + p2 * (r2 + 2 * x * x);
+            double yd = y * radial + p1 * (r2 + 2 * y * y) + 2 * p2 * x * y;
+            mx[u] = (float)(fx * xd + cx);
+            my[u] = (float)(fy * yd + cy);
+        }
+    }
+    // Fixed-point maps are about twice as fast to apply as float maps
+    convertMaps(map_x, map_y, remap.map_xy, remap.map_frac, CV_16SC2, false);
+    remap.frame_size = frame_size;
+    remap.board_pixels = board_pixels;
+    return true;
+}
+
+bool warp_board_frame(const board_remap& remap, const Mat& frame, Mat& board_out){
+    if (remap.map_xy.empty() || frame.empty()) return false;
+    if (frame.size() != remap.frame_size){
+        cerr << "Error: Frame size does not match the remap table" << endl;
+        return false;
+    }
+    cv::remap(frame, board_out, remap.map_xy, remap.map_frac, INTER_LINEAR, BORDER_CONSTANT);
+    return true;
+}
\ No newline at end of file
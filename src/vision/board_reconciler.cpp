@@ -0,0 +1,206 @@
+#include "vision/board_reconciler.h"
+#include "game/chess_state.h"
+#include "game/move_validation.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+using namespace cv;
+using namespace std;
+
+static int occupancy_distance(const board_occupancy_t& a, const board_occupancy_t& b){
+    return compare_board_occupancy(&a, &b, NULL, 0);
+}
+
+// Search continuations of the last known position for the one whose occupancy best matches
+// the observation. At most one mismatching square is tolerated, for a misclassified square.
+static bool replay_moves(const chess_state_t* last_known, const board_occupancy_t& observed, chess_state_t* out, reconcile_report& report){
+    unique_ptr<chess_state_t[]> states(new chess_state_t[RECONCILE_MAX_DEPTH]);
+    unique_ptr<move_t[]> moves(new move_t[RECONCILE_MAX_DEPTH * MAX_LEGAL_MOVES]);
+    int counts[RECONCILE_MAX_DEPTH];
+    int path[RECONCILE_MAX_DEPTH];
+    int best_distance = 1, best_depth = 0;
+    bool ambiguous = false;
+    board_occupancy_t occ;
+    // Iterative deepening; a deeper line only wins with a strictly better match
+    for (int max_depth = 1; max_depth <= RECONCILE_MAX_DEPTH && (best_depth == 0 || best_distance > 0); max_depth++){
+        int depth = 0;
+        counts[0] = generate_legal_moves(last_known, moves.get(), MAX_LEGAL_MOVES);
+        path[0] = -1;
+        while (depth >= 0){
+            if (++path[depth] >= counts[depth]){
+                depth--;
+                continue;
+            }
+            const chess_state_t* parent = depth == 0 ? last_known : &states[depth - 1];
+            states[depth] = *parent;
+            make_move(&states[depth], moves[depth * MAX_LEGAL_MOVES + path[depth]].notation);
+            if (depth + 1 < max_depth){
+                depth++;
+                counts[depth] = generate_legal_moves(&states[depth - 1], &moves[depth * MAX_LEGAL_MOVES], MAX_LEGAL_MOVES);
+                path[depth] = -1;
+                continue;
+            }
+            chess_state_to_occupancy(&states[depth], &occ);
+            int distance = occupancy_distance(occ, observed);
+            if (distance > best_distance) continue;
+            if (distance == best_distance && best_depth > 0){
+                // Transpositions reach the same board and are not a real ambiguity
+                if (best_depth == max_depth && memcmp(states[depth].board, out->board, sizeof(out->board)) != 0) ambiguous = true;
+                continue;
+            }
+            best_distance = distance;
+            best_depth = max_depth;
+            ambiguous = false;
+            *out = states[depth];
+        }
+    }
+    if (best_depth == 0) return false;
+    report.method = RECONCILE_REPLAYED;
+    report.moves_replayed = best_depth;
+    // Recover the notation of the chosen line from the replayed history
+    for (int d = 0; d < best_depth; d++)
+        snprintf(report.moves[d], sizeof(report.moves[d]), "%s", out->move_history[out->move_count - best_depth + d].notation);
+    report.occupancy_mismatches = best_distance;
+    report.ambiguous = ambiguous;
+    return true;
+}
+
+// Assign a piece type to every occupied square, then repair the assignment until it is
+// materially plausible, always changing the square that loses the least score
+static bool assign_piece_types(double scores[64][KING + 1], const board_occupancy_t& observed, color_t colour, piece_type_t types[64]){
+    const unsigned char mine = colour == WHITE ? SQUARE_WHITE_PIECE : SQUARE_BLACK_PIECE;
+    int squares[64], n = 0;
+    for (int sq = 0; sq < 64; sq++){
+        if (observed.squares[sq] != mine) continue;
+        squares[n++] = sq;
+        // Pawns never stand on the first or last rank
+        if (sq / 8 == 0 || sq / 8 == 7) scores[sq][PAWN] = -1e9;
+    }
+    if (n == 0 || n > 16) return false;
+    int king = squares[0];
+    for (int i = 1; i < n; i++)
+        if (scores[squares[i]][KING] > scores[king][KING]) king = squares[i];
+    for (int i = 0; i < n; i++){
+        int sq = squares[i];
+        if (sq != king) scores[sq][KING] = -1e9;
+        types[sq] = PAWN;
+        for (int t = KNIGHT; t <= KING; t++)
+            if (scores[sq][t] > scores[sq][types[sq]]) types[sq] = (piece_type_t)t;
+    }
+    const int START_COUNT[KING + 1] = {0, 8, 2, 2, 2, 1, 1};
+    for (int iteration = 0; iteration < 64; iteration++){
+        int count[KING + 1] = {0};
+        for (int i = 0; i < n; i++) count[types[squares[i]]]++;
+        int promoted = 0;
+        for (int t = KNIGHT; t <= QUEEN; t++) promoted += max(0, count[t] - START_COUNT[t]);
+        bool too_many_pawns = count[PAWN] > 8;
+        if (!too_many_pawns && promoted <= 8 - count[PAWN]) return true;
+        // Move the cheapest square off an over-represented type onto its next best type
+        int best_sq = -1;
+        piece_type_t best_type = EMPTY;
+        double best_loss = 1e18;
+        for (int i = 0; i < n; i++){
+            int sq = squares[i];
+            piece_type_t t = types[sq];
+            bool over = too_many_pawns ? t == PAWN : (t != PAWN && t != KING && count[t] > START_COUNT[t]);
+            if (!over) continue;
+            for (int alt = PAWN; alt <= QUEEN; alt++){
+                if (alt == t) continue;
+                // Surplus promoted material can only become a pawn or a type still below its start count
+                if (!too_many_pawns && alt != PAWN && count[alt] >= START_COUNT[alt]) continue;
+                double loss = scores[sq][t] - scores[sq][alt];
+                if (scores[sq][alt] > -1e8 && loss < best_loss){
+                    best_loss = loss;
+                    best_sq = sq;
+                    best_type = (piece_type_t)alt;
+                }
+            }
+        }
+        if (best_sq < 0) return false;
+        types[best_sq] = best_type;
+    }
+    return false;
+}
+
+// Rebuild the position square by square from the observed occupancy
+static bool rebuild_position(piece_recognizer* pieces, const Mat& board, const board_occupancy_t& observed,
+                             const chess_state_t* last_known, color_t turn, chess_state_t* out, reconcile_report& report){
+    double scores[64][KING + 1];
+    for (int sq = 0; sq < 64; sq++){
+        color_t colour = observed.squares[sq] == SQUARE_WHITE_PIECE ? WHITE : (observed.squares[sq] == SQUARE_BLACK_PIECE ? BLACK : COLOR_NONE);
+        if (colour == COLOR_NONE) continue;
+        if (pieces && piece_type_scores(*pieces, board, sq / 8, sq % 8, colour, scores[sq])) continue;
+        // Without a recogniser the only evidence is what stood on the square before
+        const piece_t* known = last_known ? &last_known->board[sq / 8][sq % 8] : NULL;
+        if (!known || known->color != colour){
+            cerr << "Error: Cannot identify the piece on square " << sq << " without a piece recogniser" << endl;
+            return false;
+        }
+        for (int t = EMPTY; t <= KING; t++) scores[sq][t] = t == known->type ? 1.0 : 0.0;
+    }
+    piece_type_t types[64];
+    if (!assign_piece_types(scores, observed, WHITE, types) || !assign_piece_types(scores, observed, BLACK, types)){
+        cerr << "Error: Observed board is not a plausible position" << endl;
+        return false;
+    }
+    if (last_known){
+        *out = *last_known;
+    } else {
+        init_chess_board(out);
+    }
+    for (int row = 0; row < BOARD_SIZE; row++)
+        for (int col = 0; col < BOARD_SIZE; col++){
+            int sq = row * BOARD_SIZE + col;
+            unsigned char state = observed.squares[sq];
+            out->board[row][col].type = state == SQUARE_EMPTY ? EMPTY : types[sq];
+            out->board[row][col].color = state == SQUARE_EMPTY ? COLOR_NONE : (state == SQUARE_WHITE_PIECE ? WHITE : BLACK);
+        }
+    if (turn != COLOR_NONE) out->turn = turn;
+    // Castling survives only where king and rook are still at home
+    const piece_t* b = &out->board[0][0];
+    bool white_king = b[7 * 8 + 4].type == KING && b[7 * 8 + 4].color == WHITE;
+    bool black_king = b[4].type == KING && b[4].color == BLACK;
+    out->white_can_castle_kingside &= white_king && b[7 * 8 + 7].type == ROOK && b[7 * 8 + 7].color == WHITE;
+    out->white_can_castle_queenside &= white_king && b[7 * 8].type == ROOK && b[7 * 8].color == WHITE;
+    out->black_can_castle_kingside &= black_king && b[7].type == ROOK && b[7].color == BLACK;
+    out->black_can_castle_queenside &= black_king && b[0].type == ROOK && b[0].color == BLACK;
+    strcpy(out->en_passant_target, "-");
+    out->halfmove_clock = 0;
+    out->move_count = 0;
+    if (is_king_in_check(out, out->turn == WHITE ? BLACK : WHITE)){
+        cerr << "Error: Rebuilt position leaves the side not to move in check" << endl;
+        return false;
+    }
+    report.method = RECONCILE_REBUILT;
+    report.occupancy_mismatches = 0;
+    return true;
+}
+
+bool reconcile_board_state(occupancy_classifier& classifier, piece_recognizer* pieces, const Mat& board,
+                           const chess_state_t* last_known, color_t turn, chess_state_t* out, reconcile_report* report){
+    reconcile_report local;
+    if (!report) report = &local;
+    memset(report, 0, sizeof(*report));
+    if (!out) return false;
+    int64_t start = getTickCount();
+    board_occupancy_t observed;
+    if (!classify_board_occupancy(classifier, board, &observed)) return false;
+    bool ok = false;
+    if (last_known){
+        board_occupancy_t expected;
+        chess_state_to_occupancy(last_known, &expected);
+        if (occupancy_distance(expected, observed) == 0){
+            *out = *last_known;
+            report->method = RECONCILE_UNCHANGED;
+            ok = true;
+        } else {
+            ok = replay_moves(last_known, observed, out, *report);
+        }
+    }
+    if (!ok) ok = rebuild_position(pieces, board, observed, last_known, turn, out, *report);
+    if (ok) chess_state_to_fen(out, report->fen, sizeof(report->fen));
+    report->elapsed_ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    return ok;
+}
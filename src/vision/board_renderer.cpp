@@ -0,0 +1,155 @@
+#include "vision/board_renderer.h"
+#include "common/constants.h"
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const char piece_letters[KING + 1] = {'?', 'P', 'N', 'B', 'R', 'Q', 'K'};
+
+// Outlines on a 50x50 design grid, scaled to the square size
+static Point design_point(int x, int y){
+    return Point(x * VISION_SQUARE_PIXELS / 50, y * VISION_SQUARE_PIXELS / 50);
+}
+
+static void fill_polygon(Mat& mask, const vector<Point>& design, uchar value){
+    vector<Point> points;
+    for (const Point& p : design) points.push_back(design_point(p.x, p.y));
+    fillPoly(mask, vector<vector<Point>>{points}, Scalar(value), LINE_AA);
+}
+
+static void fill_rect(Mat& mask, int x0, int y0, int x1, int y1, uchar value){
+    rectangle(mask, design_point(x0, y0), design_point(x1, y1), Scalar(value), FILLED);
+}
+
+static void fill_circle(Mat& mask, int x, int y, int radius, uchar value){
+    circle(mask, design_point(x, y), radius * VISION_SQUARE_PIXELS / 50, Scalar(value), FILLED, LINE_AA);
+}
+
+// Silhouette of one piece type; every type differs in outline so template matching can tell them apart
+static void draw_silhouette(Mat& mask, piece_type_t type){
+    mask = Mat::zeros(VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS, CV_8U);
+    switch (type){
+        case PAWN:
+            fill_circle(mask, 25, 17, 6, 255);
+            fill_polygon(mask, {{19, 37}, {31, 37}, {27, 21}, {23, 21}}, 255);
+            fill_rect(mask, 15, 36, 35, 42, 255);
+            break;
+        case KNIGHT:
+            fill_polygon(mask, {{14, 42}, {36, 42}, {34, 28}, {37, 17}, {28, 7}, {21, 8}, {11, 20}, {13, 26}, {22, 23}, {17, 33}}, 255);
+            fill_circle(mask, 27, 14, 2, 0);
+            break;
+        case BISHOP:
+            fill_circle(mask, 25, 7, 3, 255);
+            ellipse(mask, design_point(25, 23), Size(8 * VISION_SQUARE_PIXELS / 50, 13 * VISION_SQUARE_PIXELS / 50), 0, 0, 360, Scalar(255), FILLED, LINE_AA);
+            fill_polygon(mask, {{26, 14}, {28, 15}, {24, 24}, {22, 23}}, 0);
+            fill_rect(mask, 13, 36, 37, 42, 255);
+            break;
+        case ROOK:
+            fill_rect(mask, 13, 8, 37, 17, 255);
+            fill_rect(mask, 19, 8, 22, 12, 0);
+            fill_rect(mask, 28, 8, 31, 12, 0);
+            fill_rect(mask, 16, 16, 34, 37, 255);
+            fill_rect(mask, 12, 36, 38, 42, 255);
+            break;
+        case QUEEN:
+            fill_polygon(mask, {{13, 40}, {37, 40}, {41, 12}, {32, 24}, {25, 8}, {18, 24}, {9, 12}}, 255);
+            fill_circle(mask, 9, 11, 3, 255);
+            fill_circle(mask, 25, 7, 3, 255);
+            fill_circle(mask, 41, 11, 3, 255);
+            fill_rect(mask, 11, 38, 39, 43, 255);
+            break;
+        case KING:
+            fill_polygon(mask, {{15, 40}, {35, 40}, {33, 17}, {17, 17}}, 255);
+            fill_rect(mask, 23, 3, 27, 16, 255);
+            fill_rect(mask, 19, 6, 31, 10, 255);
+            fill_rect(mask, 12, 38, 38, 43, 255);
+            break;
+        default:
+            break;
+    }
+}
+
+// Flat body with a contrasting rim, the way a lit piece looks from above
+static void build_sprite(const Mat& mask, color_t color, Mat& sprite){
+    Scalar body = color == WHITE ? Scalar(228, 232, 236) : Scalar(38, 36, 34);
+    Scalar rim = color == WHITE ? Scalar(70, 70, 70) : Scalar(150, 150, 150);
+    Mat inner;
+    erode(mask, inner, getStructuringElement(MORPH_ELLIPSE, Size(3, 3)), Point(-1, -1), 2);
+    sprite.create(mask.size(), CV_8UC3);
+    sprite.setTo(rim);
+    sprite.setTo(body, inner);
+}
+
+static bool load_sprite(const string& path, Mat& sprite, Mat& mask){
+    Mat image = imread(path, IMREAD_UNCHANGED);
+    if (image.empty() || image.channels() != 4){
+        cerr << "Error: Could not load sprite " << path << " (expected an image with alpha)" << endl;
+        return false;
+    }
+    resize(image, image, Size(VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS), 0, 0, INTER_AREA);
+    vector<Mat> channels;
+    split(image, channels);
+    mask = channels[3];
+    channels.pop_back();
+    merge(channels, sprite);
+    return true;
+}
+
+bool init_board_renderer(board_renderer& renderer, const board_renderer_config* config){
+    if (config){
+        renderer.config = *config;
+    } else {
+        renderer.config.light_square = Scalar(181, 217, 240);
+        renderer.config.dark_square = Scalar(99, 136, 181);
+        renderer.config.noise_sigma = 2.0;
+        renderer.config.light_jitter = 3.0;
+        renderer.config.sprite_dir.clear();
+        renderer.config.seed = 1;
+    }
+    renderer.rng = RNG(renderer.config.seed);
+
+    renderer.background.create(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS, CV_8UC3);
+    for (int row = 0; row < 8; row++)
+        for (int col = 0; col < 8; col++){
+            Rect square(col * VISION_SQUARE_PIXELS, row * VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS);
+            renderer.background(square).setTo((row + col) % 2 == 0 ? renderer.config.light_square : renderer.config.dark_square);
+        }
+
+    for (int c = 0; c < 2; c++)
+        for (int type = PAWN; type <= KING; type++){
+            color_t color = c == 0 ? WHITE : BLACK;
+            if (!renderer.config.sprite_dir.empty()){
+                string path = renderer.config.sprite_dir + "/" + (c == 0 ? 'w' : 'b') + piece_letters[type] + ".png";
+                if (!load_sprite(path, renderer.sprites[c][type], renderer.masks[c][type])) return false;
+            } else {
+                draw_silhouette(renderer.masks[c][type], (piece_type_t)type);
+                build_sprite(renderer.masks[c][type], color, renderer.sprites[c][type]);
+            }
+        }
+    return true;
+}
+
+void render_board(board_renderer& renderer, const chess_state_t* chess, Mat& board){
+    renderer.background.copyTo(board);
+    for (int row = 0; row < 8; row++)
+        for (int col = 0; col < 8; col++){
+            piece_t piece = chess->board[row][col];
+            if (piece.type == EMPTY || piece.color == COLOR_NONE) continue;
+            int c = piece.color == WHITE ? 0 : 1;
+            Rect square(col * VISION_SQUARE_PIXELS, row * VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS);
+            Mat target = board(square);
+            renderer.sprites[c][piece.type].copyTo(target, renderer.masks[c][piece.type]);
+        }
+    // Global lighting drift plus sensor noise, both saturating
+    const board_renderer_config& config = renderer.config;
+    double offset = config.light_jitter > 0 ? renderer.rng.uniform(-config.light_jitter, config.light_jitter) : 0.0;
+    if (config.noise_sigma > 0){
+        renderer.noise.create(board.size(), CV_16SC3);
+        renderer.rng.fill(renderer.noise, RNG::NORMAL, Scalar::all(offset), Scalar::all(config.noise_sigma));
+        add(board, renderer.noise, board, noArray(), CV_8U);
+    } else if (offset != 0.0){
+        board.convertTo(board, -1, 1.0, offset);
+    }
+}
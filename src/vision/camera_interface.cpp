@@ -0,0 +1,77 @@
+#include "vision/camera_interface.h"
+#include <sys/stat.h>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+
+using namespace cv;
+using namespace std;
+
+static bool is_image_file(const string& path){
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos) return false;
+    string ext = path.substr(dot + 1);
+    transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return (char)tolower(c); });
+    return ext == "png" || ext == "jpg" || ext == "jpeg" || ext == "bmp";
+}
+
+static bool is_device_index(const string& spec){
+    return !spec.empty() && all_of(spec.begin(), spec.end(), [](unsigned char c){ return isdigit(c) != 0; });
+}
+
+bool open_camera_source(camera_source& source, const string& spec){
+    close_camera_source(source);
+    struct stat st;
+    if (stat(spec.c_str(), &st) == 0 && S_ISDIR(st.st_mode)){
+        vector<string> files;
+        glob(spec + "/*", files, false);
+        for (const string& file : files)
+            if (is_image_file(file)) source.image_files.push_back(file);
+        sort(source.image_files.begin(), source.image_files.end());
+        if (source.image_files.empty()){
+            cerr << "Error: No images found in " << spec << endl;
+            return false;
+        }
+        source.is_directory = true;
+    } else if (is_device_index(spec)){
+        if (!source.capture.open(stoi(spec))){
+            cerr << "Error: Could not open camera " << spec << endl;
+            return false;
+        }
+    } else if (!source.capture.open(spec)){
+        cerr << "Error: Could not open video " << spec << endl;
+        return false;
+    }
+    source.is_open = true;
+    return true;
+}
+
+bool read_camera_frame(camera_source& source, Mat& frame){
+    if (!source.is_open) return false;
+    if (source.is_directory){
+        while (source.next_image < source.image_files.size()){
+            frame = imread(source.image_files[source.next_image++]);
+            if (!frame.empty()) return true;
+        }
+        return false;
+    }
+    return source.capture.read(frame) && !frame.empty();
+}
+
+bool skip_camera_frame(camera_source& source){
+    if (!source.is_open) return false;
+    if (source.is_directory){
+        if (source.next_image >= source.image_files.size()) return false;
+        source.next_image++;
+        return true;
+    }
+    return source.capture.grab();
+}
+
+void close_camera_source(camera_source& source){
+    if (source.capture.isOpened()) source.capture.release();
+    source.image_files.clear();
+    source.next_image = 0;
+    source.is_directory = false;
+    source.is_open = false;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "vision/frame_gate.h"
+#include <utility>
+
+using namespace cv;
+using namespace std;
+
+void init_frame_gate(frame_gate& gate, const frame_gate_config* config){
+    if (config){
+        gate.config = *config;
+    } else {
+        gate.config.thumb_size = 64;
+        gate.config.motion_threshold = 2.0;
+        gate.config.settle_frames = 5;
+        gate.config.cell_threshold = 12.0;
+        gate.config.max_changed_cells = 6;
+    }
+    gate.has_prev = false;
+    gate.has_reference = false;
+    gate.reported = false;
+    gate.settled_count = 0;
+    gate.motion_energy = 0;
+    gate.changed_cells = 0;
+}
+
+// Number of 8x8 grid cells whose mean difference against the reference exceeds the threshold
+static int count_changed_cells(frame_gate& gate, const Mat& thumb){
+    absdiff(thumb, gate.reference, gate.diff);
+    int cell = gate.config.thumb_size / 8;
+    int changed = 0;
+    for (int row = 0; row < 8; row++)
+        for (int col = 0; col < 8; col++){
+            if (mean(gate.diff(Rect(col * cell, row * cell, cell, cell)))[0] > gate.config.cell_threshold) changed++;
+        }
+    return changed;
+}
+
+frame_gate_state update_frame_gate(frame_gate& gate, const Mat& frame){
+    // Downsample first so colour conversion and differencing touch only a few thousand pixels
+    const int size = gate.config.thumb_size;
+    resize(frame, gate.small, Size(size, size), 0, 0, INTER_AREA);
+    if (gate.small.channels() == 3){
+        cvtColor(gate.small, gate.gray, COLOR_BGR2GRAY);
+    } else {
+        gate.small.copyTo(gate.gray);
+    }
+    if (!gate.has_prev){
+        swap(gate.gray, gate.prev);
+        gate.has_prev = true;
+        return GATE_SETTLING;
+    }
+    absdiff(gate.gray, gate.prev, gate.diff);
+    gate.motion_energy = mean(gate.diff)[0];
+    // Keep this thumbnail as the previous one without copying pixels
+    swap(gate.gray, gate.prev);
+    if (gate.motion_energy > gate.config.motion_threshold){
+        gate.settled_count = 0;
+        gate.reported = false;
+        return GATE_MOVING;
+    }
+    if (++gate.settled_count < gate.config.settle_frames) return GATE_SETTLING;
+    if (!gate.has_reference){
+        // The first settled view becomes the reference board
+        gate.prev.copyTo(gate.reference);
+        gate.has_reference = true;
+        gate.reported = true;
+        gate.changed_cells = 0;
+        return GATE_IDLE;
+    }
+    gate.changed_cells = count_changed_cells(gate, gate.prev);
+    if (gate.changed_cells > gate.config.max_changed_cells) return GATE_OCCLUDED;
+    if (gate.changed_cells == 0 || gate.reported) return GATE_IDLE;
+    gate.reported = true;
+    return GATE_STABLE;
+}
+
+void set_frame_gate_reference(frame_gate& gate){
+    if (!gate.has_prev) return;
+    gate.prev.copyTo(gate.reference);
+    gate.has_reference = true;
+}
\ No newline at end of file
@@ -1,133 +1,618 @@
-    #include <opencv2/opencv.hpp>
-    #include <iostream>
-    #include <vector>
-    #include <algorithm>
-
-    using namespace cv;
-    using namespace std;
-
-    // Struc to save chessboard square information
-    struct square_info{
-        int row;
-        int col;
-        double diff_score;
-        double avg_intensity_prev;
-        double avg_intensity_curr;
-    };
-
-    // Function to calculate differences between two chessboard states
-    vector<square_info> calculate_square_differences(const Mat& diff_image, const Mat& prev_gray, const Mat& curr_gray, int square_size){
-        vector<square_info> squares;
-        for(int row = 0; row < 8; row++)
-            for (int col = 0; col < 8; col++){
-                // Calculate ROI for each square
-                int x = col * square_size;
-                int y = row * square_size;
-                Rect roi(x, y, square_size, square_size);
-                // Extract square region from diff image
-                Mat square_diff = diff_image(roi);
-                Mat square_prev = prev_gray(roi);
-                Mat square_curr = curr_gray(roi);
-                // Calculate average intensity in the square region
-                double diff_score = (double)countNonZero(square_diff) / (square_size * square_size);
-                // Calculate average intensity in previous and current frames
-                Scalar avg_prev = mean(square_prev);
-                Scalar avg_curr = mean(square_curr);
-                // Save square information
-                square_info info;
-                info.row = row;
-                info.col = col;
-                info.diff_score = diff_score;
-                info.avg_intensity_prev = avg_prev[0];
-                info.avg_intensity_curr = avg_curr[0];
-                squares.push_back(info);
+#include "vision/move_detector.h"
+#include "game/move_validation.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+// Function to calculate differences between two chessboard states
+void calculate_square_differences(const Mat& diff_image, const Mat& prev_gray, const Mat& curr_gray, int square_size, array<square_info, 64>& squares){
+    for(int row = 0; row < 8; row++)
+        for (int col = 0; col < 8; col++){
+            // Calculate ROI for each square
+            int x = col * square_size;
+            int y = row * square_size;
+            Rect roi(x, y, square_size, square_size);
+            // Extract square region from diff image
+            Mat square_diff = diff_image(roi);
+            Mat square_prev = prev_gray(roi);
+            Mat square_curr = curr_gray(roi);
+            // Calculate average intensity in the square region
+            double diff_score = (double)countNonZero(square_diff) / (square_size * square_size);
+            // Calculate average intensity in previous and current frames
+            Scalar avg_prev = mean(square_prev);
+            Scalar avg_curr = mean(square_curr);
+            // Save square information
+            square_info& info = squares[row * 8 + col];
+            info.row = row;
+            info.col = col;
+            info.diff_score = diff_score;
+            info.avg_intensity_prev = avg_prev[0];
+            info.avg_intensity_curr = avg_curr[0];
+        }
+}
+
+vector<square_info> calculate_square_differences(const Mat& diff_image, const Mat& prev_gray, const Mat& curr_gray, int square_size){
+    array<square_info, 64> squares;
+    calculate_square_differences(diff_image, prev_gray, curr_gray, square_size, squares);
+    return vector<square_info>(squares.begin(), squares.end());
+}
+
+// 5x5 binomial blur, the kernel GaussianBlur(Size(5, 5), 0) uses, written into preallocated
+// buffers so the per-frame path does not depend on OpenCV's internal filter allocations.
+// Only dst(region) is written; src must be valid within two pixels of the region.
+static void binomial_blur5(const Mat& src, Mat& tmp, Mat& dst, const Rect& region){
+    const int rows = src.rows, cols = src.cols;
+    const int x0 = region.x, x1 = region.x + region.width;
+    const int y0 = region.y, y1 = region.y + region.height;
+    // Reflect-101 border, as BORDER_DEFAULT
+    auto reflect = [](int i, int n){ return i < 0 ? -i : (i >= n ? 2 * n - 2 - i : i); };
+    for (int y = max(0, y0 - 2); y < min(rows, y1 + 2); y++){
+        const uchar* s = src.ptr<uchar>(y);
+        ushort* t = tmp.ptr<ushort>(y);
+        for (int x = x0; x < x1; x++){
+            if (x >= 2 && x < cols - 2){
+                t[x] = (ushort)(s[x - 2] + 4 * s[x - 1] + 6 * s[x] + 4 * s[x + 1] + s[x + 2]);
+            } else {
+                t[x] = (ushort)(s[reflect(x - 2, cols)] + 4 * s[reflect(x - 1, cols)] + 6 * s[x] + 4 * s[reflect(x + 1, cols)] + s[reflect(x + 2, cols)]);
+            }
+        }
+    }
+    for (int y = y0; y < y1; y++){
+        const ushort* r0 = tmp.ptr<ushort>(reflect(y - 2, rows));
+        const ushort* r1 = tmp.ptr<ushort>(reflect(y - 1, rows));
+        const ushort* r2 = tmp.ptr<ushort>(y);
+        const ushort* r3 = tmp.ptr<ushort>(reflect(y + 1, rows));
+        const ushort* r4 = tmp.ptr<ushort>(reflect(y + 2, rows));
+        uchar* d = dst.ptr<uchar>(y);
+        for (int x = x0; x < x1; x++)
+            d[x] = (uchar)((r0[x] + 4 * r1[x] + 6 * r2[x] + 4 * r3[x] + r4[x] + 128) >> 8);
+    }
+}
+
+static Rect square_rect(int square){
+    return Rect((square % 8) * VISION_SQUARE_PIXELS, (square / 8) * VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS, VISION_SQUARE_PIXELS);
+}
+
+// Convert part of a rectified board to grayscale and blur it to reduce noise before differencing.
+// The blur reads two pixels beyond the region, so those are converted as well.
+static void prepare_gray(move_detector_context& ctx, const Mat& board, Mat& gray, const Rect& region){
+    int x0 = max(0, region.x - 2), y0 = max(0, region.y - 2);
+    int x1 = min(board.cols, region.x + region.width + 2), y1 = min(board.rows, region.y + region.height + 2);
+    Rect margin(x0, y0, x1 - x0, y1 - y0);
+    Mat gray_roi = ctx.gray(margin);
+    cvtColor(board(margin), gray_roi, COLOR_BGR2GRAY);
+    binomial_blur5(ctx.gray, ctx.blur_tmp, gray, region);
+}
+
+// Mean luminance of each cell of VISION_SIGNATURE_CELLS x VISION_SIGNATURE_CELLS per square,
+// sampled on every other pixel in each direction so it reads a quarter of the board
+static void compute_board_signature(const Mat& board, Mat& signature){
+    const int CELL = VISION_SQUARE_PIXELS / VISION_SIGNATURE_CELLS;
+    const int GRID = 8 * VISION_SIGNATURE_CELLS;
+    const int SAMPLES = ((CELL + 1) / 2) * ((CELL + 1) / 2);
+    int sums[8 * VISION_SIGNATURE_CELLS];
+    for (int cy = 0; cy < GRID; cy++){
+        for (int cx = 0; cx < GRID; cx++) sums[cx] = 0;
+        for (int y = cy * CELL; y < (cy + 1) * CELL; y += 2){
+            const uchar* p = board.ptr<uchar>(y);
+            for (int cx = 0; cx < GRID; cx++){
+                for (int x = cx * CELL; x < (cx + 1) * CELL; x += 2)
+                    sums[cx] += (29 * p[3 * x] + 150 * p[3 * x + 1] + 77 * p[3 * x + 2]) >> 8;
             }
-        return squares;
+        }
+        uchar* out = signature.ptr<uchar>(cy);
+        for (int cx = 0; cx < GRID; cx++) out[cx] = (uchar)(sums[cx] / SAMPLES);
     }
+}
 
-    bool detect_chess_move(const string& prev_image_path, const string& curr_image_path, const string& output_image_path){
-        // Read input images
-        Mat prev_image = imread(prev_image_path);
-        Mat curr_image = imread(curr_image_path);
-        if (prev_image.empty() || curr_image.empty()){
-            cerr << "Error: Could not open or find the images!" << endl;
-            return false;
+// Brightness gain that maps each square of the current signature onto the reference: the
+// median of the per-square ratios over its 3x3 neighbourhood, so a lamp or daylight change is
+// compensated while the one or two squares a move touches cannot drag the estimate along
+static void estimate_square_gains(move_detector_context& ctx){
+    const int CELLS = VISION_SIGNATURE_CELLS;
+    double ratio[64];
+    for (int sq = 0; sq < 64; sq++){
+        int curr_sum = 0, ref_sum = 0;
+        for (int cy = (sq / 8) * CELLS; cy < (sq / 8 + 1) * CELLS; cy++){
+            const uchar* curr = ctx.signature.ptr<uchar>(cy);
+            const uchar* ref = ctx.ref_signature.ptr<uchar>(cy);
+            for (int cx = (sq % 8) * CELLS; cx < (sq % 8 + 1) * CELLS; cx++){
+                curr_sum += curr[cx];
+                ref_sum += ref[cx];
+            }
         }
-        // Resize images to standard size (400x400)
-        const int TARGET_SIZE = 400;
-        Mat prev_resized, curr_resized;
-        resize(prev_image, prev_resized, Size(TARGET_SIZE, TARGET_SIZE));
-        resize(curr_image, curr_resized, Size(TARGET_SIZE, TARGET_SIZE));
-        // Convert images to grayscale
-        Mat prev_gray, curr_gray;
-        cvtColor(prev_resized, prev_gray, COLOR_BGR2GRAY);
-        cvtColor(curr_resized, curr_gray, COLOR_BGR2GRAY);
-        // Apply Gaussian blur to reduce noise and improve difference detection
-        GaussianBlur(prev_gray, prev_gray, Size(5, 5), 0);
-        GaussianBlur(curr_gray, curr_gray, Size(5, 5), 0);
-        // Compute absolute difference between the two images
-        Mat diff_image;
-        absdiff(prev_gray, curr_gray, diff_image);  
-        // Threshold the difference image to get binary image
-        Mat thresh_image;
-        threshold(diff_image, thresh_image, 25, 255, THRESH_BINARY);
-        // Calculate square differences
-        const int SQUARE_SIZE = TARGET_SIZE / 8;
-        vector<square_info> squares = calculate_square_differences(thresh_image, prev_gray, curr_gray, SQUARE_SIZE);
-        // Sort squares by difference score in descending order
-        sort(squares.begin(), squares.end(), [](const square_info& a, const square_info& b) {
-            return a.diff_score > b.diff_score;
-        });
-        // Take top 2 squares as moved squares
-        if (squares.size() < 2 || squares[0].diff_score < 0.1) {
-            cerr << "Warning: Can not detect move" << endl;
-            return false;
+        ratio[sq] = (ref_sum + CELLS * CELLS) / (double)(curr_sum + CELLS * CELLS);
+    }
+    for (int sq = 0; sq < 64; sq++){
+        double local[9];
+        int n = 0;
+        for (int row = max(0, sq / 8 - 1); row <= min(7, sq / 8 + 1); row++)
+            for (int col = max(0, sq % 8 - 1); col <= min(7, sq % 8 + 1); col++)
+                local[n++] = ratio[row * 8 + col];
+        nth_element(local, local + n / 2, local + n);
+        ctx.gain[sq] = max(0.25, min(4.0, local[n / 2]));
+    }
+}
+
+// A square is dirty when any of its gain-corrected signature cells moved beyond the threshold.
+// On a frame with no dirty square the typical deviation feeds the signature noise level.
+static void mark_dirty_squares(move_detector_context& ctx){
+    const int CELLS = VISION_SIGNATURE_CELLS;
+    const double threshold = max(ctx.signature_threshold, 3 * ctx.noise.signature_level);
+    double level = 0;
+    ctx.dirty_count = 0;
+    for (int sq = 0; sq < 64; sq++){
+        double worst = 0;
+        for (int cy = (sq / 8) * CELLS; cy < (sq / 8 + 1) * CELLS; cy++){
+            const uchar* curr = ctx.signature.ptr<uchar>(cy);
+            const uchar* ref = ctx.ref_signature.ptr<uchar>(cy);
+            for (int cx = (sq % 8) * CELLS; cx < (sq % 8 + 1) * CELLS; cx++)
+                worst = max(worst, fabs(curr[cx] * ctx.gain[sq] - ref[cx]));
         }
-        square_info square1 = squares[0];
-        square_info square2 = squares[1];
-        // Determine which square is the source and which is the destination
-        square_info from_square, to_square;
-        double intensity_diff1 = square1.avg_intensity_curr - square1.avg_intensity_prev;
-        double intensity_diff2 = square2.avg_intensity_curr - square2.avg_intensity_prev;
-        // Phương pháp 1: Ưu tiên xét thay đổi độ sáng
-        // FROM thường sáng lên (quân rời đi), TO thường tối đi (quân đến)  
-        bool method1_square1_is_from = intensity_diff1 > intensity_diff2;
-        // Phương pháp 2: Xét độ sáng tuyệt đối trong ảnh current
-        // FROM (ô trống) thường sáng hơn TO (có quân cờ)
-        bool method2_square1_is_from = square1.avg_intensity_curr > square1.avg_intensity_prev;
-        // Phương pháp 3: Xét tổng độ sáng 2 ảnh
-        // FROM (thường là ô trống ở cả 2 ảnh) có tổng độ sáng cao hơn
-        double square1_total_intensity = square1.avg_intensity_prev + square1.avg_intensity_curr;
-        double square2_total_intensity = square2.avg_intensity_prev + square1.avg_intensity_curr;
-        bool method3_square1_is_from = square1_total_intensity > square2_total_intensity;
-        // Voting: lấy kết quả được 2/3 phương pháp đồng ý
-        int votes_for_square1_as_FROM = (method1_square1_is_from ? 1 : 0) + (method2_square1_is_from ? 1 : 0) + (method3_square1_is_from ? 1 : 0);
-        if (votes_for_square1_as_FROM >= 2) {
-            from_square = square1;
-            to_square = square2;
+        ctx.dirty[sq] = worst > threshold;
+        if (ctx.dirty[sq]) ctx.dirty_count++;
+        level += worst;
+    }
+    if (ctx.dirty_count == 0) ctx.noise.signature_level += 0.05 * (level / 64 - ctx.noise.signature_level);
+}
+
+// Per-pixel change threshold of a square: well above its idle noise, or the historical 25
+// until the square has been sampled
+static int square_threshold(const move_detector_context& ctx, int sq){
+    if (ctx.noise.samples[sq] == 0) return 25;
+    double adaptive = ctx.noise.pixel_mean[sq] + 4 * sqrt(ctx.noise.pixel_var[sq]);
+    return (int)max(10.0, min(60.0, adaptive));
+}
+
+static double change_cutoff(const move_detector_context& ctx){
+    return ctx.min_diff_score + 3 * ctx.noise.change_fraction;
+}
+
+// A darker pixel is shadow when it kept its chromaticity and lost at most about half its
+// brightness; a dark piece on a light square is far darker than any shadow on our rig
+static bool is_shadow(const uchar* ref, const uchar* curr, double gain){
+    int ref_sum = ref[0] + ref[1] + ref[2];
+    int curr_sum = curr[0] + curr[1] + curr[2];
+    if (ref_sum < 60 || curr_sum < 30) return false;
+    double ratio = curr_sum * gain / ref_sum;
+    if (ratio < 0.45 || ratio >= 1.0) return false;
+    int chroma = abs(ref[0] * curr_sum - curr[0] * ref_sum) + abs(ref[1] * curr_sum - curr[1] * ref_sum) + abs(ref[2] * curr_sum - curr[2] * ref_sum);
+    return chroma <= 0.08 * ref_sum * curr_sum;
+}
+
+struct square_diff_stats {
+    double sum;
+    double sum_sq;
+    int changed;
+};
+
+// Gain-corrected difference of one square against the reference. With a mask it writes the
+// change mask too, otherwise it only collects statistics.
+static void difference_square(move_detector_context& ctx, const Mat& curr_board, int sq, bool write_mask, square_diff_stats& stats){
+    const Rect roi = square_rect(sq);
+    const int gain = (int)(ctx.gain[sq] * 256 + 0.5);
+    const int threshold = square_threshold(ctx, sq);
+    stats = square_diff_stats{0, 0, 0};
+    for (int y = roi.y; y < roi.y + roi.height; y++){
+        const uchar* ref = ctx.prev_gray.ptr<uchar>(y);
+        const uchar* curr = ctx.curr_gray.ptr<uchar>(y);
+        const uchar* ref_bgr = ctx.ref_board.ptr<uchar>(y);
+        const uchar* curr_bgr = curr_board.ptr<uchar>(y);
+        uchar* diff = ctx.diff_image.ptr<uchar>(y);
+        uchar* mask = ctx.thresh_image.ptr<uchar>(y);
+        for (int x = roi.x; x < roi.x + roi.width; x++){
+            int corrected = (curr[x] * gain + 128) >> 8;
+            int d = min(255, abs(corrected - ref[x]));
+            bool changed = d > threshold;
+            if (changed && corrected < ref[x] && is_shadow(ref_bgr + 3 * x, curr_bgr + 3 * x, ctx.gain[sq])) changed = false;
+            stats.sum += d;
+            stats.sum_sq += d * d;
+            if (changed) stats.changed++;
+            if (write_mask){
+                diff[x] = (uchar)d;
+                mask[x] = changed ? 255 : 0;
+            }
+        }
+    }
+}
+
+// On a frame where nothing changed, difference one square at full resolution and fold it into
+// the noise statistics; a full sweep of the board takes 64 idle frames
+static void sample_idle_noise(move_detector_context& ctx, const Mat& curr_board){
+    const double ALPHA = 0.05;
+    const double area = VISION_SQUARE_PIXELS * VISION_SQUARE_PIXELS;
+    int sq = ctx.noise.next_square;
+    ctx.noise.next_square = (sq + 1) % 64;
+    prepare_gray(ctx, curr_board, ctx.curr_gray, square_rect(sq));
+    square_diff_stats stats;
+    difference_square(ctx, curr_board, sq, false, stats);
+    double mean = stats.sum / area;
+    double var = max(0.0, stats.sum_sq / area - mean * mean);
+    // Plain average for the first samples, then an exponential one that tracks slow drift
+    int n = ++ctx.noise.samples[sq];
+    double weight = max(ALPHA, 1.0 / n);
+    ctx.noise.pixel_mean[sq] += weight * (mean - ctx.noise.pixel_mean[sq]);
+    ctx.noise.pixel_var[sq] += weight * (var - ctx.noise.pixel_var[sq]);
+    ctx.noise.change_fraction += ALPHA * (stats.changed / area - ctx.noise.change_fraction);
+}
+
+static bool check_board_size(const Mat& board){
+    if (board.size() != Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS) || board.type() != CV_8UC3){
+        cerr << "Error: Board images must be " << VISION_BOARD_PIXELS << "x" << VISION_BOARD_PIXELS << " BGR" << endl;
+        return false;
+    }
+    return true;
+}
+
+void init_move_detector(move_detector_context& ctx){
+    const Size board_size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS);
+    const int grid = 8 * VISION_SIGNATURE_CELLS;
+    ctx.gray.create(board_size, CV_8UC1);
+    ctx.blur_tmp.create(board_size, CV_16UC1);
+    ctx.prev_gray.create(board_size, CV_8UC1);
+    ctx.curr_gray.create(board_size, CV_8UC1);
+    ctx.diff_image.create(board_size, CV_8UC1);
+    ctx.thresh_image.create(board_size, CV_8UC1);
+    ctx.thresh_image.setTo(Scalar(0));
+    ctx.ref_board.create(board_size, CV_8UC3);
+    ctx.signature.create(grid, grid, CV_8UC1);
+    ctx.ref_signature.create(grid, grid, CV_8UC1);
+    ctx.signature_threshold = 10;
+    ctx.min_diff_score = 0.1;
+    ctx.dirty.fill(false);
+    ctx.mask_set.fill(false);
+    ctx.ref_mean.fill(0);
+    ctx.gain.fill(1.0);
+    ctx.noise.pixel_mean.fill(0);
+    ctx.noise.pixel_var.fill(0);
+    ctx.noise.samples.fill(0);
+    ctx.noise.signature_level = 0;
+    ctx.noise.change_fraction = 0;
+    ctx.noise.next_square = 0;
+    ctx.pieces = NULL;
+    ctx.occupancy = NULL;
+    memset(&ctx.curr_occupancy, 0, sizeof(ctx.curr_occupancy));
+    ctx.dirty_count = 0;
+    ctx.timings = detector_timings{0, 0, 0};
+    ctx.has_reference = false;
+}
+
+bool set_move_detector_reference(move_detector_context& ctx, const Mat& board){
+    if (!check_board_size(board)) return false;
+    prepare_gray(ctx, board, ctx.prev_gray, Rect(0, 0, VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+    board.copyTo(ctx.ref_board);
+    compute_board_signature(board, ctx.ref_signature);
+    for (int sq = 0; sq < 64; sq++) ctx.ref_mean[sq] = mean(ctx.prev_gray(square_rect(sq)))[0];
+    ctx.has_reference = true;
+    return true;
+}
+
+// Difference the current board against the reference into ctx.thresh_image, on dirty squares only
+static bool update_change_mask(move_detector_context& ctx, const Mat& curr_board){
+    if (!ctx.has_reference || !check_board_size(curr_board)) return false;
+    int64_t start = getTickCount();
+    compute_board_signature(curr_board, ctx.signature);
+    estimate_square_gains(ctx);
+    mark_dirty_squares(ctx);
+    for (int sq = 0; sq < 64; sq++)
+        if (ctx.dirty[sq]) prepare_gray(ctx, curr_board, ctx.curr_gray, square_rect(sq));
+    int64_t blurred = getTickCount();
+    for (int sq = 0; sq < 64; sq++){
+        if (ctx.dirty[sq]){
+            square_diff_stats stats;
+            difference_square(ctx, curr_board, sq, true, stats);
+            ctx.mask_set[sq] = true;
+        } else if (ctx.mask_set[sq]){
+            // Clear what an earlier frame left so clean squares carry no evidence
+            Mat thresh_roi = ctx.thresh_image(square_rect(sq));
+            thresh_roi.setTo(Scalar(0));
+            ctx.mask_set[sq] = false;
+        }
+    }
+    if (ctx.dirty_count == 0) sample_idle_noise(ctx, curr_board);
+    int64_t done = getTickCount();
+    ctx.timings.preprocess_ms = (blurred - start) * 1000.0 / getTickFrequency();
+    ctx.timings.diff_ms = (done - blurred) * 1000.0 / getTickFrequency();
+    return true;
+}
+
+// Determine which of the two most changed squares is the source and which is the destination
+static void order_from_to(const square_info& square1, const square_info& square2, square_info& from_square, square_info& to_square){
+    double intensity_diff1 = square1.avg_intensity_curr - square1.avg_intensity_prev;
+    double intensity_diff2 = square2.avg_intensity_curr - square2.avg_intensity_prev;
+    // Phương pháp 1: Ưu tiên xét thay đổi độ sáng
+    // FROM thường sáng lên (quân rời đi), TO thường tối đi (quân đến)
+    bool method1_square1_is_from = intensity_diff1 > intensity_diff2;
+    // Phương pháp 2: Xét độ sáng tuyệt đối trong ảnh current
+    // FROM (ô trống) thường sáng hơn TO (có quân cờ)
+    bool method2_square1_is_from = square1.avg_intensity_curr > square1.avg_intensity_prev;
+    // Phương pháp 3: Xét tổng độ sáng 2 ảnh
+    // FROM (thường là ô trống ở cả 2 ảnh) có tổng độ sáng cao hơn
+    double square1_total_intensity = square1.avg_intensity_prev + square1.avg_intensity_curr;
+    double square2_total_intensity = square2.avg_intensity_prev + square1.avg_intensity_curr;
+    bool method3_square1_is_from = square1_total_intensity > square2_total_intensity;
+    // Voting: lấy kết quả được 2/3 phương pháp đồng ý
+    int votes_for_square1_as_FROM = (method1_square1_is_from ? 1 : 0) + (method2_square1_is_from ? 1 : 0) + (method3_square1_is_from ? 1 : 0);
+    if (votes_for_square1_as_FROM >= 2) {
+        from_square = square1;
+        to_square = square2;
+    } else {
+        from_square = square2;
+        to_square = square1;
+    }
+}
+
+bool detect_move_squares(move_detector_context& ctx, const Mat& curr_board, square_info& from_square, square_info& to_square){
+    if (!update_change_mask(ctx, curr_board)) return false;
+    ctx.timings.decide_ms = 0;
+    if (ctx.dirty_count == 0) return false;
+    int64_t start = getTickCount();
+    const int area = VISION_SQUARE_PIXELS * VISION_SQUARE_PIXELS;
+    for (int sq = 0; sq < 64; sq++){
+        square_info& info = ctx.squares[sq];
+        info.row = sq / 8;
+        info.col = sq % 8;
+        info.avg_intensity_prev = ctx.ref_mean[sq];
+        if (ctx.dirty[sq]){
+            Rect roi = square_rect(sq);
+            info.diff_score = (double)countNonZero(ctx.thresh_image(roi)) / area;
+            info.avg_intensity_curr = mean(ctx.curr_gray(roi))[0] * ctx.gain[sq];
         } else {
-            from_square = square2;
-            to_square = square1;
-        }  
-        // Draw result on current image
-        Mat output_image = curr_resized.clone();
-        // Calculate center points of the squares
-        Point from_center(from_square.col * SQUARE_SIZE + SQUARE_SIZE / 2, from_square.row * SQUARE_SIZE + SQUARE_SIZE / 2);
-        Point to_center(to_square.col * SQUARE_SIZE + SQUARE_SIZE / 2, to_square.row * SQUARE_SIZE + SQUARE_SIZE / 2);
-        // Assign 1 for FROM square and 2 for TO square
-        putText(output_image, "1", from_center, FONT_HERSHEY_SIMPLEX, 1.0, Scalar(0, 0, 255), 4);
-        putText(output_image, "2", to_center, FONT_HERSHEY_SIMPLEX, 1.0, Scalar(0, 255, 0), 4); 
-        // Draw rectangles around the squares
-        rectangle(output_image, Rect(from_square.col * SQUARE_SIZE, from_square.row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE), Scalar(0, 0, 255), 2);
-        rectangle(output_image, Rect(to_square.col * SQUARE_SIZE, to_square.row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE), Scalar(0, 255, 0), 2);
-        // Save output image
-        bool success = imwrite(output_image_path, output_image);
-        if (success) {
-            cout << "Phát hiện nước đi thành công!" << endl;
-            cout << "FROM: Hàng " << from_square.row << ", Cột " << from_square.col << endl;
-            cout << "TO: Hàng " << to_square.row << ", Cột " << to_square.col << endl;
-            cout << "Ảnh kết quả đã lưu tại: " << output_image_path << endl;
+            // A clean square matches the reference at signature resolution
+            info.diff_score = 0;
+            info.avg_intensity_curr = ctx.ref_mean[sq];
+        }
+    }
+    int64_t scored = getTickCount();
+    // Only the two most changed squares matter, so select them instead of sorting all 64
+    partial_sort(ctx.squares.begin(), ctx.squares.begin() + 2, ctx.squares.end(), [](const square_info& a, const square_info& b) {
+        return a.diff_score > b.diff_score;
+    });
+    bool found = ctx.squares[0].diff_score >= change_cutoff(ctx);
+    if (found) order_from_to(ctx.squares[0], ctx.squares[1], from_square, to_square);
+    ctx.timings.diff_ms += (scored - start) * 1000.0 / getTickFrequency();
+    ctx.timings.decide_ms = (getTickCount() - scored) * 1000.0 / getTickFrequency();
+    return found;
+}
+
+bool detect_chess_move(const string& prev_image_path, const string& curr_image_path, const string& output_image_path){
+    // Read input images
+    Mat prev_image = imread(prev_image_path);
+    Mat curr_image = imread(curr_image_path);
+    if (prev_image.empty() || curr_image.empty()){
+        cerr << "Error: Could not open or find the images!" << endl;
+        return false;
+    }
+    // Resize images to standard size (400x400)
+    const int TARGET_SIZE = VISION_BOARD_PIXELS;
+    Mat prev_resized, curr_resized;
+    resize(prev_image, prev_resized, Size(TARGET_SIZE, TARGET_SIZE));
+    resize(curr_image, curr_resized, Size(TARGET_SIZE, TARGET_SIZE));
+    return detect_chess_move(prev_resized, curr_resized, output_image_path);
+}
+
+bool detect_chess_move(const board_remap& remap, const Mat& prev_frame, const Mat& curr_frame, const string& output_image_path){
+    // Rectified boards are reused between calls so steady-state frames do not reallocate
+    static thread_local Mat prev_board, curr_board;
+    if (remap.board_pixels != VISION_BOARD_PIXELS){
+        cerr << "Error: Remap table must produce " << VISION_BOARD_PIXELS << "x" << VISION_BOARD_PIXELS << " boards" << endl;
+        return false;
+    }
+    if (!warp_board_frame(remap, prev_frame, prev_board) || !warp_board_frame(remap, curr_frame, curr_board)){
+        cerr << "Error: Could not rectify camera frames!" << endl;
+        return false;
+    }
+    return detect_chess_move(prev_board, curr_board, output_image_path);
+}
+
+// One detector per thread for the stateless convenience entry points
+static move_detector_context& thread_detector(){
+    static thread_local move_detector_context ctx;
+    static thread_local bool initialised = false;
+    if (!initialised){
+        init_move_detector(ctx);
+        initialised = true;
+    }
+    return ctx;
+}
+
+bool detect_chess_move(const Mat& prev_resized, const Mat& curr_resized, const string& output_image_path){
+    vision_detection_t result = detect(NULL, prev_resized, curr_resized);
+    if (!result.found || output_image_path.empty()) return result.found;
+    // One-shot callers expect the image on disk when this returns, so annotate inline
+    Mat output_image = curr_resized.clone();
+    draw_move_annotation(output_image, result.from_row, result.from_col, result.to_row, result.to_col);
+    return imwrite(output_image_path, output_image);
+}
+
+// Squares a move changes: from/to, plus the rook for castling or the captured pawn for en passant
+static int move_touched_squares(const move_t& move, int* squares){
+    int n = 0;
+    squares[n++] = move.from_row * BOARD_SIZE + move.from_col;
+    squares[n++] = move.to_row * BOARD_SIZE + move.to_col;
+    if (move.is_castle){
+        bool kingside = move.to_col == 6;
+        squares[n++] = move.from_row * BOARD_SIZE + (kingside ? 7 : 0);
+        squares[n++] = move.from_row * BOARD_SIZE + (kingside ? 5 : 3);
+    }
+    if (move.is_en_passant)
+        squares[n++] = move.from_row * BOARD_SIZE + move.to_col;
+    return n;
+}
+
+// Occupancy a touched square should show once the move is on the board
+static unsigned char expected_occupancy(const move_t& move, int square){
+    int to = move.to_row * BOARD_SIZE + move.to_col;
+    int rook_to = move.from_row * BOARD_SIZE + (move.to_col == 6 ? 5 : 3);
+    if (square == to || (move.is_castle && square == rook_to))
+        return move.moved_piece.color == WHITE ? SQUARE_WHITE_PIECE : SQUARE_BLACK_PIECE;
+    return SQUARE_EMPTY;
+}
+
+static bool same_squares(const move_t& a, const move_t& b){
+    return a.from_row == b.from_row && a.from_col == b.from_col && a.to_row == b.to_row && a.to_col == b.to_col;
+}
+
+bool decode_legal_move(const chess_state_t* chess, const Mat& change_mask, const board_occupancy_t* curr_occupancy, legal_move_match& match){
+    if (!chess || change_mask.empty()) return false;
+    const int SQUARE_SIZE = change_mask.cols / 8;
+    move_t moves[MAX_LEGAL_MOVES];
+    int n_moves = generate_legal_moves(chess, moves, MAX_LEGAL_MOVES);
+    if (n_moves == 0) return false;
+    // Evidence is computed lazily, only for squares some legal move touches
+    double evidence[64];
+    bool candidate[64] = {false};
+    for (int i = 0; i < 64; i++) evidence[i] = -1;
+    int touched[MAX_LEGAL_MOVES][5];
+    int n_touched[MAX_LEGAL_MOVES];
+    for (int m = 0; m < n_moves; m++){
+        n_touched[m] = move_touched_squares(moves[m], touched[m]);
+        for (int t = 0; t < n_touched[m]; t++){
+            int sq = touched[m][t];
+            if (evidence[sq] >= 0) continue;
+            Rect roi((sq % 8) * SQUARE_SIZE, (sq / 8) * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE);
+            evidence[sq] = (double)countNonZero(change_mask(roi)) / (SQUARE_SIZE * SQUARE_SIZE);
+            candidate[sq] = true;
         }
-        
-        return success;
-    }
\ No newline at end of file
+    }
+    double candidate_total = 0;
+    for (int i = 0; i < 64; i++)
+        if (candidate[i]) candidate_total += evidence[i];
+    // A move explains the change on its own squares; change elsewhere counts against it
+    int best = -1, second = -1;
+    double best_score = -1e9, second_score = -1e9;
+    for (int m = 0; m < n_moves; m++){
+        double own = 0, weakest = 1;
+        for (int t = 0; t < n_touched[m]; t++){
+            own += evidence[touched[m][t]];
+            weakest = min(weakest, evidence[touched[m][t]]);
+        }
+        double score = own - (candidate_total - own);
+        // Every square of a real move must have changed at least a little
+        if (weakest < 0.05) score -= 1.0;
+        if (curr_occupancy){
+            int agree = 0;
+            for (int t = 0; t < n_touched[m]; t++)
+                if (curr_occupancy->squares[touched[m][t]] == expected_occupancy(moves[m], touched[m][t])) agree++;
+            score += 0.5 * agree / n_touched[m];
+        }
+        // Promotion variants share squares and must not count as the runner-up
+        if (score > best_score){
+            if (best < 0 || !same_squares(moves[best], moves[m])){
+                second = best;
+                second_score = best_score;
+            }
+            best = m;
+            best_score = score;
+        } else if (score > second_score && !same_squares(moves[best], moves[m])){
+            second = m;
+            second_score = score;
+        }
+    }
+    if (best < 0 || best_score < 0.1) return false;
+    match.move = moves[best];
+    match.score = best_score;
+    double own = 0;
+    for (int t = 0; t < n_touched[best]; t++) own += evidence[touched[best][t]];
+    match.evidence = own / n_touched[best];
+    match.confidence = (second < 0) ? 1.0 : max(0.0, min(1.0, (best_score - second_score) / best_score));
+    return true;
+}
+
+bool detect_legal_move(move_detector_context& ctx, const chess_state_t* chess, const Mat& curr_board, legal_move_match& match){
+    if (!update_change_mask(ctx, curr_board)) return false;
+    ctx.timings.decide_ms = 0;
+    // Nothing moved since the reference: skip move generation entirely
+    if (ctx.dirty_count == 0) return false;
+    int64_t start = getTickCount();
+    // Occupancy of the frame backs the change mask: squares a move empties must look empty and
+    // the squares it fills must show the mover's colour
+    const board_occupancy_t* occupancy = NULL;
+    if (ctx.occupancy && ctx.occupancy->calibrated && classify_board_occupancy(*ctx.occupancy, curr_board, &ctx.curr_occupancy))
+        occupancy = &ctx.curr_occupancy;
+    bool found = decode_legal_move(chess, ctx.thresh_image, occupancy, match);
+    // A noisy rig raises the bar above decode_legal_move's own minimum. The cutoff is a changed
+    // fraction of one square, so it is held against the move's mean per touched square rather
+    // than its score, which sums over two to four squares and subtracts change elsewhere.
+    if (found && match.evidence < change_cutoff(ctx)) found = false;
+    // Occupancy on its own names a move when exactly the expected squares emptied and filled;
+    // disagreeing with the change mask means one of them is wrong
+    if (found && occupancy){
+        board_occupancy_t before;
+        chess_state_to_occupancy(chess, &before);
+        char uci_move[6];
+        if (occupancy_to_move(&before, occupancy, chess->turn, uci_move) && strncmp(uci_move, match.move.notation, 4) != 0)
+            match.confidence *= 0.5;
+    }
+    // Identity check on the destination only, so it costs one square per detected move
+    if (found && ctx.pieces && ctx.pieces->calibrated){
+        double margin;
+        if (!verify_move_identity(*ctx.pieces, curr_board, &match.move, &margin) && !match.move.is_promotion)
+            match.confidence *= 0.5;
+    }
+    ctx.timings.decide_ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    return found;
+}
+
+bool detect_chess_move(const chess_state_t* chess, const Mat& prev_board, const Mat& curr_board, legal_move_match& match){
+    move_detector_context& ctx = thread_detector();
+    if (!set_move_detector_reference(ctx, prev_board)) return false;
+    return detect_legal_move(ctx, chess, curr_board, match);
+}
+static void set_detection_squares(vision_detection_t& result, int from_row, int from_col, int to_row, int to_col){
+    result.found = true;
+    result.from_row = from_row;
+    result.from_col = from_col;
+    result.to_row = to_row;
+    result.to_col = to_col;
+    snprintf(result.uci, sizeof(result.uci), "%c%c%c%c", 'a' + from_col, '8' - from_row, 'a' + to_col, '8' - to_row);
+}
+
+vision_detection_t detect(move_detector_context& ctx, const chess_state_t* chess, const Mat& curr_board, annotation_writer* annotate, const string& annotate_path){
+    vision_detection_t result;
+    memset(&result, 0, sizeof(result));
+    int64_t start = getTickCount();
+    ctx.timings = detector_timings{0, 0, 0};
+    if (chess){
+        legal_move_match match;
+        if (detect_legal_move(ctx, chess, curr_board, match)){
+            const move_t& move = match.move;
+            set_detection_squares(result, move.from_row, move.from_col, move.to_row, move.to_col);
+            // Keeps the promotion suffix
+            snprintf(result.uci, sizeof(result.uci), "%s", move.notation);
+            result.confidence = match.confidence;
+        }
+    } else {
+        square_info from_square, to_square;
+        if (detect_move_squares(ctx, curr_board, from_square, to_square)){
+            set_detection_squares(result, from_square.row, from_square.col, to_square.row, to_square.col);
+            // How far the chosen pair stands out from the next most changed square
+            double third = 0;
+            for (int i = 2; i < 64; i++) third = max(third, ctx.squares[i].diff_score);
+            double second = ctx.squares[1].diff_score;
+            result.confidence = second > 0 ? max(0.0, min(1.0, (second - third) / second)) : 0.0;
+        }
+    }
+    result.timings.preprocess_ms = ctx.timings.preprocess_ms;
+    result.timings.diff_ms = ctx.timings.diff_ms;
+    result.timings.decide_ms = ctx.timings.decide_ms;
+    result.timings.total_ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    if (annotate && result.found) queue_annotation(*annotate, curr_board, result, annotate_path);
+    return result;
+}
+
+vision_detection_t detect(const chess_state_t* chess, const Mat& prev_board, const Mat& curr_board){
+    move_detector_context& ctx = thread_detector();
+    if (!set_move_detector_reference(ctx, prev_board)){
+        vision_detection_t result;
+        memset(&result, 0, sizeof(result));
+        return result;
+    }
+    return detect(ctx, chess, curr_board);
+}
@@ -0,0 +1,52 @@
+#include "vision/move_vote.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+void init_move_vote(move_vote& vote, const move_vote_config* config){
+    if (config){
+        vote.config = *config;
+    } else {
+        vote.config.window = 5;
+        vote.config.required = 3;
+    }
+    vote.config.window = max(1, min(MOVE_VOTE_MAX_WINDOW, vote.config.window));
+    vote.config.required = max(1, min(vote.config.window, vote.config.required));
+    reset_move_vote(vote);
+}
+
+void reset_move_vote(move_vote& vote){
+    vote.count = 0;
+    vote.next = 0;
+    vote.first_ticks = 0;
+}
+
+bool add_move_vote(move_vote& vote, bool found, const legal_move_match& match, int64_t ticks, move_vote_result& result){
+    if (vote.count == 0) vote.first_ticks = ticks;
+    move_vote_entry& entry = vote.entries[vote.next];
+    entry.found = found;
+    if (found) entry.match = match;
+    vote.next = (vote.next + 1) % vote.config.window;
+    if (vote.count < vote.config.window) vote.count++;
+    // Earlier results never reached K on their own, so only the newest move can commit now
+    if (!found) return false;
+    int votes = 0;
+    double confidence_sum = 0;
+    for (int i = 0; i < vote.count; i++){
+        const move_vote_entry& other = vote.entries[i];
+        if (other.found && strcmp(other.match.move.notation, match.move.notation) == 0){
+            votes++;
+            confidence_sum += other.match.confidence;
+        }
+    }
+    if (votes < vote.config.required) return false;
+    result.match = match;
+    result.votes = votes;
+    result.window = vote.count;
+    result.confidence = (double)votes / vote.count * (confidence_sum / votes);
+    result.time_to_commit_ms = (ticks - vote.first_ticks) * 1000.0 / getTickFrequency();
+    reset_move_vote(vote);
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "vision/multi_board_vision.h"
+#include "common/constants.h"
+#include "game/move_validation.h"
+#include <atomic>
+
+using namespace cv;
+using namespace std;
+
+bool init_multi_board_vision(multi_board_vision& vision, const vector<board_calibration>& boards, Size frame_size,
+                             const chess_state_t* chess, const frame_gate_config* gate, const move_vote_config* vote,
+                             multi_board_callback on_move){
+    if (!chess || boards.empty()) return false;
+    vision.boards.clear();
+    vision.on_move = on_move;
+    vision.sequence = 0;
+    for (const board_calibration& calib : boards){
+        unique_ptr<board_view> view(new board_view);
+        if (!build_board_remap(calib, frame_size, VISION_BOARD_PIXELS, view->remap)) return false;
+        init_frame_gate(view->gate, gate);
+        init_move_detector(view->detector);
+        init_move_vote(view->vote, vote);
+        view->voting = false;
+        view->reference_stale = true;
+        view->chess = *chess;
+        view->has_pending_chess = false;
+        view->detected = 0;
+        vision.boards.push_back(std::move(view));
+    }
+    return true;
+}
+
+// The same gate -> vote -> commit sequence as the single-board pipeline's detect stage
+static bool process_board(multi_board_vision& vision, int index, const Mat& frame, int64_t ticks, int64_t sequence){
+    board_view& view = *vision.boards[index];
+    {
+        lock_guard<mutex> lock(view.chess_mutex);
+        if (view.has_pending_chess){
+            view.chess = view.pending_chess;
+            view.has_pending_chess = false;
+            view.reference_stale = true;
+        }
+    }
+    if (!warp_board_frame(view.remap, frame, view.board)) return false;
+    frame_gate_state state = update_frame_gate(view.gate, view.board);
+    bool settled = state == GATE_STABLE || state == GATE_IDLE;
+    if (settled && view.reference_stale){
+        set_move_detector_reference(view.detector, view.board);
+        set_frame_gate_reference(view.gate);
+        view.reference_stale = false;
+        view.voting = false;
+    } else if (state == GATE_STABLE){
+        reset_move_vote(view.vote);
+        view.voting = true;
+    } else if (!settled){
+        view.voting = false;
+    }
+    if (!settled || !view.voting) return false;
+    legal_move_match match;
+    move_vote_result result;
+    bool found = detect_legal_move(view.detector, &view.chess, view.board, match);
+    if (!add_move_vote(view.vote, found, match, ticks, result)) return false;
+    make_move(&view.chess, result.match.move.notation);
+    set_move_detector_reference(view.detector, view.board);
+    set_frame_gate_reference(view.gate);
+    view.voting = false;
+    view.detected++;
+    if (vision.on_move) vision.on_move(index, result, sequence);
+    return true;
+}
+
+int process_multi_board_frame(multi_board_vision& vision, const Mat& frame){
+    int64_t ticks = getTickCount();
+    int64_t sequence = vision.sequence++;
+    atomic<int> committed(0);
+    // Boards share nothing but the input frame, so each one is an independent task
+    parallel_for_(Range(0, (int)vision.boards.size()), [&](const Range& range){
+        for (int i = range.start; i < range.end; i++)
+            if (process_board(vision, i, frame, ticks, sequence)) committed++;
+    });
+    return committed.load();
+}
+
+void set_multi_board_position(multi_board_vision& vision, int board, const chess_state_t* chess){
+    if (!chess || board < 0 || board >= (int)vision.boards.size()) return;
+    board_view& view = *vision.boards[board];
+    lock_guard<mutex> lock(view.chess_mutex);
+    view.pending_chess = *chess;
+    view.has_pending_chess = true;
+}
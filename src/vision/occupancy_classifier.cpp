@@ -0,0 +1,226 @@
+#include "vision/occupancy_classifier.h"
+#include "common/constants.h"
+#include "game/chess_state.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+// Light squares are those where row + col is even (a8 is light)
+static int square_shade(int row, int col){
+    return (row + col) % 2;
+}
+
+// Inner part of a square, away from the grid lines and neighbouring pieces
+static Rect square_roi(int row, int col, int inset){
+    const int SQUARE_SIZE = VISION_SQUARE_PIXELS;
+    return Rect(col * SQUARE_SIZE + inset, row * SQUARE_SIZE + inset, SQUARE_SIZE - 2 * inset, SQUARE_SIZE - 2 * inset);
+}
+
+// Grayscale and edge-energy images shared by calibration and classification
+static bool prepare_board(occupancy_classifier& classifier, const Mat& board){
+    if (board.empty() || board.type() != CV_8UC3 || board.size() != Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS)){
+        cerr << "Error: Occupancy classifier expects a " << VISION_BOARD_PIXELS << "x" << VISION_BOARD_PIXELS << " BGR board" << endl;
+        return false;
+    }
+    cvtColor(board, classifier.gray, COLOR_BGR2GRAY);
+    // Separate CV_16S and CV_8U outputs: converting in place would change the type of one buffer
+    // and force both to be reallocated on every frame
+    Laplacian(classifier.gray, classifier.laplacian, CV_16S, 3);
+    convertScaleAbs(classifier.laplacian, classifier.edges);
+    return true;
+}
+
+// Distance of a square from the empty-square model of its shade
+static double occupancy_score(const occupancy_classifier& classifier, const Mat& board, int row, int col){
+    int shade = square_shade(row, col);
+    Rect roi = square_roi(row, col, VISION_SQUARE_PIXELS / 5);
+    Scalar bgr = mean(board(roi));
+    double edge = mean(classifier.edges(roi))[0];
+    double db = bgr[0] - classifier.empty_bgr[shade][0];
+    double dg = bgr[1] - classifier.empty_bgr[shade][1];
+    double dr = bgr[2] - classifier.empty_bgr[shade][2];
+    double colour_dist = sqrt(db * db + dg * dg + dr * dr) / classifier.colour_scale[shade];
+    double edge_dist = (edge - classifier.empty_edge[shade]) / classifier.edge_scale[shade];
+    return colour_dist + max(0.0, edge_dist);
+}
+
+// Brightness of the middle of the square, where the piece top sits in a top-down view
+static double centre_brightness(const occupancy_classifier& classifier, int row, int col){
+    return mean(classifier.gray(square_roi(row, col, VISION_SQUARE_PIXELS / 3)))[0];
+}
+
+bool calibrate_occupancy_classifier(occupancy_classifier& classifier, const Mat& start_board){
+    classifier.calibrated = false;
+    if (!prepare_board(classifier, start_board)) return false;
+    const int inset = VISION_SQUARE_PIXELS / 5;
+    // Ranks 6 to 3 are empty in the starting position
+    Vec3d bgr_sum[2] = {Vec3d(), Vec3d()};
+    double edge_sum[2] = {0, 0};
+    int count[2] = {0, 0};
+    for (int row = 2; row <= 5; row++)
+        for (int col = 0; col < 8; col++){
+            int shade = square_shade(row, col);
+            Rect roi = square_roi(row, col, inset);
+            Scalar bgr = mean(start_board(roi));
+            for (int c = 0; c < 3; c++) bgr_sum[shade][c] += bgr[c];
+            edge_sum[shade] += mean(classifier.edges(roi))[0];
+            count[shade]++;
+        }
+    for (int shade = 0; shade < 2; shade++){
+        for (int c = 0; c < 3; c++) classifier.empty_bgr[shade][c] = bgr_sum[shade][c] / count[shade];
+        classifier.empty_edge[shade] = edge_sum[shade] / count[shade];
+    }
+    // Spread of the empty squares around their mean normalises the distances
+    double colour_var[2] = {0, 0};
+    double edge_var[2] = {0, 0};
+    for (int row = 2; row <= 5; row++)
+        for (int col = 0; col < 8; col++){
+            int shade = square_shade(row, col);
+            Rect roi = square_roi(row, col, inset);
+            Scalar bgr = mean(start_board(roi));
+            for (int c = 0; c < 3; c++){
+                double d = bgr[c] - classifier.empty_bgr[shade][c];
+                colour_var[shade] += d * d;
+            }
+            double e = mean(classifier.edges(roi))[0] - classifier.empty_edge[shade];
+            edge_var[shade] += e * e;
+        }
+    for (int shade = 0; shade < 2; shade++){
+        // Floors keep a perfectly uniform board from producing huge scores on sensor noise
+        classifier.colour_scale[shade] = max(4.0, sqrt(colour_var[shade] / count[shade]));
+        classifier.edge_scale[shade] = max(2.0, sqrt(edge_var[shade] / count[shade]));
+    }
+    // Place the occupancy threshold between the empty and occupied squares we know about
+    double max_empty = 0;
+    for (int row = 2; row <= 5; row++)
+        for (int col = 0; col < 8; col++)
+            max_empty = max(max_empty, occupancy_score(classifier, start_board, row, col));
+    double min_piece = 1e9;
+    double white_sum[2] = {0, 0}, black_sum[2] = {0, 0};
+    int white_count[2] = {0, 0}, black_count[2] = {0, 0};
+    const int piece_rows[4] = {0, 1, 6, 7};
+    for (int i = 0; i < 4; i++){
+        int row = piece_rows[i];
+        for (int col = 0; col < 8; col++){
+            int shade = square_shade(row, col);
+            min_piece = min(min_piece, occupancy_score(classifier, start_board, row, col));
+            double brightness = centre_brightness(classifier, row, col);
+            if (row <= 1){
+                black_sum[shade] += brightness;
+                black_count[shade]++;
+            } else {
+                white_sum[shade] += brightness;
+                white_count[shade]++;
+            }
+        }
+    }
+    if (min_piece > max_empty){
+        classifier.occupied_threshold = (min_piece + max_empty) / 2;
+    } else {
+        cerr << "Warning: Empty and occupied squares overlap, occupancy may be unreliable" << endl;
+        classifier.occupied_threshold = max_empty + 1.0;
+    }
+    for (int shade = 0; shade < 2; shade++){
+        double white_mean = white_sum[shade] / white_count[shade];
+        double black_mean = black_sum[shade] / black_count[shade];
+        if (white_mean <= black_mean)
+            cerr << "Warning: White pieces are not brighter than black pieces on " << (shade ? "dark" : "light") << " squares" << endl;
+        classifier.piece_split[shade] = (white_mean + black_mean) / 2;
+    }
+    classifier.calibrated = true;
+    return true;
+}
+
+bool classify_board_occupancy(occupancy_classifier& classifier, const Mat& board, board_occupancy_t* occupancy){
+    if (!occupancy || !classifier.calibrated) return false;
+    if (!prepare_board(classifier, board)) return false;
+    for (int row = 0; row < 8; row++)
+        for (int col = 0; col < 8; col++){
+            unsigned char state = SQUARE_EMPTY;
+            if (occupancy_score(classifier, board, row, col) > classifier.occupied_threshold){
+                bool white = centre_brightness(classifier, row, col) > classifier.piece_split[square_shade(row, col)];
+                state = white ? SQUARE_WHITE_PIECE : SQUARE_BLACK_PIECE;
+            }
+            occupancy->squares[row * BOARD_SIZE + col] = state;
+        }
+    return true;
+}
+
+void chess_state_to_occupancy(const chess_state_t* chess, board_occupancy_t* occupancy){
+    if (!chess || !occupancy) return;
+    for (int row = 0; row < BOARD_SIZE; row++)
+        for (int col = 0; col < BOARD_SIZE; col++){
+            piece_t p = chess->board[row][col];
+            unsigned char state = SQUARE_EMPTY;
+            if (p.type != EMPTY) state = (p.color == WHITE) ? SQUARE_WHITE_PIECE : SQUARE_BLACK_PIECE;
+            occupancy->squares[row * BOARD_SIZE + col] = state;
+        }
+}
+
+int compare_board_occupancy(const board_occupancy_t* before, const board_occupancy_t* after, int* changed, int max_changed){
+    if (!before || !after) return 0;
+    int count = 0;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++){
+        if (before->squares[i] == after->squares[i]) continue;
+        if (changed && count < max_changed) changed[count] = i;
+        count++;
+    }
+    return count;
+}
+
+bool occupancy_to_move(const board_occupancy_t* before, const board_occupancy_t* after, color_t mover, char* uci_move){
+    if (!before || !after || !uci_move) return false;
+    unsigned char own = (mover == WHITE) ? SQUARE_WHITE_PIECE : SQUARE_BLACK_PIECE;
+    unsigned char opponent = (mover == WHITE) ? SQUARE_BLACK_PIECE : SQUARE_WHITE_PIECE;
+    int vacated[2], arrived[2], removed[1];
+    int n_vacated = 0, n_arrived = 0, n_removed = 0;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++){
+        unsigned char b = before->squares[i];
+        unsigned char a = after->squares[i];
+        if (a == b) continue;
+        if (b == own && a == SQUARE_EMPTY){
+            if (n_vacated == 2) return false;
+            vacated[n_vacated++] = i;
+        } else if (a == own){
+            if (n_arrived == 2) return false;
+            arrived[n_arrived++] = i;
+        } else if (b == opponent && a == SQUARE_EMPTY){
+            if (n_removed == 1) return false;
+            removed[n_removed++] = i;
+        } else {
+            // The opponent cannot gain a square during our move
+            return false;
+        }
+    }
+    int from = -1, to = -1;
+    if (n_vacated == 1 && n_arrived == 1){
+        from = vacated[0];
+        to = arrived[0];
+        // En passant: the captured pawn sits beside the from-square, on the to-square's file
+        if (n_removed == 1 && removed[0] != (from / BOARD_SIZE) * BOARD_SIZE + to % BOARD_SIZE) return false;
+    } else if (n_vacated == 2 && n_arrived == 2 && n_removed == 0){
+        // Castling: king and rook leave their corners on the back rank
+        int row = vacated[0] / BOARD_SIZE;
+        if (vacated[1] / BOARD_SIZE != row || arrived[0] / BOARD_SIZE != row || arrived[1] / BOARD_SIZE != row) return false;
+        int king = (vacated[0] % BOARD_SIZE == 4) ? vacated[0] : vacated[1];
+        int rook = (king == vacated[0]) ? vacated[1] : vacated[0];
+        if (king % BOARD_SIZE != 4) return false;
+        int rook_col = rook % BOARD_SIZE;
+        int lo = min(arrived[0], arrived[1]) % BOARD_SIZE;
+        int hi = max(arrived[0], arrived[1]) % BOARD_SIZE;
+        from = king;
+        if (rook_col == 7 && lo == 5 && hi == 6) to = row * BOARD_SIZE + 6;
+        else if (rook_col == 0 && lo == 2 && hi == 3) to = row * BOARD_SIZE + 2;
+        else return false;
+    } else {
+        return false;
+    }
+    char from_sq[3], to_sq[3];
+    index_to_square(from / BOARD_SIZE, from % BOARD_SIZE, from_sq);
+    index_to_square(to / BOARD_SIZE, to % BOARD_SIZE, to_sq);
+    snprintf(uci_move, 6, "%s%s", from_sq, to_sq);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "vision/piece_recognizer.h"
+#include "common/constants.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+static const piece_type_t BACK_RANK[8] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+
+// Light squares are those where row + col is even (a8 is light)
+static int square_shade(int row, int col){
+    return (row + col) % 2;
+}
+
+static int colour_index(color_t color){
+    return color == WHITE ? 0 : 1;
+}
+
+// Inner part of a square, away from the grid lines and neighbouring pieces
+static Rect square_roi(int row, int col){
+    const int SQUARE_SIZE = VISION_SQUARE_PIXELS;
+    const int INSET = SQUARE_SIZE / 16;
+    return Rect(col * SQUARE_SIZE + INSET, row * SQUARE_SIZE + INSET, SQUARE_SIZE - 2 * INSET, SQUARE_SIZE - 2 * INSET);
+}
+
+// Scale a block of the feature to zero mean and unit length so correlation ignores contrast
+static void normalise_block(float* v, int n){
+    double sum = 0;
+    for (int i = 0; i < n; i++) sum += v[i];
+    float mean = (float)(sum / n);
+    double norm = 0;
+    for (int i = 0; i < n; i++){
+        v[i] -= mean;
+        norm += v[i] * v[i];
+    }
+    float scale = norm > 1e-9 ? (float)(1.0 / sqrt(norm)) : 0.0f;
+    for (int i = 0; i < n; i++) v[i] *= scale;
+}
+
+// Silhouette (deviation from the empty square of that shade) followed by gradient magnitude,
+// both on a PIECE_FEATURE_CELLS thumbnail of the square. Only this square is converted to gray.
+static void square_feature(piece_recognizer& recognizer, const Mat& board, int row, int col, float* feature){
+    const int N = PIECE_FEATURE_CELLS;
+    Rect roi = square_roi(row, col);
+    Mat gray = recognizer.gray(roi);
+    cvtColor(board(roi), gray, COLOR_BGR2GRAY);
+    resize(gray, recognizer.thumb, Size(N, N), 0, 0, INTER_AREA);
+    const float background = (float)recognizer.empty_gray[square_shade(row, col)];
+    float* silhouette = feature;
+    float* gradient = feature + N * N;
+    for (int y = 0; y < N; y++){
+        const uchar* p = recognizer.thumb.ptr<uchar>(y);
+        const uchar* up = recognizer.thumb.ptr<uchar>(max(0, y - 1));
+        const uchar* down = recognizer.thumb.ptr<uchar>(min(N - 1, y + 1));
+        for (int x = 0; x < N; x++){
+            float gx = (float)p[min(N - 1, x + 1)] - p[max(0, x - 1)];
+            float gy = (float)down[x] - up[x];
+            silhouette[y * N + x] = fabsf(p[x] - background);
+            gradient[y * N + x] = sqrtf(gx * gx + gy * gy);
+        }
+    }
+    normalise_block(silhouette, N * N);
+    normalise_block(gradient, N * N);
+}
+
+static bool check_board(piece_recognizer& recognizer, const Mat& board){
+    if (board.empty() || board.type() != CV_8UC3 || board.size() != Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS)){
+        cerr << "Error: Piece recognizer expects a " << VISION_BOARD_PIXELS << "x" << VISION_BOARD_PIXELS << " BGR board" << endl;
+        return false;
+    }
+    recognizer.gray.create(board.size(), CV_8UC1);
+    return true;
+}
+
+bool calibrate_piece_recognizer(piece_recognizer& recognizer, const Mat& start_board){
+    recognizer.calibrated = false;
+    if (!check_board(recognizer, start_board)) return false;
+    cvtColor(start_board, recognizer.gray, COLOR_BGR2GRAY);
+    double empty_sum[2] = {0, 0};
+    int empty_count[2] = {0, 0};
+    for (int row = 2; row <= 5; row++)
+        for (int col = 0; col < 8; col++){
+            int shade = square_shade(row, col);
+            empty_sum[shade] += mean(recognizer.gray(square_roi(row, col)))[0];
+            empty_count[shade]++;
+        }
+    for (int shade = 0; shade < 2; shade++) recognizer.empty_gray[shade] = empty_sum[shade] / empty_count[shade];
+
+    for (int c = 0; c < 2; c++)
+        for (int t = 0; t <= KING; t++)
+            for (int shade = 0; shade < 2; shade++){
+                fill(recognizer.templates[c][t][shade].feature, recognizer.templates[c][t][shade].feature + PIECE_FEATURE_LENGTH, 0.0f);
+                recognizer.templates[c][t][shade].samples = 0;
+            }
+    const int piece_rows[4] = {0, 1, 6, 7};
+    float feature[PIECE_FEATURE_LENGTH];
+    for (int i = 0; i < 4; i++){
+        int row = piece_rows[i];
+        int c = colour_index(row <= 1 ? BLACK : WHITE);
+        for (int col = 0; col < 8; col++){
+            piece_type_t type = (row == 1 || row == 6) ? PAWN : BACK_RANK[col];
+            piece_template& tmpl = recognizer.templates[c][type][square_shade(row, col)];
+            square_feature(recognizer, start_board, row, col, feature);
+            for (int k = 0; k < PIECE_FEATURE_LENGTH; k++) tmpl.feature[k] += feature[k];
+            tmpl.samples++;
+        }
+    }
+    // Kings and queens start on one shade only; the other shade borrows that template,
+    // which the background-relative feature keeps usable
+    for (int c = 0; c < 2; c++)
+        for (int t = PAWN; t <= KING; t++)
+            for (int shade = 0; shade < 2; shade++){
+                piece_template& tmpl = recognizer.templates[c][t][shade];
+                if (tmpl.samples == 0) continue;
+                for (int k = 0; k < PIECE_FEATURE_LENGTH; k++) tmpl.feature[k] /= tmpl.samples;
+            }
+    for (int c = 0; c < 2; c++)
+        for (int t = PAWN; t <= KING; t++)
+            for (int shade = 0; shade < 2; shade++)
+                if (recognizer.templates[c][t][shade].samples == 0)
+                    recognizer.templates[c][t][shade] = recognizer.templates[c][t][1 - shade];
+    recognizer.calibrated = true;
+    return true;
+}
+
+// Correlation of a square feature with one template; both blocks are unit length, so the
+// dot product over both is twice their mean correlation
+static double template_score(const piece_template& tmpl, const float* feature){
+    double dot = 0;
+    for (int k = 0; k < PIECE_FEATURE_LENGTH; k++) dot += feature[k] * tmpl.feature[k];
+    return dot / 2;
+}
+
+bool piece_type_scores(piece_recognizer& recognizer, const Mat& board, int row, int col, color_t color, double scores[KING + 1]){
+    if (!recognizer.calibrated || color == COLOR_NONE || !check_board(recognizer, board)) return false;
+    float feature[PIECE_FEATURE_LENGTH];
+    square_feature(recognizer, board, row, col, feature);
+    scores[EMPTY] = -1;
+    for (int t = PAWN; t <= KING; t++)
+        scores[t] = template_score(recognizer.templates[colour_index(color)][t][square_shade(row, col)], feature);
+    return true;
+}
+
+piece_type_t recognize_piece(piece_recognizer& recognizer, const Mat& board, int row, int col, color_t color,
+                             const piece_type_t* candidates, int n_candidates, double* score, double* margin){
+    static const piece_type_t ALL_TYPES[6] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+    double scores[KING + 1];
+    if (!piece_type_scores(recognizer, board, row, col, color, scores)) return EMPTY;
+    if (!candidates){
+        candidates = ALL_TYPES;
+        n_candidates = 6;
+    }
+    piece_type_t best = EMPTY;
+    double best_score = -2, second_score = -2;
+    for (int i = 0; i < n_candidates; i++){
+        double s = scores[candidates[i]];
+        if (s > best_score){
+            second_score = best_score;
+            best_score = s;
+            best = candidates[i];
+        } else if (s > second_score){
+            second_score = s;
+        }
+    }
+    if (score) *score = best_score;
+    if (margin) *margin = n_candidates > 1 ? best_score - second_score : 1.0;
+    return best;
+}
+
+bool verify_move_identity(piece_recognizer& recognizer, const Mat& board, move_t* move, double* margin){
+    static const piece_type_t PROMOTIONS[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+    static const piece_type_t ALL_TYPES[6] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+    static const char PROMOTION_CHARS[KING + 1] = {0, 0, 'n', 'b', 'r', 'q', 0};
+    if (!move) return false;
+    color_t color = move->moved_piece.color;
+    if (move->is_promotion){
+        piece_type_t seen = recognize_piece(recognizer, board, move->to_row, move->to_col, color, PROMOTIONS, 4, NULL, margin);
+        if (seen == EMPTY) return false;
+        move->promotion_piece = PROMOTION_CHARS[seen];
+        move->notation[4] = PROMOTION_CHARS[seen];
+        move->notation[5] = '\0';
+        return true;
+    }
+    piece_type_t seen = recognize_piece(recognizer, board, move->to_row, move->to_col, color, ALL_TYPES, 6, NULL, margin);
+    return seen == move->moved_piece.type;
+}
@@ -0,0 +1,297 @@
+#include "vision/vision_pipeline.h"
+#include "common/constants.h"
+#include "game/move_validation.h"
+#include <chrono>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+enum { STAGE_CAPTURE = 0, STAGE_PREPROCESS, STAGE_DETECT, STAGE_OUTPUT };
+
+void frame_ring_push(frame_ring& ring, int frame, int* dropped){
+    *dropped = -1;
+    unsigned head = ring.head.load(memory_order_relaxed);
+    unsigned tail = ring.tail.load(memory_order_acquire);
+    if (head - tail == VISION_RING_CAPACITY){
+        // Full: take the oldest entry away from the consumer. If the consumer wins the race
+        // it has taken the entry itself and the slot is free either way.
+        int oldest = ring.slots[tail % VISION_RING_CAPACITY].load(memory_order_relaxed);
+        if (ring.tail.compare_exchange_strong(tail, tail + 1, memory_order_acq_rel)) *dropped = oldest;
+    }
+    ring.slots[head % VISION_RING_CAPACITY].store(frame, memory_order_relaxed);
+    ring.head.store(head + 1, memory_order_release);
+}
+
+bool frame_ring_pop(frame_ring& ring, int* frame){
+    unsigned tail = ring.tail.load(memory_order_acquire);
+    while (true){
+        unsigned head = ring.head.load(memory_order_acquire);
+        if (tail == head) return false;
+        int value = ring.slots[tail % VISION_RING_CAPACITY].load(memory_order_relaxed);
+        // A failed exchange means the producer dropped this entry; retry with the new tail
+        if (ring.tail.compare_exchange_weak(tail, tail + 1, memory_order_acq_rel)){
+            *frame = value;
+            return true;
+        }
+    }
+}
+
+static int acquire_frame(vision_pipeline& pipeline){
+    lock_guard<mutex> lock(pipeline.pool_mutex);
+    if (pipeline.free_count == 0) return -1;
+    return pipeline.free_frames[--pipeline.free_count];
+}
+
+static void release_frame(vision_pipeline& pipeline, int frame){
+    if (frame < 0) return;
+    lock_guard<mutex> lock(pipeline.pool_mutex);
+    pipeline.free_frames[pipeline.free_count++] = frame;
+}
+
+// Hand a frame to the next stage; a frame pushed out by drop-oldest goes back to the pool
+static void forward_frame(vision_pipeline& pipeline, frame_ring& ring, atomic<long>& ring_drops, int frame){
+    int dropped;
+    frame_ring_push(ring, frame, &dropped);
+    if (dropped >= 0){
+        release_frame(pipeline, dropped);
+        ring_drops++;
+        pipeline.stats.dropped++;
+    }
+}
+
+static long elapsed_us(int64_t start){
+    return (long)((getTickCount() - start) * 1e6 / getTickFrequency());
+}
+
+// Wait for the next frame; false once every upstream stage has finished and the ring is drained
+static bool next_frame(vision_pipeline& pipeline, frame_ring& ring, int stage, int* frame){
+    while (!pipeline.stop.load()){
+        bool upstream_done = pipeline.finished_stages.load() >= stage;
+        if (frame_ring_pop(ring, frame)) return true;
+        if (upstream_done) return false;
+        this_thread::sleep_for(chrono::microseconds(200));
+    }
+    return false;
+}
+
+static void capture_stage(vision_pipeline& pipeline){
+    int64_t sequence = 0;
+    while (!pipeline.stop.load()){
+        int index = acquire_frame(pipeline);
+        if (index < 0){
+            // Every buffer is still in flight downstream: drop at the source
+            if (!skip_camera_frame(pipeline.source)) break;
+            pipeline.stats.dropped_source++;
+            pipeline.stats.dropped++;
+            continue;
+        }
+        vision_frame& frame = pipeline.pool[index];
+        if (!read_camera_frame(pipeline.source, frame.raw)){
+            release_frame(pipeline, index);
+            break;
+        }
+        frame.sequence = sequence++;
+        frame.capture_ticks = getTickCount();
+        frame.has_move = false;
+        pipeline.stats.captured++;
+        forward_frame(pipeline, pipeline.to_preprocess, pipeline.stats.dropped_preprocess, index);
+    }
+    pipeline.finished_stages++;
+}
+
+static void preprocess_stage(vision_pipeline& pipeline){
+    int index;
+    while (next_frame(pipeline, pipeline.to_preprocess, STAGE_PREPROCESS, &index)){
+        vision_frame& frame = pipeline.pool[index];
+        bool ok;
+        if (pipeline.config.remap){
+            ok = warp_board_frame(*pipeline.config.remap, frame.raw, frame.board);
+        } else {
+            resize(frame.raw, frame.board, Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+            ok = true;
+        }
+        if (!ok){
+            release_frame(pipeline, index);
+            continue;
+        }
+        forward_frame(pipeline, pipeline.to_detect, pipeline.stats.dropped_detect, index);
+    }
+    pipeline.finished_stages++;
+}
+
+// Sampling rule of vision_annotation_config_t for the output stage
+static bool sample_output(vision_pipeline& pipeline, const move_vote_result& vote, long& offered){
+    const vision_annotation_config_t& config = pipeline.output;
+    offered++;
+    return (config.sample_every > 0 && offered % config.sample_every == 0) || vote.confidence < config.low_confidence;
+}
+
+// Only the detect thread writes these, so the worst case needs no compare-and-swap
+static void record_detect_latency(vision_pipeline& pipeline, int64_t start){
+    long us = elapsed_us(start);
+    pipeline.stats.detect_frames++;
+    pipeline.stats.detect_us += us;
+    if (us > pipeline.stats.detect_worst_us.load()) pipeline.stats.detect_worst_us.store(us);
+}
+
+static void detect_stage(vision_pipeline& pipeline){
+    int index;
+    bool reference_stale = true;
+    long offered = 0;
+    while (next_frame(pipeline, pipeline.to_detect, STAGE_DETECT, &index)){
+        int64_t start = getTickCount();
+        vision_frame& frame = pipeline.pool[index];
+        {
+            // Pick up a position handed over by the game loop
+            lock_guard<mutex> lock(pipeline.chess_mutex);
+            if (pipeline.has_pending_chess){
+                pipeline.chess = pipeline.pending_chess;
+                pipeline.has_pending_chess = false;
+                reference_stale = true;
+            }
+        }
+        if (pipeline.arm_in_view.load()){
+            // The arm hides and moves pieces: nothing seen now is a human move
+            pipeline.stats.arm_hidden++;
+            pipeline.voting = false;
+            reference_stale = true;
+            release_frame(pipeline, index);
+            record_detect_latency(pipeline, start);
+            continue;
+        }
+        frame.gate_state = update_frame_gate(pipeline.gate, frame.board);
+        bool settled = frame.gate_state == GATE_STABLE || frame.gate_state == GATE_IDLE;
+        if (settled && reference_stale){
+            // The first settled view after a position change is the new reference, not a move
+            set_move_detector_reference(pipeline.detector, frame.board);
+            set_frame_gate_reference(pipeline.gate);
+            reference_stale = false;
+            pipeline.voting = false;
+        } else if (frame.gate_state == GATE_STABLE){
+            pipeline.stats.stable++;
+            reset_move_vote(pipeline.vote);
+            pipeline.voting = true;
+        } else if (!settled){
+            // Motion or occlusion invalidates the frames voted so far
+            pipeline.voting = false;
+        }
+        if (settled && pipeline.voting){
+            pipeline.stats.voted++;
+            int64_t detect_start = getTickCount();
+            bool found = detect_legal_move(pipeline.detector, &pipeline.chess, frame.board, frame.match);
+            pipeline.stats.detector_us += elapsed_us(detect_start);
+            if (add_move_vote(pipeline.vote, found, frame.match, frame.capture_ticks, frame.vote)){
+                make_move(&pipeline.chess, frame.vote.match.move.notation);
+                set_move_detector_reference(pipeline.detector, frame.board);
+                set_frame_gate_reference(pipeline.gate);
+                pipeline.voting = false;
+                frame.has_move = true;
+                pipeline.stats.detected++;
+                if (pipeline.on_move) pipeline.on_move(frame.vote, frame.sequence);
+            }
+        }
+        if (frame.has_move && !pipeline.config.output_dir.empty() && sample_output(pipeline, frame.vote, offered)){
+            forward_frame(pipeline, pipeline.to_output, pipeline.stats.dropped_output, index);
+        } else {
+            release_frame(pipeline, index);
+        }
+        record_detect_latency(pipeline, start);
+    }
+    pipeline.finished_stages++;
+}
+
+static void output_stage(vision_pipeline& pipeline){
+    int index;
+    while (next_frame(pipeline, pipeline.to_output, STAGE_OUTPUT, &index)){
+        vision_frame& frame = pipeline.pool[index];
+        const move_t& move = frame.vote.match.move;
+        draw_move_annotation(frame.board, move.from_row, move.from_col, move.to_row, move.to_col);
+        char name[64];
+        // No extension, so the configured codec picks it
+        snprintf(name, sizeof(name), "/move_%06ld_%s", (long)frame.sequence, move.notation);
+        if (write_annotation_image(pipeline.output, pipeline.config.output_dir + name, frame.board)) pipeline.stats.written++;
+        release_frame(pipeline, index);
+    }
+    pipeline.finished_stages++;
+}
+
+static void reset_ring(frame_ring& ring){
+    ring.head.store(0);
+    ring.tail.store(0);
+    for (int i = 0; i < VISION_RING_CAPACITY; i++) ring.slots[i].store(-1);
+}
+
+bool start_vision_pipeline(vision_pipeline& pipeline, const vision_pipeline_config& config, const chess_state_t* chess, vision_move_callback on_move){
+    if (!chess) return false;
+    pipeline.config = config;
+    pipeline.output = config.output;
+    if (pipeline.output.queue_capacity <= 0){
+        pipeline.output.sample_every = 1;
+        pipeline.output.low_confidence = 0;
+        pipeline.output.codec = VISION_CODEC_JPEG;
+        pipeline.output.quality = -1;
+    }
+    pipeline.on_move = on_move;
+    if (!open_camera_source(pipeline.source, config.source)) return false;
+    for (int i = 0; i < VISION_POOL_SIZE; i++) pipeline.free_frames[i] = i;
+    pipeline.free_count = VISION_POOL_SIZE;
+    reset_ring(pipeline.to_preprocess);
+    reset_ring(pipeline.to_detect);
+    reset_ring(pipeline.to_output);
+    init_frame_gate(pipeline.gate, config.gate.thumb_size > 0 ? &config.gate : NULL);
+    init_move_detector(pipeline.detector);
+    init_move_vote(pipeline.vote, config.vote.window > 0 ? &config.vote : NULL);
+    pipeline.voting = false;
+    pipeline.chess = *chess;
+    pipeline.has_pending_chess = false;
+    pipeline.arm_in_view.store(false);
+    pipeline.stop.store(false);
+    pipeline.finished_stages.store(0);
+    pipeline.stats.captured = 0;
+    pipeline.stats.dropped = 0;
+    pipeline.stats.dropped_source = 0;
+    pipeline.stats.dropped_preprocess = 0;
+    pipeline.stats.dropped_detect = 0;
+    pipeline.stats.dropped_output = 0;
+    pipeline.stats.arm_hidden = 0;
+    pipeline.stats.stable = 0;
+    pipeline.stats.voted = 0;
+    pipeline.stats.detected = 0;
+    pipeline.stats.written = 0;
+    pipeline.stats.detect_frames = 0;
+    pipeline.stats.detect_us = 0;
+    pipeline.stats.detect_worst_us = 0;
+    pipeline.stats.detector_us = 0;
+    pipeline.threads[STAGE_CAPTURE] = thread(capture_stage, ref(pipeline));
+    pipeline.threads[STAGE_PREPROCESS] = thread(preprocess_stage, ref(pipeline));
+    pipeline.threads[STAGE_DETECT] = thread(detect_stage, ref(pipeline));
+    pipeline.threads[STAGE_OUTPUT] = thread(output_stage, ref(pipeline));
+    return true;
+}
+
+void set_vision_pipeline_position(vision_pipeline& pipeline, const chess_state_t* chess){
+    if (!chess) return;
+    lock_guard<mutex> lock(pipeline.chess_mutex);
+    pipeline.pending_chess = *chess;
+    pipeline.has_pending_chess = true;
+}
+
+void set_vision_pipeline_arm_in_view(vision_pipeline& pipeline, bool in_view){
+    pipeline.arm_in_view.store(in_view);
+}
+
+void vision_pipeline_arm_view(void* context, bool in_view){
+    set_vision_pipeline_arm_in_view(*static_cast<vision_pipeline*>(context), in_view);
+}
+
+void wait_vision_pipeline(vision_pipeline& pipeline){
+    for (int i = 0; i < 4; i++)
+        if (pipeline.threads[i].joinable()) pipeline.threads[i].join();
+    close_camera_source(pipeline.source);
+}
+
+void stop_vision_pipeline(vision_pipeline& pipeline){
+    pipeline.stop.store(true);
+    wait_vision_pipeline(pipeline);
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "vision/vision_wrapper.h"
+#include "common/constants.h"
+#include "vision/annotation_writer.h"
+#include "vision/board_detector.h"
+#include "vision/board_reconciler.h"
+#include "vision/move_detector.h"
+#include "vision/occupancy_classifier.h"
+#include "vision/piece_recognizer.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+struct vision_detector {
+    move_detector_context ctx;
+    board_calibration calib;
+    bool has_calib;
+    board_remap remap;
+    bool has_remap;
+    Mat board;
+    piece_recognizer pieces;
+    occupancy_classifier occupancy;
+    annotation_writer writer;
+    vision_annotation_config_t annotation;
+    bool has_annotation_config;
+};
+
+// Bring a camera image or board photo to the detector's rectified board size
+static bool to_board(vision_detector_t *detector, const Mat& image){
+    if (detector->has_calib){
+        if (!detector->has_remap || detector->remap.frame_size != image.size()){
+            if (!build_board_remap(detector->calib, image.size(), VISION_BOARD_PIXELS, detector->remap)) return false;
+            detector->has_remap = true;
+        }
+        return warp_board_frame(detector->remap, image, detector->board);
+    }
+    resize(image, detector->board, Size(VISION_BOARD_PIXELS, VISION_BOARD_PIXELS));
+    return true;
+}
+
+static vision_detection_t no_detection(void){
+    vision_detection_t result;
+    memset(&result, 0, sizeof(result));
+    return result;
+}
+
+vision_detector_t *vision_create_detector(const char *calibration_path){
+    vision_detector_t *detector = new vision_detector_t;
+    detector->has_calib = false;
+    detector->has_remap = false;
+    if (calibration_path){
+        if (!load_board_calibration(calibration_path, detector->calib)){
+            delete detector;
+            return NULL;
+        }
+        detector->has_calib = true;
+    }
+    init_move_detector(detector->ctx);
+    detector->pieces.calibrated = false;
+    detector->occupancy.calibrated = false;
+    detector->writer.running = false;
+    detector->has_annotation_config = false;
+    return detector;
+}
+
+void vision_destroy_detector(vision_detector_t *detector){
+    if (!detector) return;
+    stop_annotation_writer(detector->writer);
+    delete detector;
+}
+
+void vision_set_annotation_config(vision_detector_t *detector, const vision_annotation_config_t *config){
+    if (!detector) return;
+    detector->has_annotation_config = config != NULL;
+    if (config) detector->annotation = *config;
+    // Drains what is queued under the old settings; the next annotated detection restarts it
+    stop_annotation_writer(detector->writer);
+}
+
+bool vision_set_reference(vision_detector_t *detector, const unsigned char *bgr, int width, int height, size_t stride){
+    if (!detector || !bgr) return false;
+    Mat image(height, width, CV_8UC3, (void*)bgr, stride);
+    return to_board(detector, image) && set_move_detector_reference(detector->ctx, detector->board);
+}
+
+bool vision_set_reference_image(vision_detector_t *detector, const char *image_path){
+    if (!detector || !image_path) return false;
+    Mat image = imread(image_path);
+    if (image.empty()){
+        cerr << "Error: Could not open or find " << image_path << endl;
+        return false;
+    }
+    return vision_set_reference(detector, image.ptr(), image.cols, image.rows, image.step);
+}
+
+bool vision_calibrate_pieces(vision_detector_t *detector, const char *start_image_path){
+    if (!detector || !start_image_path) return false;
+    Mat image = imread(start_image_path);
+    if (image.empty()){
+        cerr << "Error: Could not open or find " << start_image_path << endl;
+        return false;
+    }
+    if (!to_board(detector, image) || !calibrate_piece_recognizer(detector->pieces, detector->board)) return false;
+    detector->ctx.pieces = &detector->pieces;
+    if (!calibrate_occupancy_classifier(detector->occupancy, detector->board)) return false;
+    detector->ctx.occupancy = &detector->occupancy;
+    return true;
+}
+
+bool vision_reconcile_image(vision_detector_t *detector, const char *image_path, const chess_state_t *last_known,
+                            color_t turn, chess_state_t *out, char *fen, size_t fen_size){
+    if (!detector || !image_path || !out || !detector->occupancy.calibrated) return false;
+    Mat image = imread(image_path);
+    if (image.empty()){
+        cerr << "Error: Could not open or find " << image_path << endl;
+        return false;
+    }
+    if (!to_board(detector, image)) return false;
+    reconcile_report report;
+    piece_recognizer* pieces = detector->pieces.calibrated ? &detector->pieces : NULL;
+    if (!reconcile_board_state(detector->occupancy, pieces, detector->board, last_known, turn, out, &report)) return false;
+    if (fen && fen_size > 0) snprintf(fen, fen_size, "%s", report.fen);
+    return true;
+}
+
+vision_detection_t vision_detect(vision_detector_t *detector, const chess_state_t *chess, const unsigned char *bgr, int width, int height, size_t stride, const char *annotate_path){
+    if (!detector || !bgr) return no_detection();
+    Mat image(height, width, CV_8UC3, (void*)bgr, stride);
+    if (!to_board(detector, image)) return no_detection();
+    if (!annotate_path) return detect(detector->ctx, chess, detector->board);
+    // The writer thread is only started once a caller asks for annotation
+    if (!detector->writer.running) start_annotation_writer(detector->writer, detector->has_annotation_config ? &detector->annotation : NULL);
+    return detect(detector->ctx, chess, detector->board, &detector->writer, annotate_path);
+}
+
+vision_detection_t vision_detect_image(vision_detector_t *detector, const chess_state_t *chess, const char *image_path, const char *annotate_path){
+    if (!detector || !image_path) return no_detection();
+    Mat image = imread(image_path);
+    if (image.empty()){
+        cerr << "Error: Could not open or find " << image_path << endl;
+        return no_detection();
+    }
+    return vision_detect(detector, chess, image.ptr(), image.cols, image.rows, image.step, annotate_path);
+}
+
+bool vision_annotation_path(vision_detector_t *detector, const char *annotate_path, char *out, size_t out_size){
+    if (!detector || !annotate_path || !out || out_size == 0) return false;
+    // Without a configuration the writer uses JPEG, the zero codec
+    vision_annotation_config_t config = detector->has_annotation_config ? detector->annotation : vision_annotation_config_t();
+    string path = annotation_image_path(config, annotate_path);
+    if (path.size() >= out_size) return false;
+    snprintf(out, out_size, "%s", path.c_str());
+    return true;
+}